@@ -109,6 +109,56 @@ void loadIdx(ap_uint<t_MemBits>* p_memPtr,
     }
 }
 
+/**
+ * @brief decodeIdx expands the row or col index blocks of a channel partition into an index stream
+ *
+ * A block holds t_MemBits / p_deltaBits signed deltas packed from the least significant bit, each delta is added to
+ * the previous index of the channel partition and the first one to 0. p_deltaBits == 0 selects blocks of
+ * t_MemBits / t_IndexBits plain indices. The encoding of each channel partition is chosen by the host partitioner,
+ * see SpmIdxType in L2/sparse/include/sw/fp64/matrix_params.hpp.
+ *
+ * @tparam t_IndexType index type
+ * @tparam t_MemBits number of bits of a memory block
+ * @tparam t_IndexBits number of bits of an index
+ *
+ * @param p_idxs number of indices of the channel partition
+ * @param p_deltaBits 2, 4 or 8 bits per delta, 0 for plain indices
+ * @param p_wideIdxStr input stream of index blocks
+ * @param p_idxStr output stream of p_idxs indices
+ */
+template <typename t_IndexType, unsigned int t_MemBits, unsigned int t_IndexBits>
+void decodeIdx(const uint32_t p_idxs,
+               const uint32_t p_deltaBits,
+               hls::stream<ap_uint<t_MemBits> >& p_wideIdxStr,
+               hls::stream<ap_uint<t_IndexBits> >& p_idxStr) {
+#ifndef __SYNTHESIS__
+    assert((p_deltaBits == 0) || (p_deltaBits == 2) || (p_deltaBits == 4) || (p_deltaBits == 8));
+#endif
+    const uint32_t l_bits = (p_deltaBits == 0) ? t_IndexBits : p_deltaBits;
+    const uint32_t l_bkIdxs = t_MemBits / l_bits;
+    const ap_uint<t_IndexBits> l_mask = (1 << l_bits) - 1;
+    ap_uint<t_MemBits> l_bk = 0;
+    t_IndexType l_idx = 0;
+    uint32_t l_pos = 0;
+    for (unsigned int i = 0; i < p_idxs; ++i) {
+#pragma HLS PIPELINE
+        if (l_pos == 0) {
+            l_bk = p_wideIdxStr.read();
+        }
+        ap_uint<t_IndexBits> l_field = l_bk.range(t_IndexBits - 1, 0) & l_mask;
+        l_bk = l_bk >> l_bits;
+        if (p_deltaBits == 0) {
+            l_idx = l_field;
+        } else if (l_field[l_bits - 1]) {
+            l_idx = l_idx + l_field - (1 << l_bits);
+        } else {
+            l_idx = l_idx + l_field;
+        }
+        p_idxStr.write(l_idx);
+        l_pos = (l_pos == l_bkIdxs - 1) ? 0 : l_pos + 1;
+    }
+}
+
 template <unsigned int t_MemChannels, unsigned int t_IndexBits>
 void fwdIdx(hls::stream<uint32_t>& p_paramStr,
             hls::stream<ap_uint<t_IndexBits> >& p_in4MultCompStr,
@@ -0,0 +1,43 @@
+#
+# Copyright 2019-2021 Xilinx, Inc.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+source settings.tcl
+
+set PROJ "prj_decodeIdx.prj"
+set SOLN "sol"
+set CFLAGS "-std=c++11 -I${XF_PROJ_ROOT}/L1/sparse/include/hw -I${XF_PROJ_ROOT}/L1/blas/include/hw"
+set TBFLAGS "${CFLAGS} -I${XF_PROJ_ROOT}/L2/sparse/include/sw/fp64 -I${XF_PROJ_ROOT}/utils/include/sw"
+
+open_project -reset $PROJ
+
+add_files "uut_top.cpp" -cflags "${CFLAGS}"
+add_files -tb "test.cpp" -cflags "${TBFLAGS}"
+set_top uut_top
+
+open_solution -reset $SOLN
+
+set_part $XPART
+create_clock -period 3.33
+
+if {$CSIM == 1} {
+  csim_design
+}
+
+if {$CSYNTH == 1} {
+  csynth_design
+}
+
+exit
@@ -0,0 +1,118 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * @file test.cpp
+ * @brief csim testbench of decodeIdx, the index blocks are packed by NnzStore of the host partitioner
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "matrix_params.hpp"
+#include "uut_top.hpp"
+
+using namespace xf::sparse;
+
+// p_idxs indices with consecutive differences that fit p_deltaBits signed bits, any 16-bit index for 0
+std::vector<int32_t> genIdxs(uint32_t p_idxs, uint32_t p_deltaBits, std::mt19937& p_gen) {
+    std::vector<int32_t> l_idxs(p_idxs);
+    if (p_deltaBits == 0) {
+        std::uniform_int_distribution<int32_t> l_dist(0, (1 << SPARSE_indexBits) - 1);
+        for (auto& l_idx : l_idxs) l_idx = l_dist(p_gen);
+        return l_idxs;
+    }
+    std::uniform_int_distribution<int32_t> l_dist(-(1 << (p_deltaBits - 1)), (1 << (p_deltaBits - 1)) - 1);
+    int32_t l_prev = 0;
+    for (auto& l_idx : l_idxs) {
+        l_idx = l_prev + l_dist(p_gen);
+        if (l_idx < 0) l_idx = l_prev;
+        l_prev = l_idx;
+    }
+    return l_idxs;
+}
+
+// packs the indices into the blocks of one channel the way the partitioner does, the unused entries of the last
+// block repeat the last index, i.e. their deltas are 0
+std::vector<uint8_t, alignedAllocator<uint8_t> > packIdxs(const std::vector<int32_t>& p_idxs, uint32_t p_deltaBits) {
+    NnzStore l_store(SPARSE_memBits, 4, 8, 1);
+    const uint32_t l_bkIdxs = SPARSE_memBits / ((p_deltaBits == 0) ? SPARSE_indexBits : p_deltaBits);
+    std::vector<uint32_t> l_idxArr(l_bkIdxs);
+    std::vector<int32_t> l_deltaArr(l_bkIdxs);
+    int32_t l_prev = 0;
+    for (uint32_t i = 0; i < p_idxs.size(); i += l_bkIdxs) {
+        for (uint32_t j = 0; j < l_bkIdxs; ++j) {
+            int32_t l_idx = (i + j < p_idxs.size()) ? p_idxs[i + j] : l_prev;
+            l_idxArr[j] = (i + j < p_idxs.size()) ? l_idx : 0;
+            l_deltaArr[j] = l_idx - l_prev;
+            l_prev = l_idx;
+        }
+        if (p_deltaBits == 0) {
+            l_store.add_idxArr(0, l_idxArr.data());
+        } else {
+            l_store.add_deltaArr(0, l_deltaArr.data(), p_deltaBits);
+        }
+    }
+    return l_store.m_buf[0];
+}
+
+int main() {
+    std::mt19937 l_gen(17);
+    int l_errs = 0;
+    for (uint32_t l_deltaBits : {0, 2, 4, 8}) {
+        for (uint32_t l_numIdxs : {1, 255, 256, 1000}) {
+            std::vector<int32_t> l_idxs = genIdxs(l_numIdxs, l_deltaBits, l_gen);
+            std::vector<uint8_t, alignedAllocator<uint8_t> > l_buf = packIdxs(l_idxs, l_deltaBits);
+
+            hls::stream<ap_uint<SPARSE_memBits> > l_wideIdxStr;
+            hls::stream<ap_uint<SPARSE_indexBits> > l_idxStr;
+            const uint32_t l_memBytes = SPARSE_memBits / 8;
+            for (uint32_t b = 0; b < l_buf.size(); b += l_memBytes) {
+                ap_uint<SPARSE_memBits> l_bk = 0;
+                for (uint32_t k = 0; k < l_memBytes; ++k) {
+                    l_bk.range(8 * k + 7, 8 * k) = l_buf[b + k];
+                }
+                l_wideIdxStr.write(l_bk);
+            }
+            uut_top(l_numIdxs, l_deltaBits, l_wideIdxStr, l_idxStr);
+
+            int l_caseErrs = 0;
+            for (uint32_t i = 0; i < l_numIdxs; ++i) {
+                uint32_t l_idx = l_idxStr.read();
+                if (l_idx != (uint32_t)l_idxs[i]) {
+                    if (l_caseErrs < 8) {
+                        std::cout << "ERROR: " << l_deltaBits << "-bit deltas, " << l_numIdxs << " indices, index "
+                                  << i << " is " << l_idx << ", expected " << l_idxs[i] << std::endl;
+                    }
+                    l_caseErrs++;
+                }
+            }
+            if (!l_wideIdxStr.empty() || !l_idxStr.empty()) {
+                std::cout << "ERROR: " << l_deltaBits << "-bit deltas, " << l_numIdxs << " indices, streams are not "
+                          << "consumed" << std::endl;
+                l_caseErrs++;
+            }
+            l_errs += l_caseErrs;
+        }
+    }
+    if (l_errs != 0) {
+        std::cout << "Test failed with " << l_errs << " mismatches." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout << "Test pass!" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,26 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "xf_sparse_fp64.hpp"
+#include "uut_top.hpp"
+
+void uut_top(const uint32_t p_idxs,
+             const uint32_t p_deltaBits,
+             hls::stream<ap_uint<SPARSE_memBits> >& p_wideIdxStr,
+             hls::stream<ap_uint<SPARSE_indexBits> >& p_idxStr) {
+    xf::sparse::decodeIdx<SPARSE_indexType, SPARSE_memBits, SPARSE_indexBits>(p_idxs, p_deltaBits, p_wideIdxStr,
+                                                                              p_idxStr);
+}
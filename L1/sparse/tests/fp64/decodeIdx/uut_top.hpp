@@ -0,0 +1,34 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef UUT_TOP_HPP
+#define UUT_TOP_HPP
+
+#include <cstdint>
+#include "ap_int.h"
+#include "hls_stream.h"
+
+#define SPARSE_memBits 256
+#define SPARSE_indexBits 16
+
+typedef uint16_t SPARSE_indexType;
+
+void uut_top(const uint32_t p_idxs,
+             const uint32_t p_deltaBits,
+             hls::stream<ap_uint<SPARSE_memBits> >& p_wideIdxStr,
+             hls::stream<ap_uint<SPARSE_indexBits> >& p_idxStr);
+
+#endif
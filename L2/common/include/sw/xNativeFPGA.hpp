@@ -64,6 +64,9 @@ class KERNEL {
     void createKernel(const std::string& name);
     void* createBO(const int p_argIdx, const size_t p_bytes);
     void createBOfromHostPtr(const int p_argIdx, const size_t p_bytes, void* p_hostPtr); //p_hostPtr must be 4K aligned
+    // BOs of argument p_argIdx kept under key p_boId, so that several BOs can be bound to the same argument in turn
+    void* createBO(const int p_argIdx, const int p_boId, const size_t p_bytes);
+    void setMemArg(const int p_argIdx, const int p_boId);
     void sendBO(const int p_argIdx);
     void setMemArg(const int p_argIdx);
     template <typename t_Type>
@@ -71,13 +74,25 @@ class KERNEL {
     void run();
     void wait();
     void getBO(const int p_argIdx);
+    void readBO(const int p_boId); // no wait, the run that wrote the BO must have completed
     void clearBOMap();
+    // async mode, p_numRuns runs with their own arguments that can be queued on the kernel at the same time,
+    // run(p_runId) returns at once and wait(p_runId) blocks until that run has completed
+    void createRuns(const unsigned int p_numRuns);
+    void setMemArg(const int p_argIdx, const int p_boId, const unsigned int p_runId);
+    template <typename t_Type>
+    void setScalarArg(const int p_argIdx, t_Type p_argVal, const unsigned int p_runId);
+    void run(const unsigned int p_runId);
+    void wait(const unsigned int p_runId);
 
    protected:
+    xrt::run& getRun(const unsigned int p_runId);
+
     FPGA* m_fpga;
     xrt::kernel m_kernel;
-    std::map<const int, xrt::bo> m_bos; // map arg index to bo
+    std::map<const int, xrt::bo> m_bos; // map arg index or BO id to bo, a new BO replaces the one of the same key
     xrt::run m_run;
+    std::vector<xrt::run> m_runs;
 };
 }
 }
@@ -58,7 +58,14 @@ void KERNEL::createKernel(const std::string& name) {
 
 void* KERNEL::createBO(const int p_argIdx, const size_t p_bytes) {
     xrt::bo l_bo = xrt::bo(m_fpga->getDevice(), p_bytes, m_kernel.group_id(p_argIdx));
-    m_bos.insert({p_argIdx, l_bo});
+    m_bos[p_argIdx] = l_bo;
+    void* l_mem = l_bo.map<void*>();
+    return l_mem;
+}
+
+void* KERNEL::createBO(const int p_argIdx, const int p_boId, const size_t p_bytes) {
+    xrt::bo l_bo = xrt::bo(m_fpga->getDevice(), p_bytes, m_kernel.group_id(p_argIdx));
+    m_bos[p_boId] = l_bo;
     void* l_mem = l_bo.map<void*>();
     return l_mem;
 }
@@ -66,7 +73,7 @@ void* KERNEL::createBO(const int p_argIdx, const size_t p_bytes) {
 //p_hostPtr must be 4K aligned
 void KERNEL::createBOfromHostPtr(const int p_argIdx, const size_t p_bytes, void* p_hostPtr) {
     xrt::bo l_bo = xrt::bo(m_fpga->getDevice(), p_hostPtr, p_bytes, m_kernel.group_id(p_argIdx));
-    m_bos.insert({p_argIdx, l_bo});
+    m_bos[p_argIdx] = l_bo;
 }
 
 void KERNEL::sendBO(const int p_argIdx) {
@@ -83,6 +90,15 @@ void KERNEL::setMemArg(const int p_argIdx) {
     }
 }
 
+void KERNEL::setMemArg(const int p_argIdx, const int p_boId) {
+    if (m_bos.find(p_boId) != m_bos.end()) {
+        xrt::bo l_bo = m_bos.find(p_boId)->second;
+        m_run.set_arg(p_argIdx, l_bo);
+    } else {
+        throw xilinx_apps::hpc_common::xNativeFPGAInvalidValue("could not find the BO");
+    }
+}
+
 template <typename t_Type>
 void KERNEL::setScalarArg(const int p_argIdx, t_Type p_argVal) {
     m_run.set_arg(p_argIdx, p_argVal);
@@ -103,6 +119,15 @@ void KERNEL::getBO(const int p_argIdx) {
     }
 }
 
+void KERNEL::readBO(const int p_boId) {
+    if (m_bos.find(p_boId) != m_bos.end()) {
+        xrt::bo l_bo = m_bos.find(p_boId)->second;
+        l_bo.sync(XCL_BO_SYNC_BO_FROM_DEVICE);
+    } else {
+        throw xilinx_apps::hpc_common::xNativeFPGAInvalidValue("could not find the BO");
+    }
+}
+
 void KERNEL::wait() {
     auto state = m_run.wait();
     //std::cout << "state " << state << std::endl;
@@ -112,6 +137,43 @@ void KERNEL::clearBOMap() {
     m_bos.clear();
 }
 
+void KERNEL::createRuns(const unsigned int p_numRuns) {
+    m_runs.clear();
+    for (unsigned int i = 0; i < p_numRuns; ++i) {
+        m_runs.push_back(xrt::run(m_kernel));
+    }
+}
+
+xrt::run& KERNEL::getRun(const unsigned int p_runId) {
+    if (p_runId >= m_runs.size()) {
+        throw xilinx_apps::hpc_common::xNativeFPGAInvalidValue("could not find the run");
+    }
+    return m_runs[p_runId];
+}
+
+void KERNEL::setMemArg(const int p_argIdx, const int p_boId, const unsigned int p_runId) {
+    if (m_bos.find(p_boId) != m_bos.end()) {
+        xrt::bo l_bo = m_bos.find(p_boId)->second;
+        getRun(p_runId).set_arg(p_argIdx, l_bo);
+    } else {
+        throw xilinx_apps::hpc_common::xNativeFPGAInvalidValue("could not find the BO");
+    }
+}
+
+template <typename t_Type>
+void KERNEL::setScalarArg(const int p_argIdx, t_Type p_argVal, const unsigned int p_runId) {
+    getRun(p_runId).set_arg(p_argIdx, p_argVal);
+}
+
+void KERNEL::run(const unsigned int p_runId) {
+    getRun(p_runId).start();
+}
+
+void KERNEL::wait(const unsigned int p_runId) {
+    getRun(p_runId).wait();
+}
+
 template void KERNEL::setScalarArg<unsigned int>(const int, unsigned int);
+template void KERNEL::setScalarArg<unsigned int>(const int, unsigned int, const unsigned int);
 }
 }
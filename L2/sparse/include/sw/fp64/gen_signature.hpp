@@ -17,6 +17,8 @@
 #define GEN_SIGNATURE_HPP_
 
 #include <string>
+#include <cstdio>
+#include <utility>
 #include "matrix_params.hpp"
 #include "signature.hpp"
 
@@ -26,6 +28,56 @@ namespace sparse {
 CooMatInfo loadMatInfo(std::string path);
 void storeMatPar(std::string path, MatPartition& p_matPar);
 
+// Signature container file, all little endian:
+//   SigFileHeader, followed by m_sections SigFileSection entries (rbParam, parParam, nnzVal_0 .. nnzVal_<channels-1>
+//   and optional extra sections, e.g. the scatter map of a signature cache file)
+//   each section starts at a multiple of SIG_FILE_ALIGN, so that a mapped section can be used as a host buffer
+// m_headerCrc covers the header, with m_headerCrc set to 0, and the section table. All CRCs are the zlib CRC-32.
+#define SIG_FILE_MAGIC "XSPMSIG"
+#define SIG_FILE_VERSION 1
+#define SIG_FILE_ALIGN 4096
+
+struct SigFileSection {
+    uint64_t m_offset;
+    uint64_t m_bytes;
+    uint32_t m_crc;
+    uint32_t m_reserved;
+};
+
+struct SigFileHeader {
+    char m_magic[8];
+    uint32_t m_version;
+    uint32_t m_headerBytes; // bytes before the first section
+    uint32_t m_parEntries, m_accLatency, m_channels, m_maxRows, m_maxCols, m_memBits;
+    uint64_t m_m, m_n, m_nnz, m_mPad, m_nPad, m_nnzPad;
+    uint32_t m_sections;
+    uint32_t m_headerCrc;
+};
+static_assert(sizeof(SigFileSection) == 24, "unexpected SigFileSection layout");
+static_assert(sizeof(SigFileHeader) == 96, "unexpected SigFileHeader layout");
+
+typedef std::vector<std::pair<void*, size_t> > SigFileSections;
+
+uint32_t crc32(const void* p_buf, size_t p_bytes, uint32_t p_crc = 0);
+// 64-bit hash used as signature cache key, not suitable for cryptographic use
+uint64_t hash64(const void* p_buf, size_t p_bytes, uint64_t p_hash = 0);
+// p_extraSections are appended after the nnz channels
+void storeMatParFile(std::string filename,
+                     MatPartition& p_matPar,
+                     const SigFileSections& p_extraSections = SigFileSections());
+// the returned partition points into p_file, an SpmInvalidValue is thrown if the file is damaged or was generated
+// with different Signature parameters, section CRCs are only checked when p_verify is true. Extra sections are
+// returned in p_extraSections when it is not nullptr.
+MatPartition loadMatParFile(MappedBinFile& p_file,
+                            uint32_t p_parEntries,
+                            uint32_t p_accLatency,
+                            uint32_t p_channels,
+                            uint32_t p_maxRows,
+                            uint32_t p_maxCols,
+                            uint32_t p_memBits,
+                            bool p_verify = true,
+                            SigFileSections* p_extraSections = nullptr);
+
 template <typename t_DataType>
 class SpmPar {
    public:
@@ -34,83 +86,283 @@ class SpmPar {
            unsigned int t_HbmChannels,
            unsigned int t_MaxRows,
            unsigned int t_MaxCols,
-           unsigned int t_HbmMemBits) {
-        m_sig.init(t_ParEntries, t_AccLatency, t_HbmChannels, t_MaxRows, t_MaxCols, t_HbmMemBits);
+           unsigned int t_HbmMemBits,
+           ChParStrategy p_chParStrategy = CHPAR_EVEN_SPLIT) {
+        m_sig.init(t_ParEntries, t_AccLatency, t_HbmChannels, t_MaxRows, t_MaxCols, t_HbmMemBits, p_chParStrategy);
+        m_parEntries = t_ParEntries;
+        m_accLatency = t_AccLatency;
+        m_channels = t_HbmChannels;
+        m_maxRows = t_MaxRows;
+        m_maxCols = t_MaxCols;
+        m_memBits = t_HbmMemBits;
     }
 
     MatPartition partitionCooMat(
-        const uint32_t p_m, const uint32_t p_n, const uint32_t p_nnz, const uint32_t* p_rowIdx, const uint32_t* p_colIdx, const t_DataType* p_data, const int storeType) {
+        const uint32_t p_m, const uint32_t p_n, const uint64_t p_nnz, const uint32_t* p_rowIdx, const uint32_t* p_colIdx, const t_DataType* p_data, const int storeType) {
         SparseMatrix l_spm;
         l_spm.loadCoo(p_m, p_n, p_nnz, p_rowIdx, p_colIdx, storeType);
         MatPartition l_res = m_sig.gen_sig(l_spm, p_data);
         return l_res;
     }
+    // out-of-core partitioning, the signature files are written into p_path in batches of row blocks that fit into
+    // p_memBudget bytes, see Signature::gen_sigToFiles
+    MatPartition partitionCooMatToFiles(const uint32_t p_m,
+                                        const uint32_t p_n,
+                                        const uint64_t p_nnz,
+                                        const uint32_t* p_rowIdx,
+                                        const uint32_t* p_colIdx,
+                                        const t_DataType* p_data,
+                                        const int storeType,
+                                        std::string p_path,
+                                        size_t p_memBudget) {
+        SparseMatrix l_spm;
+        l_spm.loadCoo(p_m, p_n, p_nnz, p_rowIdx, p_colIdx, storeType);
+        MatPartition l_res = m_sig.gen_sigToFiles(l_spm, p_data, p_path, p_memBudget);
+        return l_res;
+    }
+    // CSR input, the row order of the entries is used as is
+    template <typename t_IdxType>
+    MatPartition partitionCsrMat(const uint32_t p_m,
+                                 const uint32_t p_n,
+                                 const uint64_t p_nnz,
+                                 const t_IdxType* p_rowPtr,
+                                 const t_IdxType* p_colIdx,
+                                 const t_DataType* p_data,
+                                 const int storeType) {
+        SparseMatrix l_spm;
+        l_spm.loadCsr(p_m, p_n, p_nnz, p_rowPtr, p_colIdx, storeType);
+        MatPartition l_res = m_sig.gen_sig(l_spm, p_data);
+        return l_res;
+    }
+    // CSC input, the entries are put into row order with one counting pass
+    template <typename t_IdxType>
+    MatPartition partitionCscMat(const uint32_t p_m,
+                                 const uint32_t p_n,
+                                 const uint64_t p_nnz,
+                                 const t_IdxType* p_rowIdx,
+                                 const t_IdxType* p_colPtr,
+                                 const t_DataType* p_data,
+                                 const int storeType) {
+        SparseMatrix l_spm;
+        l_spm.loadCsc(p_m, p_n, p_nnz, p_rowIdx, p_colPtr, storeType);
+        MatPartition l_res = m_sig.gen_sig(l_spm, p_data);
+        return l_res;
+    }
+    // symmetric matrix given by one triangle in CSC format, p_nnz is the number of nnzs of the full matrix and
+    // p_data holds the values of the given triangle only, mirrored entries are never materialised
     template <typename t_IdxType>
     MatPartition partitionCscSymMat(
-        const uint32_t p_dim, const uint32_t p_nnz, const t_IdxType* p_rowIdx, const t_IdxType* p_colPtr, const t_DataType* p_data, const int storeType) {
-        std::vector<t_DataType> l_cooDat = this->getCooDatFromCscSym(p_dim, p_nnz, p_rowIdx, p_colPtr, p_data, storeType);
+        const uint32_t p_dim, const uint64_t p_nnz, const t_IdxType* p_rowIdx, const t_IdxType* p_colPtr, const t_DataType* p_data, const int storeType) {
         SparseMatrix l_spm;
-        l_spm.loadCscSym(p_dim, p_nnz, p_rowIdx, p_colPtr, storeType);
-        MatPartition l_res = m_sig.gen_sig(l_spm, l_cooDat.data());
+        l_spm.loadCscSymHalf(p_dim, p_nnz, p_rowIdx, p_colPtr, storeType);
+        MatPartition l_res = m_sig.gen_sig(l_spm, p_data);
+        return l_res;
+    }
+    // partitionCooMat with a signature cache in directory p_cacheDir, the cache file is keyed by a hash of the
+    // sparsity pattern and the partition parameters. On a hit the layout and the scatter map are loaded from the
+    // cache file and only the values are updated, on a miss the matrix is partitioned and the cache file written.
+    MatPartition partitionCooMatCached(const uint32_t p_m,
+                                       const uint32_t p_n,
+                                       const uint64_t p_nnz,
+                                       const uint32_t* p_rowIdx,
+                                       const uint32_t* p_colIdx,
+                                       const t_DataType* p_data,
+                                       const int storeType,
+                                       std::string p_cacheDir) {
+        uint64_t l_key = getCacheKey(0, p_m, p_n, p_nnz, storeType);
+        l_key = hash64(p_rowIdx, sizeof(uint32_t) * (size_t)p_nnz, l_key);
+        l_key = hash64(p_colIdx, sizeof(uint32_t) * (size_t)p_nnz, l_key);
+        std::string l_cacheFile = getCacheFileName(p_cacheDir, l_key);
+        m_cacheWarning.clear();
+        if (loadSigCache(l_cacheFile, p_m, p_n, p_nnz)) {
+            m_cacheHit = true;
+            return m_sig.update_sig(p_data);
+        }
+        m_cacheHit = false;
+        MatPartition l_res = partitionCooMat(p_m, p_n, p_nnz, p_rowIdx, p_colIdx, p_data, storeType);
+        storeSigCache(l_cacheFile, l_res);
+        return l_res;
+    }
+    // partitionCscSymMat with a signature cache, see partitionCooMatCached, p_nnz is the number of nnzs of the
+    // full matrix
+    template <typename t_IdxType>
+    MatPartition partitionCscSymMatCached(const uint32_t p_dim,
+                                          const uint64_t p_nnz,
+                                          const t_IdxType* p_rowIdx,
+                                          const t_IdxType* p_colPtr,
+                                          const t_DataType* p_data,
+                                          const int storeType,
+                                          std::string p_cacheDir) {
+        uint64_t l_stored = (uint64_t)(p_colPtr[p_dim] - p_colPtr[0]);
+        if (l_stored > p_nnz) {
+            throw SpmInvalidValue("from partitionCscSymMatCached in gen_signature.hpp, colPtr doesn't match nnz.");
+        }
+        uint64_t l_key = getCacheKey(sizeof(t_IdxType), p_dim, p_dim, p_nnz, storeType);
+        l_key = hash64(p_colPtr, sizeof(t_IdxType) * ((size_t)p_dim + 1), l_key);
+        l_key = hash64(p_rowIdx, sizeof(t_IdxType) * l_stored, l_key);
+        std::string l_cacheFile = getCacheFileName(p_cacheDir, l_key);
+        m_cacheWarning.clear();
+        if (loadSigCache(l_cacheFile, p_dim, p_dim, p_nnz)) {
+            m_cacheHit = true;
+            return m_sig.update_sig(p_data);
+        }
+        m_cacheHit = false;
+        MatPartition l_res = partitionCscSymMat(p_dim, p_nnz, p_rowIdx, p_colPtr, p_data, storeType);
+        storeSigCache(l_cacheFile, l_res);
         return l_res;
     }
-    int checkUpdateDim(uint32_t p_m, uint32_t p_n, uint32_t p_nnz) {
+    // true if the last partitionCooMatCached or partitionCscSymMatCached call was served from the cache
+    bool isCacheHit() const { return m_cacheHit; }
+    // why the last cached call ignored its cache file or didn't write it, empty when the cache file was used or
+    // stored; the matrix is partitioned either way, so this is left to the caller to report
+    const std::string& getCacheWarning() const { return m_cacheWarning; }
+    // number of threads used for partitioning, 0 means all hardware threads
+    void setThreads(unsigned int p_threads) { m_sig.setThreads(p_threads); }
+    const std::vector<std::pair<std::string, double> >& getStageTimes() const { return m_sig.getStageTimes(); }
+    // per channel memory blocks and their imbalance for the last partitioned matrix, see Signature::getChImbalance
+    std::vector<uint32_t> getChTotalBks() const { return m_sig.getChTotalBks(); }
+    double getChImbalance() const { return m_sig.getChImbalance(); }
+    uint64_t getParMaxChBks() const { return m_sig.getParMaxChBks(); }
+    // reordering applied before partitioning, see Signature::setReorder
+    void setReorder(SpmReorder p_reorder) { m_sig.setReorder(p_reorder); }
+    const std::vector<uint32_t>& getColPerm() const { return m_sig.getColPerm(); }
+    // storage of the values in the nnzVal buffers, see SpmValType
+    void setValType(SpmValType p_valType) { m_sig.setValType(p_valType); }
+    SpmValType getValType() const { return m_sig.getValType(); }
+    // encoding of the index blocks in the nnzVal buffers, see SpmIdxType
+    void setIdxType(SpmIdxType p_idxType) { m_sig.setIdxType(p_idxType); }
+    SpmIdxType getIdxType() const { return m_sig.getIdxType(); }
+    std::vector<uint32_t> getChIdxBks() const { return m_sig.getChIdxBks(); }
+    uint64_t getNnzPadEst(unsigned int p_after) const { return m_sig.getNnzPadEst(p_after); }
+    const std::vector<uint32_t>& getRowPerm() const { return m_sig.getRowPerm(); }
+    uint32_t getTotalRbs() const { return m_sig.getTotalRbs(); }
+    uint32_t getTotalPars() const { return m_sig.getTotalPars(); }
+    // p_vec in the row (p_rows true) or col order of the last partitioned matrix, p_vec and p_vecPerm hold p_size
+    // entries. b and x are moved into the kernel order with it.
+    void permuteVec(bool p_rows, uint32_t p_size, const t_DataType* p_vec, t_DataType* p_vecPerm) const {
+        const std::vector<uint32_t>& l_perm = getVecPerm(p_rows, p_size);
+        if (l_perm.empty()) {
+            std::copy(p_vec, p_vec + p_size, p_vecPerm);
+            return;
+        }
+        for (uint32_t i = 0; i < p_size; ++i) {
+            p_vecPerm[l_perm[i]] = p_vec[i];
+        }
+    }
+    // inverse of permuteVec, used for y and the solution x
+    void unpermuteVec(bool p_rows, uint32_t p_size, const t_DataType* p_vecPerm, t_DataType* p_vec) const {
+        const std::vector<uint32_t>& l_perm = getVecPerm(p_rows, p_size);
+        if (l_perm.empty()) {
+            std::copy(p_vecPerm, p_vecPerm + p_size, p_vec);
+            return;
+        }
+        for (uint32_t i = 0; i < p_size; ++i) {
+            p_vec[i] = p_vecPerm[l_perm[i]];
+        }
+    }
+    int checkUpdateDim(uint32_t p_m, uint32_t p_n, uint64_t p_nnz) {
         return m_sig.checkUpdateDim(p_m, p_n, p_nnz);
     }
     MatPartition updateMat(const t_DataType* p_data) {
         MatPartition l_res = m_sig.update_sig(p_data);
         return l_res;
     }
+    // the layout of the last partitionCscSymMat is kept, p_data holds the values of the given triangle only
     template <typename t_IdxType>
-    MatPartition updateCscSymMat(const uint32_t p_dim, const uint32_t p_nnz, const t_IdxType* p_rowIdx, const t_IdxType* p_colPtr, const t_DataType* p_data, const int storeType) {
-        std::vector<t_DataType> l_cooDat = this->getCooDatFromCscSym(p_dim, p_nnz, p_rowIdx, p_colPtr, p_data, storeType);
-        MatPartition l_res = m_sig.update_sig(l_cooDat.data());
+    MatPartition updateCscSymMat(const uint32_t p_dim, const uint64_t p_nnz, const t_IdxType* p_rowIdx, const t_IdxType* p_colPtr, const t_DataType* p_data, const int storeType) {
+        MatPartition l_res = m_sig.update_sig(p_data);
         return l_res;
     }
 
    private:
-    template <typename t_IdxType>
-    std::vector<t_DataType> getCooDatFromCscSym(const uint32_t p_dim, const uint32_t p_nnz, const t_IdxType* p_rowIdx, const t_IdxType* p_colPtr, const t_DataType* p_data, const int storeType) {
-        uint32_t l_off = 0;
-        if (storeType == 0)  {//C storeage type
-            l_off =0;   
+    const std::vector<uint32_t>& getVecPerm(bool p_rows, uint32_t p_size) const {
+        const std::vector<uint32_t>& l_perm = p_rows ? m_sig.getRowPerm() : m_sig.getColPerm();
+        if (!l_perm.empty() && (l_perm.size() != p_size)) {
+            throw SpmInvalidValue("from permuteVec in gen_signature.hpp, p_size doesn't match the partitioned matrix.");
         }
-        else if (storeType == 1) {//FORTRAN storage type
-            l_off = 1;
-            if (p_colPtr[0] < 1) {
-                throw SpmInvalidValue("from getCooDatFromCscSym in gen_signature.hpp, colPtr[0] start from 1 in FORTRAN storage mode.");
-            }
+        return l_perm;
+    }
+    // p_format distinguishes COO (0) from CSC inputs with index width p_format
+    uint64_t getCacheKey(uint32_t p_format, uint32_t p_m, uint32_t p_n, uint64_t p_nnz, int storeType) {
+        uint64_t l_fields[] = {p_format,  p_m,        p_n,       p_nnz,     (uint64_t)storeType,
+                               m_parEntries, m_accLatency, m_channels, m_maxRows, m_maxCols,
+                               m_memBits,  SIG_FILE_VERSION, (uint64_t)m_sig.getChParStrategy(),
+                               (uint64_t)m_sig.getReorder(), (uint64_t)m_sig.getValType(),
+                               (uint64_t)m_sig.getIdxType()};
+        return hash64(l_fields, sizeof(l_fields));
+    }
+    std::string getCacheFileName(std::string p_cacheDir, uint64_t p_key) {
+        char l_name[32];
+        snprintf(l_name, sizeof(l_name), "/sig_%016llx.bin", (unsigned long long)p_key);
+        return p_cacheDir + l_name;
+    }
+    // a missing, damaged or mismatching cache file is a miss
+    bool loadSigCache(std::string p_cacheFile, uint32_t p_m, uint32_t p_n, uint64_t p_nnz) {
+        if (!std::ifstream(p_cacheFile).good()) {
+            return false;
         }
-        else {
-            throw SpmNotSupported("from getCooDatFromCscSym in gen_signature.hpp, unsupported storage mode.");
+        MappedBinFile l_file;
+        if (!l_file.open(p_cacheFile)) {
+            addCacheWarning("ignoring signature cache file " + p_cacheFile + ", it can't be mapped");
+            return false;
         }
-        std::vector<t_DataType> l_cooDat;
-        l_cooDat.resize(p_nnz);
-        uint32_t l_index = 0;
-        for (uint32_t j = 0; j < p_dim; j++) {
-            for (t_IdxType k = p_colPtr[j] - l_off; k < p_colPtr[j + 1] - l_off; k++) {
-                t_IdxType i = p_rowIdx[k] - l_off;
-                if (l_index >= p_nnz) {
-                    throw SpmInternalError("from getCooDatFromCscSym in gen_signature.hpp, index >= nnz.");
-                }
-                assert(l_index < p_nnz);
-                l_cooDat[l_index++] = p_data[k];
-                if (i != j) {
-                    if (l_index >= p_nnz) {
-                        throw SpmInternalError("from getCooDatFromCscSym in gen_signature.hpp, index >= nnz.");
-                    }
-                    assert(l_index < p_nnz);
-                    l_cooDat[l_index++] = p_data[k];
-                }
+        try {
+            SigFileSections l_extra;
+            MatPartition l_matPar = loadMatParFile(l_file, m_parEntries, m_accLatency, m_channels, m_maxRows,
+                                                   m_maxCols, m_memBits, true, &l_extra);
+            if ((l_matPar.m_m != p_m) || (l_matPar.m_n != p_n) || (l_matPar.m_nnz != p_nnz) || (l_extra.size() != 5) ||
+                (l_extra[0].second != sizeof(uint8_t) * (size_t)p_nnz) ||
+                (l_extra[1].second != sizeof(uint32_t) * (size_t)p_nnz) ||
+                (l_extra[2].second % sizeof(uint64_t) != 0) ||
+                ((l_extra[3].second != 0) && (l_extra[3].second != sizeof(uint32_t) * (size_t)p_n)) ||
+                ((l_extra[4].second != 0) && (l_extra[4].second != sizeof(uint32_t) * (size_t)p_m))) {
+                throw SpmInvalidValue("Signature cache file does not match the matrix.");
             }
+            m_sig.restore_sig(l_matPar, reinterpret_cast<uint8_t*>(l_extra[0].first),
+                              reinterpret_cast<uint32_t*>(l_extra[1].first),
+                              reinterpret_cast<uint64_t*>(l_extra[2].first), l_extra[2].second / sizeof(uint64_t));
+            m_sig.restore_perms((l_extra[4].second == 0) ? nullptr : reinterpret_cast<uint32_t*>(l_extra[4].first),
+                                (l_extra[3].second == 0) ? nullptr : reinterpret_cast<uint32_t*>(l_extra[3].first));
+        } catch (const SpmException& err) {
+            addCacheWarning("ignoring signature cache file " + p_cacheFile + ", " + err.what());
+            return false;
         }
-        if (l_index != p_nnz) {
-            throw SpmInternalError("from getCooDatFromCscSym in gen_signature.hpp, failed to convert data from CscSym to COO format.");
+        return true;
+    }
+    // the cache file is written under a temporary name and renamed, so that concurrent jobs never map a partial file
+    void storeSigCache(std::string p_cacheFile, MatPartition& p_matPar) {
+        SigFileSections l_extra;
+        l_extra.push_back(std::make_pair((void*)m_sig.getNnzChs().data(), m_sig.getNnzChs().size() * sizeof(uint8_t)));
+        l_extra.push_back(
+            std::make_pair((void*)m_sig.getNnzByteLocs().data(), m_sig.getNnzByteLocs().size() * sizeof(uint32_t)));
+        l_extra.push_back(
+            std::make_pair((void*)m_sig.getMirrorSrcs().data(), m_sig.getMirrorSrcs().size() * sizeof(uint64_t)));
+        l_extra.push_back(
+            std::make_pair((void*)m_sig.getColPerm().data(), m_sig.getColPerm().size() * sizeof(uint32_t)));
+        l_extra.push_back(
+            std::make_pair((void*)m_sig.getRowPerm().data(), m_sig.getRowPerm().size() * sizeof(uint32_t)));
+        std::string l_tmpFile = p_cacheFile + ".tmp" + std::to_string(getpid());
+        try {
+            storeMatParFile(l_tmpFile, p_matPar, l_extra);
+            if (std::rename(l_tmpFile.c_str(), p_cacheFile.c_str()) != 0) {
+                throw SpmInvalidValue("Failed to rename " + l_tmpFile + ".");
+            }
+        } catch (const SpmException& err) {
+            addCacheWarning("signature cache file " + p_cacheFile + " is not written, " + err.what());
+            std::remove(l_tmpFile.c_str());
+        }
+    }
+    // the messages of the exceptions end with a newline, the warnings are joined on one line
+    void addCacheWarning(std::string p_msg) {
+        while (!p_msg.empty() && p_msg.back() == '\n') {
+            p_msg.pop_back();
         }
-        assert(l_index == p_nnz);
-        return l_cooDat;
+        m_cacheWarning += (m_cacheWarning.empty() ? "" : "; ") + p_msg;
     }
     Signature m_sig;
+    uint32_t m_parEntries, m_accLatency, m_channels, m_maxRows, m_maxCols, m_memBits;
+    bool m_cacheHit = false;
+    std::string m_cacheWarning;
 };
 
 }
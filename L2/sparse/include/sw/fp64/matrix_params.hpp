@@ -28,17 +28,179 @@
 #include <vector>
 #include <assert.h>
 #include <thread>
+#include <atomic>
+#include <exception>
 #include "spmException.hpp"
 #include "binFiles.hpp"
 #include "utils.hpp"
 
+#define RADIX_BITS 11
+#define RADIX_MIN_NNZS_PER_THREAD (1 << 16)
+
 namespace xf {
 namespace sparse {
 
+// resolve a requested thread count, 0 means all hardware threads
+inline unsigned int getNumThreads(unsigned int p_threads) {
+    if (p_threads == 0) {
+        p_threads = std::thread::hardware_concurrency();
+    }
+    return (p_threads == 0) ? 1 : p_threads;
+}
+
+// run p_func(t) for t in [0, p_threads), thread 0 runs on the calling thread, the first exception thrown by
+// any p_func is rethrown on the calling thread once all threads are joined
+template <typename t_Func>
+void parallelRun(unsigned int p_threads, t_Func p_func) {
+    std::vector<std::exception_ptr> l_errors(p_threads);
+    auto l_run = [&](unsigned int t) {
+        try {
+            p_func(t);
+        } catch (...) {
+            l_errors[t] = std::current_exception();
+        }
+    };
+    std::vector<std::thread> l_workers;
+    for (unsigned int t = 1; t < p_threads; ++t) {
+        l_workers.push_back(std::thread(l_run, t));
+    }
+    l_run(0);
+    for (unsigned int t = 0; t < l_workers.size(); ++t) {
+        l_workers[t].join();
+    }
+    for (unsigned int t = 0; t < p_threads; ++t) {
+        if (l_errors[t]) {
+            std::rethrow_exception(l_errors[t]);
+        }
+    }
+}
+
+// run p_func(i) for i in [0, p_n) on at most p_threads threads, items are handed out one by one so that
+// unevenly sized items are balanced; p_func must not start threads itself
+template <typename t_Func>
+void parallelFor(unsigned int p_threads, uint32_t p_n, t_Func p_func) {
+    unsigned int l_threads = std::min<uint32_t>(getNumThreads(p_threads), p_n);
+    if (l_threads <= 1) {
+        for (uint32_t i = 0; i < p_n; ++i) {
+            p_func(i);
+        }
+        return;
+    }
+    std::atomic<uint32_t> l_next(0);
+    parallelRun(l_threads, [&](unsigned int) {
+        for (uint32_t i = l_next++; i < p_n; i = l_next++) {
+            p_func(i);
+        }
+    });
+}
+
+// index offset of a storage type, 0: C storage type, indices start from 0, 1: FORTRAN storage type
+inline uint32_t getStoreOffset(const int storeType) {
+    if ((storeType != 0) && (storeType != 1)) {
+        throw SpmNotSupported("from getStoreOffset in matrix_params.hpp, unsupported storage mode.");
+    }
+    return storeType;
+}
+
+// storage of the values in the nnzVal buffers, recorded in word 4 of the info block of each channel. A value
+// block holds memBits / (parEntries * value bits) consecutive groups of parEntries values of a channel partition,
+// the index blocks are the same for all types. Products are accumulated in double precision for every type.
+enum SpmValType {
+    VAL_FP64 = 0,
+    VAL_FP32 = 1,
+    VAL_BF16 = 2 // upper half of an fp32, rounded to nearest even
+};
+
+inline uint32_t getValBytes(SpmValType p_valType) {
+    switch (p_valType) {
+        case VAL_FP64:
+            return 8;
+        case VAL_FP32:
+            return 4;
+        case VAL_BF16:
+            return 2;
+    }
+    throw SpmNotSupported("from getValBytes in matrix_params.hpp, unsupported value type.");
+}
+inline void storeVal(SpmValType p_valType, double p_val, uint8_t* p_buf) {
+    if (p_valType == VAL_FP64) {
+        memcpy(p_buf, &p_val, sizeof(double));
+        return;
+    }
+    float l_val = p_val;
+    if (p_valType == VAL_FP32) {
+        memcpy(p_buf, &l_val, sizeof(float));
+        return;
+    }
+    uint32_t l_bits;
+    memcpy(&l_bits, &l_val, sizeof(float));
+    if ((l_bits & 0x7fffffff) > 0x7f800000) {
+        l_bits |= 0x00400000; // keep NaNs quiet instead of rounding them to infinity
+    } else {
+        l_bits += 0x7fff + ((l_bits >> 16) & 1);
+    }
+    uint16_t l_bf16 = l_bits >> 16;
+    memcpy(p_buf, &l_bf16, sizeof(uint16_t));
+}
+inline double loadVal(SpmValType p_valType, const uint8_t* p_buf) {
+    if (p_valType == VAL_FP64) {
+        double l_val;
+        memcpy(&l_val, p_buf, sizeof(double));
+        return l_val;
+    }
+    float l_val;
+    if (p_valType == VAL_FP32) {
+        memcpy(&l_val, p_buf, sizeof(float));
+        return l_val;
+    }
+    uint16_t l_bf16;
+    memcpy(&l_bf16, p_buf, sizeof(uint16_t));
+    uint32_t l_bits = (uint32_t)l_bf16 << 16;
+    memcpy(&l_val, &l_bits, sizeof(float));
+    return l_val;
+}
+
+// encoding of the row and col index blocks of the nnzVal buffers. With IDX_DELTA every channel partition stores
+// each index stream as signed deltas of 2, 4 or 8 bits, the narrowest that holds all its deltas, or as 16-bit
+// indices when none does. Block 7 of each partition in parParam records (col delta bits << 8) | row delta bits for
+// every channel, 0 for 16-bit indices, the kernels skip this block.
+enum SpmIdxType {
+    IDX_U16 = 0,  // 16-bit indices relative to the first row or col block of the channel partition
+    IDX_DELTA = 1 // entry j holds index j minus index j - 1, index -1 is 0, unused entries are 0
+};
+
+// bits of an index block entry, p_deltaBits == 0 stands for 16-bit indices
+inline uint32_t getIdxBits(uint32_t p_deltaBits) {
+    return (p_deltaBits == 0) ? 16 : p_deltaBits;
+}
+// narrowest delta width holding all deltas in [p_minDelta, p_maxDelta], 0 when only 16-bit indices do
+inline uint32_t getDeltaBits(int64_t p_minDelta, int64_t p_maxDelta) {
+    for (uint32_t l_bits = 2; l_bits < 16; l_bits *= 2) {
+        if ((p_minDelta >= -(1LL << (l_bits - 1))) && (p_maxDelta < (1LL << (l_bits - 1)))) {
+            return l_bits;
+        }
+    }
+    return 0;
+}
+// entry p_entry of a delta encoded index block, entries are packed from the least significant bit of each byte
+inline int32_t loadDelta(const uint8_t* p_bk, uint32_t p_entry, uint32_t p_deltaBits) {
+    uint32_t l_bitLoc = p_entry * p_deltaBits;
+    int32_t l_val = (p_bk[l_bitLoc / 8] >> (l_bitLoc % 8)) & ((1 << p_deltaBits) - 1);
+    return (l_val >= (1 << (p_deltaBits - 1))) ? l_val - (1 << p_deltaBits) : l_val;
+}
+
+// contiguous entries [m_offset, m_offset + m_nnz) of the COO lists owned by a SparseMatrix
+struct SpmView {
+    uint64_t m_offset = 0;
+    uint64_t m_nnz = 0;
+    uint32_t m_m = 0, m_n = 0;
+    uint32_t m_minRowId = 0, m_minColId = 0;
+};
+
 class SparseMatrix {
    public:
     SparseMatrix() = default;
-    SparseMatrix(uint32_t m, uint32_t n, uint32_t nnz) {
+    SparseMatrix(uint32_t m, uint32_t n, uint64_t nnz) {
         m_m = m;
         m_n = n;
         m_nnz = nnz;
@@ -48,7 +210,7 @@ class SparseMatrix {
         m_minColId = *(min_element(m_col_list.begin(), m_col_list.end()));
     }
 
-    void loadCoo(const uint32_t p_m, const uint32_t p_n, const uint32_t p_nnz, const uint32_t* p_rowIdx, const uint32_t* p_colIdx, const int storeType) {
+    void loadCoo(const uint32_t p_m, const uint32_t p_n, const uint64_t p_nnz, const uint32_t* p_rowIdx, const uint32_t* p_colIdx, const int storeType) {
         uint32_t l_off = 0;
         if (storeType == 0)  {//C storeage type
             l_off =0; 
@@ -64,9 +226,10 @@ class SparseMatrix {
         m_nnz = p_nnz;
         m_minRowId = 0;
         m_minColId = 0;
+        m_rowSorted = false;
         m_row_list.resize(m_nnz);
         m_col_list.resize(m_nnz);
-        for (uint32_t i=0; i<p_nnz; ++i) {
+        for (uint64_t i=0; i<p_nnz; ++i) {
             m_row_list[i] = p_rowIdx[i] - l_off;
             m_col_list[i] = p_colIdx[i] - l_off;
         }
@@ -79,7 +242,7 @@ class SparseMatrix {
     }
 
     template <typename t_IdxType>
-    void loadCscSym(const uint32_t p_n, const uint32_t p_nnz, const t_IdxType* p_rowIdx, const t_IdxType* p_colPtr, const int storeType) {
+    void loadCscSym(const uint32_t p_n, const uint64_t p_nnz, const t_IdxType* p_rowIdx, const t_IdxType* p_colPtr, const int storeType) {
         uint32_t l_off = 0;
         if (storeType == 0)  {//C storeage type
             l_off =0; 
@@ -98,12 +261,13 @@ class SparseMatrix {
         m_nnz = p_nnz;
         m_minRowId = 0;
         m_minColId = 0;
+        m_rowSorted = false;
         m_row_list.resize(m_nnz);
         m_col_list.resize(m_nnz);
         m_data_list.resize(m_nnz);
         iota(m_data_list.begin(), m_data_list.end(), 0);
 
-        uint32_t index = 0;
+        uint64_t index = 0;
         for (uint32_t j = 0; j < p_n; j++) {
             for (t_IdxType k = p_colPtr[j] - l_off; k < p_colPtr[j + 1] - l_off; k++) {
                 t_IdxType i = p_rowIdx[k] - l_off;
@@ -133,7 +297,150 @@ class SparseMatrix {
         m_minColId = *(min_element(m_col_list.begin(), m_col_list.end()));
     }
 
-    void create_matrix(std::vector<uint32_t>& p_row, std::vector<uint32_t>& p_col, std::vector<uint32_t>& p_data) {
+    // CSR input, the entries are already row sorted so that sort_by_row has nothing to do
+    template <typename t_IdxType>
+    void loadCsr(const uint32_t p_m,
+                 const uint32_t p_n,
+                 const uint64_t p_nnz,
+                 const t_IdxType* p_rowPtr,
+                 const t_IdxType* p_colIdx,
+                 const int storeType) {
+        uint32_t l_off = getStoreOffset(storeType);
+        if ((p_rowPtr[0] != (t_IdxType)l_off) || ((uint64_t)(p_rowPtr[p_m] - l_off) != p_nnz)) {
+            throw SpmInvalidValue("from loadCsr in matrix_params.hpp, rowPtr doesn't match nnz.");
+        }
+        m_m = p_m;
+        m_n = p_n;
+        resizeEntries(p_nnz);
+        for (uint32_t i = 0; i < p_m; ++i) {
+            if (p_rowPtr[i + 1] < p_rowPtr[i]) {
+                throw SpmInvalidValue("from loadCsr in matrix_params.hpp, rowPtr is not monotonic.");
+            }
+            for (t_IdxType k = p_rowPtr[i] - l_off; k < p_rowPtr[i + 1] - l_off; ++k) {
+                m_row_list[k] = i;
+                m_col_list[k] = p_colIdx[k] - l_off;
+            }
+        }
+        iota(m_data_list.begin(), m_data_list.end(), 0);
+        m_minRowId = (m_nnz == 0) ? 0 : m_row_list[0];
+        m_minColId = (m_nnz == 0) ? 0 : *(min_element(m_col_list.begin(), m_col_list.end()));
+        m_rowSorted = true;
+    }
+
+    // CSC input, the entries are placed in row order with one counting pass instead of sorting them, entries of a
+    // row keep their CSC order like a stable sort_by_row of the CSC ordered COO lists
+    template <typename t_IdxType>
+    void loadCsc(const uint32_t p_m,
+                 const uint32_t p_n,
+                 const uint64_t p_nnz,
+                 const t_IdxType* p_rowIdx,
+                 const t_IdxType* p_colPtr,
+                 const int storeType) {
+        uint32_t l_off = getStoreOffset(storeType);
+        if ((p_colPtr[0] != (t_IdxType)l_off) || ((uint64_t)(p_colPtr[p_n] - l_off) != p_nnz)) {
+            throw SpmInvalidValue("from loadCsc in matrix_params.hpp, colPtr doesn't match nnz.");
+        }
+        std::vector<uint64_t> l_rowPos(p_m + 1, 0);
+        for (uint32_t j = 0; j < p_n; ++j) {
+            if (p_colPtr[j + 1] < p_colPtr[j]) {
+                throw SpmInvalidValue("from loadCsc in matrix_params.hpp, colPtr is not monotonic.");
+            }
+        }
+        for (uint64_t k = 0; k < p_nnz; ++k) {
+            uint64_t l_rowId = (uint64_t)(p_rowIdx[k] - l_off);
+            if (l_rowId >= p_m) {
+                throw SpmInvalidValue("from loadCsc in matrix_params.hpp, row index out of range.");
+            }
+            l_rowPos[l_rowId + 1]++;
+        }
+        std::partial_sum(l_rowPos.begin(), l_rowPos.end(), l_rowPos.begin());
+        m_m = p_m;
+        m_n = p_n;
+        resizeEntries(p_nnz);
+        for (uint32_t j = 0; j < p_n; ++j) {
+            for (t_IdxType k = p_colPtr[j] - l_off; k < p_colPtr[j + 1] - l_off; ++k) {
+                uint32_t l_rowId = p_rowIdx[k] - l_off;
+                uint64_t l_pos = l_rowPos[l_rowId]++;
+                m_row_list[l_pos] = l_rowId;
+                m_col_list[l_pos] = j;
+                m_data_list[l_pos] = k;
+            }
+        }
+        m_minRowId = (m_nnz == 0) ? 0 : m_row_list[0];
+        m_minColId = (m_nnz == 0) ? 0 : *(min_element(m_col_list.begin(), m_col_list.end()));
+        m_rowSorted = true;
+    }
+
+    // symmetric matrix given by one triangle in CSC format, p_nnz is the number of nnzs of the full matrix. The
+    // entries are placed in row order like loadCsc and the mirrored entries are not given values of their own:
+    // the stored entries keep their CSC positions as data indices and the r-th mirrored entry gets data index
+    // stored nnzs + r, m_mirrorSrcs[r] is the data index it mirrors.
+    template <typename t_IdxType>
+    void loadCscSymHalf(const uint32_t p_n,
+                        const uint64_t p_nnz,
+                        const t_IdxType* p_rowIdx,
+                        const t_IdxType* p_colPtr,
+                        const int storeType) {
+        uint32_t l_off = getStoreOffset(storeType);
+        if (p_colPtr[0] != (t_IdxType)l_off) {
+            throw SpmInvalidValue("from loadCscSymHalf in matrix_params.hpp, colPtr[0] doesn't match the storage mode.");
+        }
+        std::vector<uint64_t> l_rowPos(p_n + 1, 0);
+        uint64_t l_mirrors = 0;
+        for (uint32_t j = 0; j < p_n; ++j) {
+            if (p_colPtr[j + 1] < p_colPtr[j]) {
+                throw SpmInvalidValue("from loadCscSymHalf in matrix_params.hpp, colPtr is not monotonic.");
+            }
+            for (t_IdxType k = p_colPtr[j] - l_off; k < p_colPtr[j + 1] - l_off; ++k) {
+                uint64_t l_rowId = (uint64_t)(p_rowIdx[k] - l_off);
+                if (l_rowId >= p_n) {
+                    throw SpmInvalidValue("from loadCscSymHalf in matrix_params.hpp, row index out of range.");
+                }
+                l_rowPos[l_rowId + 1]++;
+                if (l_rowId != j) {
+                    l_rowPos[j + 1]++;
+                    l_mirrors++;
+                }
+            }
+        }
+        uint64_t l_stored = p_colPtr[p_n] - l_off;
+        if (l_stored + l_mirrors != p_nnz) {
+            throw SpmInvalidValue(
+                "from loadCscSymHalf in matrix_params.hpp, nnz doesn't match the symmetric matrix.");
+        }
+        std::partial_sum(l_rowPos.begin(), l_rowPos.end(), l_rowPos.begin());
+        m_m = p_n;
+        m_n = p_n;
+        resizeEntries(p_nnz);
+        try {
+            m_mirrorSrcs.resize(l_mirrors);
+        } catch (const std::bad_alloc&) {
+            throw SpmAllocFailed("Failed to allocate memory used for storing mirrored entries.");
+        }
+        uint64_t l_mirrorId = 0;
+        for (uint32_t j = 0; j < p_n; ++j) {
+            for (t_IdxType k = p_colPtr[j] - l_off; k < p_colPtr[j + 1] - l_off; ++k) {
+                uint32_t l_rowId = p_rowIdx[k] - l_off;
+                uint64_t l_pos = l_rowPos[l_rowId]++;
+                m_row_list[l_pos] = l_rowId;
+                m_col_list[l_pos] = j;
+                m_data_list[l_pos] = k;
+                if (l_rowId != j) {
+                    l_pos = l_rowPos[j]++;
+                    m_row_list[l_pos] = j;
+                    m_col_list[l_pos] = l_rowId;
+                    m_data_list[l_pos] = l_stored + l_mirrorId;
+                    m_mirrorSrcs[l_mirrorId++] = k;
+                }
+            }
+        }
+        m_minRowId = (m_nnz == 0) ? 0 : m_row_list[0];
+        m_minColId = (m_nnz == 0) ? 0 : *(min_element(m_col_list.begin(), m_col_list.end()));
+        m_rowSorted = true;
+    }
+
+    void create_matrix(std::vector<uint32_t>& p_row, std::vector<uint32_t>& p_col, std::vector<uint64_t>& p_data) {
+        m_rowSorted = false;
         if (!p_row.empty()) {
             m_nnz = p_row.size();
             m_row_list = p_row;
@@ -154,151 +461,212 @@ class SparseMatrix {
         }
     }
 
-    uint32_t getRow(uint32_t index) { return m_row_list[index]; }
+    // renumber the rows, row i becomes p_rowPerm[i], the entry order and the data indices are kept
+    void permuteRows(const std::vector<uint32_t>& p_rowPerm) {
+        for (uint64_t i = 0; i < m_nnz; ++i) {
+            m_row_list[i] = p_rowPerm[m_row_list[i]];
+        }
+        m_rowSorted = false;
+        if (m_nnz > 0) {
+            m_minRowId = *(min_element(m_row_list.begin(), m_row_list.end()));
+        }
+    }
+    // renumber the cols, col j becomes p_colPerm[j], the entry order and the data indices are kept
+    void permuteCols(const std::vector<uint32_t>& p_colPerm) {
+        for (uint64_t i = 0; i < m_nnz; ++i) {
+            m_col_list[i] = p_colPerm[m_col_list[i]];
+        }
+        if (m_nnz > 0) {
+            m_minColId = *(min_element(m_col_list.begin(), m_col_list.end()));
+        }
+    }
+
+    uint32_t getRow(uint64_t index) { return m_row_list[index]; }
 
     const std::vector<uint32_t>& getRows() { return m_row_list; }
 
-    uint32_t getCol(uint32_t index) { return m_col_list[index]; }
+    uint32_t getCol(uint64_t index) { return m_col_list[index]; }
 
     const std::vector<uint32_t>& getCols() { return m_col_list; }
 
-    uint32_t getData(uint32_t index) { return m_data_list[index]; }
+    uint64_t getData(uint64_t index) { return m_data_list[index]; }
 
-    const std::vector<uint32_t>& getDatas() { return m_data_list; }
+    const std::vector<uint64_t>& getDatas() { return m_data_list; }
 
     uint32_t getM() { return m_m; }
 
     uint32_t getN() { return m_n; }
 
-    uint32_t getNnz() { return m_nnz; }
+    uint64_t getNnz() { return m_nnz; }
 
     uint32_t getMinRowId() { return m_minRowId; }
     uint32_t getMinColId() { return m_minColId; }
 
-    std::vector<uint32_t> getSubRows(uint32_t start, uint32_t end) {
+    std::vector<uint32_t> getSubRows(uint64_t start, uint64_t end) {
         std::vector<uint32_t> l_row(m_row_list.begin() + start, m_row_list.begin() + end);
         return std::move(l_row);
     }
-    std::vector<uint32_t> getSubCols(uint32_t start, uint32_t end) {
+    std::vector<uint32_t> getSubCols(uint64_t start, uint64_t end) {
         std::vector<uint32_t> l_col(m_col_list.begin() + start, m_col_list.begin() + end);
         return std::move(l_col);
     }
-    std::vector<uint32_t> getSubDatas(uint32_t start, uint32_t end) {
-        std::vector<uint32_t> l_data(m_data_list.begin() + start, m_data_list.begin() + end);
+    std::vector<uint64_t> getSubDatas(uint64_t start, uint64_t end) {
+        std::vector<uint64_t> l_data(m_data_list.begin() + start, m_data_list.begin() + end);
         return std::move(l_data);
     }
 
-    void partialSort(uint32_t p_sId, unsigned int p_size, std::vector<uint32_t>& p_list, std::vector<uint32_t>& p_idx) {
-        p_idx.resize(p_size);
-        iota(p_idx.begin(), p_idx.end(), p_sId);
-        stable_sort(p_idx.begin(), p_idx.end(), [&](uint32_t i1, uint32_t i2) { return p_list[i1] < p_list[i2]; });
-    }
-
-    void mergeIdx(unsigned int p_size,
-                  std::vector<uint32_t> p_idxArr[2],
-                  std::vector<uint32_t>& p_list,
-                  std::vector<uint32_t>& p_idx) {
-        std::vector<unsigned int> l_ids(2, 0);
-        for (unsigned int i = 0; i < p_size; ++i) {
-            if (l_ids[0] < p_idxArr[0].size()) {
-                if ((l_ids[1] < p_idxArr[1].size()) &&
-                    (p_list[p_idxArr[1][l_ids[1]]] < p_list[p_idxArr[0][l_ids[0]]])) {
-                    p_idx[i] = p_idxArr[1][l_ids[1]];
-                    l_ids[1]++;
-                } else {
-                    p_idx[i] = p_idxArr[0][l_ids[0]];
-                    l_ids[0]++;
-                }
+    void setSortThreads(unsigned int p_threads) { m_sortThreads = p_threads; }
+    unsigned int getSortThreads() { return getNumThreads(m_sortThreads); }
+
+    // one stable LSD radix pass on digit [p_shift, p_shift+RADIX_BITS) of p_src[p_keyId], row and col lists
+    // (p_src[0..1]) and the data list (p_srcData) are permuted together into p_dst and p_dstData, returns false if
+    // all keys share the digit and nothing was moved
+    bool radixPass(unsigned int p_keyId,
+                   unsigned int p_shift,
+                   unsigned int p_threads,
+                   uint64_t p_nnz,
+                   uint32_t* const p_src[2],
+                   uint64_t* const p_srcData,
+                   uint32_t* const p_dst[2],
+                   uint64_t* const p_dstData) {
+        const uint32_t l_buckets = 1 << RADIX_BITS;
+        const uint32_t l_mask = l_buckets - 1;
+        const uint64_t l_chunk = (p_nnz + p_threads - 1) / p_threads;
+        const uint32_t* l_key = p_src[p_keyId];
+        std::vector<uint64_t> l_hist(p_threads * l_buckets, 0);
+
+        parallelRun(p_threads, [&](unsigned int t) {
+            uint64_t* l_cnt = &l_hist[t * l_buckets];
+            uint64_t l_sId = std::min(p_nnz, t * l_chunk);
+            uint64_t l_eId = std::min(p_nnz, l_sId + l_chunk);
+            for (uint64_t i = l_sId; i < l_eId; ++i) {
+                l_cnt[(l_key[i] >> p_shift) & l_mask]++;
+            }
+        });
+        uint64_t l_sum = 0;
+        for (uint32_t b = 0; b < l_buckets; ++b) {
+            uint64_t l_total = 0;
+            for (unsigned int t = 0; t < p_threads; ++t) {
+                uint64_t l_cnt = l_hist[t * l_buckets + b];
+                l_hist[t * l_buckets + b] = l_sum + l_total;
+                l_total += l_cnt;
+            }
+            if (l_total == p_nnz) {
+                return false;
+            }
+            l_sum += l_total;
+        }
+
+        parallelRun(p_threads, [&](unsigned int t) {
+            uint64_t* l_off = &l_hist[t * l_buckets];
+            uint64_t l_sId = std::min(p_nnz, t * l_chunk);
+            uint64_t l_eId = std::min(p_nnz, l_sId + l_chunk);
+            for (uint64_t i = l_sId; i < l_eId; ++i) {
+                uint64_t l_pos = l_off[(l_key[i] >> p_shift) & l_mask]++;
+                p_dst[0][l_pos] = p_src[0][i];
+                p_dst[1][l_pos] = p_src[1][i];
+                p_dstData[l_pos] = p_srcData[i];
+            }
+        });
+        return true;
+    }
+
+    // stable sort of entries [p_sId, p_eId) along the row (p_keyId=0) or col (p_keyId=1) indices on up to
+    // p_threads threads
+    void radixSort(unsigned int p_keyId, uint64_t p_sId, uint64_t p_eId, unsigned int p_threads) {
+        uint64_t l_nnz = p_eId - p_sId;
+        // a full row sort leaves the lists row sorted, any col sort breaks it and a range row sort keeps the state
+        if (p_keyId == 0) {
+            m_rowSorted = m_rowSorted || ((p_sId == 0) && (p_eId == m_nnz));
+        } else if (l_nnz >= 2) {
+            m_rowSorted = false;
+        }
+        if (l_nnz < 2) {
+            return;
+        }
+        std::vector<uint32_t> l_tmp[2];
+        std::vector<uint64_t> l_tmpData;
+        try {
+            for (unsigned int i = 0; i < 2; ++i) {
+                l_tmp[i].resize(l_nnz);
+            }
+            l_tmpData.resize(l_nnz);
+        } catch (const std::bad_alloc&) {
+            throw SpmAllocFailed("Failed to allocate memory used for sorting matrix.");
+        }
+        uint32_t* l_lists[2] = {m_row_list.data() + p_sId, m_col_list.data() + p_sId};
+        uint32_t* l_bufs[2] = {l_tmp[0].data(), l_tmp[1].data()};
+        uint32_t** l_src = l_lists;
+        uint32_t** l_dst = l_bufs;
+        uint64_t* l_srcData = m_data_list.data() + p_sId;
+        uint64_t* l_dstData = l_tmpData.data();
+
+        uint32_t l_maxKey = *(std::max_element(l_src[p_keyId], l_src[p_keyId] + l_nnz));
+        unsigned int l_threads = (unsigned int)std::min<uint64_t>(
+            p_threads, std::max<uint64_t>(1, l_nnz / RADIX_MIN_NNZS_PER_THREAD));
+        unsigned int l_shift = 0;
+        do {
+            if (radixPass(p_keyId, l_shift, l_threads, l_nnz, l_src, l_srcData, l_dst, l_dstData)) {
+                std::swap(l_src, l_dst);
+                std::swap(l_srcData, l_dstData);
+            }
+            l_shift += RADIX_BITS;
+        } while ((l_shift < 32) && ((l_maxKey >> l_shift) != 0));
+
+        if (l_src == l_bufs) {
+            if (l_nnz == m_nnz) {
+                m_row_list.swap(l_tmp[0]);
+                m_col_list.swap(l_tmp[1]);
+                m_data_list.swap(l_tmpData);
             } else {
-                p_idx[i] = p_idxArr[1][l_ids[1]];
-                l_ids[1]++;
+                for (unsigned int i = 0; i < 2; ++i) {
+                    memcpy(l_lists[i], l_bufs[i], l_nnz * sizeof(uint32_t));
+                }
+                memcpy(m_data_list.data() + p_sId, l_tmpData.data(), l_nnz * sizeof(uint64_t));
             }
         }
     }
 
     void sort_by_row() {
-        std::vector<uint32_t> idx(m_nnz);
-        std::vector<uint32_t> l_idxArr[2];
-        std::thread t1(&SparseMatrix::partialSort, this, 0, m_nnz / 2, ref(m_row_list), ref(l_idxArr[0]));
-        std::thread t2(&SparseMatrix::partialSort, this, m_nnz / 2, m_nnz - m_nnz / 2, ref(m_row_list),
-                       ref(l_idxArr[1]));
-        t1.join();
-        t2.join();
-        mergeIdx(m_nnz, l_idxArr, m_row_list, idx);
-        // then sort each part using this index
-        uint32_t* l_row_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        uint32_t* l_col_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        uint32_t* l_data_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        if ((l_row_list == nullptr)||(l_col_list == nullptr)||(l_data_list == nullptr)) {
-            throw SpmAllocFailed("Failed to allocate memory used for sorting matrix along the row indices.");
-        }
-        for (uint32_t i = 0; i < m_nnz; i++) {
-            l_row_list[i] = m_row_list[idx[i]];
-            l_col_list[i] = m_col_list[idx[i]];
-            l_data_list[i] = m_data_list[idx[i]];
-        }
-        memcpy(&m_row_list[0], l_row_list, m_nnz * sizeof(uint32_t));
-        memcpy(&m_col_list[0], l_col_list, m_nnz * sizeof(uint32_t));
-        memcpy(&m_data_list[0], l_data_list, m_nnz * sizeof(uint32_t));
-        free(l_row_list);
-        free(l_col_list);
-        free(l_data_list);
+        if (!m_rowSorted) {
+            radixSort(0, 0, m_nnz, getSortThreads());
+        }
     }
+    // range sorts run on the calling thread only, they are meant to be called from parallelFor workers
+    void sort_by_row(uint64_t p_sId, uint64_t p_eId) { radixSort(0, p_sId, p_eId, 1); }
     void complete_sort_by_row() {
-        std::vector<uint32_t> idx(m_nnz);
-        iota(idx.begin(), idx.end(), 0);
-        stable_sort(idx.begin(), idx.end(), [this](uint32_t i1, uint32_t i2) {
-            return (m_row_list[i1] < m_row_list[i2])
-                       ? true
-                       : (m_row_list[i1] == m_row_list[i2]) ? m_col_list[i1] <= m_col_list[i2] : false;
-        });
-        // then sort each part using this index
-        uint32_t* l_row_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        uint32_t* l_col_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        uint32_t* l_data_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        if ((l_row_list == nullptr)||(l_col_list == nullptr)||(l_data_list == nullptr)) {
-            throw SpmAllocFailed("Failed to allocate memory used for completely sorting matrix.");
-        }
-        for (uint32_t i = 0; i < m_nnz; i++) {
-            l_row_list[i] = m_row_list[idx[i]];
-            l_col_list[i] = m_col_list[idx[i]];
-            l_data_list[i] = m_data_list[idx[i]];
-        }
-        memcpy(&m_row_list[0], l_row_list, m_nnz * sizeof(uint32_t));
-        memcpy(&m_col_list[0], l_col_list, m_nnz * sizeof(uint32_t));
-        memcpy(&m_data_list[0], l_data_list, m_nnz * sizeof(uint32_t));
-        free(l_row_list);
-        free(l_col_list);
-        free(l_data_list);
-    }
-
-    void sort_by_col() {
-        std::vector<uint32_t> idx(m_nnz);
-        std::vector<uint32_t> l_idxArr[2];
-        std::thread t1(&SparseMatrix::partialSort, this, 0, m_nnz / 2, ref(m_col_list), ref(l_idxArr[0]));
-        std::thread t2(&SparseMatrix::partialSort, this, m_nnz / 2, m_nnz - m_nnz / 2, ref(m_col_list),
-                       ref(l_idxArr[1]));
-        t1.join();
-        t2.join();
-        mergeIdx(m_nnz, l_idxArr, m_col_list, idx);
-        // then sort each part using this index
-        uint32_t* l_row_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        uint32_t* l_col_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        uint32_t* l_data_list = (uint32_t*)malloc(m_nnz * sizeof(uint32_t));
-        if ((l_row_list == nullptr)||(l_col_list == nullptr)||(l_data_list == nullptr)) {
-            throw SpmAllocFailed("Failed to allocate memory used for sorting matrix along column indices.");
-        }
-        for (uint32_t i = 0; i < m_nnz; i++) {
-            l_row_list[i] = m_row_list[idx[i]];
-            l_col_list[i] = m_col_list[idx[i]];
-            l_data_list[i] = m_data_list[idx[i]];
-        }
-        memcpy(&m_row_list[0], l_row_list, m_nnz * sizeof(uint32_t));
-        memcpy(&m_col_list[0], l_col_list, m_nnz * sizeof(uint32_t));
-        memcpy(&m_data_list[0], l_data_list, m_nnz * sizeof(uint32_t));
-        free(l_row_list);
-        free(l_col_list);
-        free(l_data_list);
+        radixSort(1, 0, m_nnz, getSortThreads());
+        radixSort(0, 0, m_nnz, getSortThreads());
+    }
+    void sort_by_col() { radixSort(1, 0, m_nnz, getSortThreads()); }
+    void sort_by_col(uint64_t p_sId, uint64_t p_eId) { radixSort(1, p_sId, p_eId, 1); }
+
+    // view of entries [p_sId, p_eId), m, n and min indices are computed the same way as in create_matrix
+    SpmView getView(uint64_t p_sId, uint64_t p_eId) {
+        SpmView l_view;
+        l_view.m_offset = p_sId;
+        l_view.m_nnz = p_eId - p_sId;
+        if (p_eId > p_sId) {
+            auto l_rows = std::minmax_element(m_row_list.begin() + p_sId, m_row_list.begin() + p_eId);
+            auto l_cols = std::minmax_element(m_col_list.begin() + p_sId, m_col_list.begin() + p_eId);
+            l_view.m_minRowId = *(l_rows.first);
+            l_view.m_minColId = *(l_cols.first);
+            l_view.m_m = *(l_rows.second) - l_view.m_minRowId + 1;
+            l_view.m_n = *(l_cols.second) - l_view.m_minColId + 1;
+        }
+        return l_view;
+    }
+
+    void resizeEntries(uint64_t p_nnz) {
+        m_nnz = p_nnz;
+        m_rowSorted = false;
+        try {
+            m_row_list.resize(m_nnz);
+            m_col_list.resize(m_nnz);
+            m_data_list.resize(m_nnz);
+        } catch (const std::bad_alloc&) {
+            throw SpmAllocFailed("Failed to allocate memory used for storing matrix entries.");
+        }
     }
 
     void clearRowIdx() {
@@ -316,14 +684,21 @@ class SparseMatrix {
         m_col_list.shrink_to_fit();
         m_data_list.clear();
         m_data_list.shrink_to_fit();
+        m_mirrorSrcs.clear();
+        m_mirrorSrcs.shrink_to_fit();
     }
    public:
-    uint32_t m_m, m_n, m_nnz;
+    uint32_t m_m, m_n;
+    uint64_t m_nnz;
     std::vector<uint32_t> m_row_list;
     std::vector<uint32_t> m_col_list;
-    std::vector<uint32_t>
+    std::vector<uint64_t>
         m_data_list; // stores the idx of the original data array in sparse matrix, value =0 if idx == nnzs
     uint32_t m_minRowId, m_minColId;
+    unsigned int m_sortThreads = 0; // 0: use all hardware threads
+    bool m_rowSorted = false;       // the lists are sorted by row, sort_by_row can be skipped
+    // data index mirrored by each mirrored entry of a symmetric matrix, see loadCscSymHalf
+    std::vector<uint64_t> m_mirrorSrcs;
 };
 
 class RowBlockParam {
@@ -547,6 +922,16 @@ class ParParam {
         return int32Arr;
     }
 
+    void set_chInfo16(uint32_t p_parId, uint32_t p_chInfo16Id, const uint32_t* p_info) {
+        uint16_t chInfo16Arr[m_channels];
+        for (uint32_t i = 0; i < m_channels; i++) {
+            chInfo16Arr[i] = p_info[i];
+        }
+        uint32_t l_offset = get_par_offset(p_parId);
+        l_offset += m_memBytes * (5 + p_chInfo16Id);
+        memcpy(&m_buf[l_offset], reinterpret_cast<uint8_t*>(chInfo16Arr), m_channels * sizeof(uint16_t));
+    }
+
     std::vector<uint16_t> get_chInfo16(uint32_t p_parId, uint32_t p_chInfo16Id) {
         uint32_t l_offset = get_par_offset(p_parId);
         l_offset += m_memBytes * (5 + p_chInfo16Id);
@@ -580,7 +965,7 @@ class NnzStore {
     NnzStore() = default;
     NnzStore(uint32_t p_memBits, uint32_t p_parEntries, uint32_t p_accLatency, uint32_t p_channels) {
         m_memBytes = p_memBits / 8;
-        p_parEntries = m_parEntries;
+        m_parEntries = p_parEntries;
         m_accLatency = p_accLatency;
         m_channels = p_channels;
         m_totalBks.resize(m_channels);
@@ -592,7 +977,7 @@ class NnzStore {
 
     void init(uint32_t p_memBits, uint32_t p_parEntries, uint32_t p_accLatency, uint32_t p_channels) {
         m_memBytes = p_memBits / 8;
-        p_parEntries = m_parEntries;
+        m_parEntries = p_parEntries;
         m_accLatency = p_accLatency;
         m_channels = p_channels;
         m_totalBks.resize(m_channels);
@@ -601,9 +986,10 @@ class NnzStore {
         m_totalNnzBks.resize(m_channels);
         m_buf.resize(m_channels);
     }
-    void reserveMem(unsigned int p_nnzs) {
+    // p_bks[c]: number of memory blocks channel c will hold, including the info block
+    void reserveMem(const std::vector<size_t>& p_bks) {
         for (unsigned int c=0; c<m_channels; ++c) {
-            m_buf[c].reserve(p_nnzs);
+            m_buf[c].reserve(p_bks[c] * m_memBytes);
         }
     }
 
@@ -632,21 +1018,50 @@ class NnzStore {
         memcpy(&m_buf[p_chId][p_byteLoc], reinterpret_cast<uint8_t*>(int16Arr), m_memBytes * sizeof(uint8_t));
     }
 
-    void add_nnzArr(uint32_t p_chId, double* p_nnzArr) {
-        double float64Arr[m_memBytes / 8];
-        for (uint32_t i = 0; i < m_memBytes / 8; i++) {
-            float64Arr[i] = p_nnzArr[i];
-        }
+    // p_deltaArr holds the m_memBytes * 8 / p_deltaBits deltas of a delta encoded index block
+    void add_deltaArr(uint32_t p_chId, const int32_t* p_deltaArr, uint32_t p_deltaBits) {
         uint32_t old_size = m_buf[p_chId].size();
-        m_buf[p_chId].resize(old_size + m_memBytes);
-        memcpy(&m_buf[p_chId][old_size], reinterpret_cast<uint8_t*>(float64Arr), m_memBytes * sizeof(uint8_t));
+        m_buf[p_chId].resize(old_size + m_memBytes, 0);
+        uint8_t* l_bk = &m_buf[p_chId][old_size];
+        uint32_t l_mask = (1 << p_deltaBits) - 1;
+        for (uint32_t i = 0; i < m_memBytes * 8 / p_deltaBits; i++) {
+            uint32_t l_bitLoc = i * p_deltaBits;
+            l_bk[l_bitLoc / 8] |= (p_deltaArr[i] & l_mask) << (l_bitLoc % 8);
+        }
+    }
+
+    void setValType(SpmValType p_valType) {
+        uint32_t l_groupBytes = m_parEntries * getValBytes(p_valType);
+        if ((l_groupBytes > m_memBytes) || (m_memBytes % l_groupBytes != 0) ||
+            ((m_memBytes / 2) % (m_memBytes / l_groupBytes) != 0)) {
+            throw SpmNotSupported("from NnzStore, value type doesn't fit the memory block.");
+        }
+        m_valType = p_valType;
+    }
+    SpmValType getValType() const { return m_valType; }
+    // groups of m_parEntries values held by one value block
+    uint32_t getValGroups() const { return m_memBytes / (m_parEntries * getValBytes(m_valType)); }
+
+    // p_nnzArr holds the m_parEntries values of group p_groupId of a channel partition, a new value block is started
+    // for the first group of each block. Returns the byte location of the first value.
+    uint32_t add_nnzArr(uint32_t p_chId, const double* p_nnzArr, uint32_t p_groupId) {
+        uint32_t l_valGroups = getValGroups();
+        if (p_groupId % l_valGroups == 0) {
+            m_buf[p_chId].resize(m_buf[p_chId].size() + m_memBytes, 0);
+        }
+        uint32_t l_valBytes = getValBytes(m_valType);
+        uint32_t l_byteLoc =
+            m_buf[p_chId].size() - m_memBytes + (p_groupId % l_valGroups) * m_parEntries * l_valBytes;
+        for (uint32_t i = 0; i < m_parEntries; i++) {
+            storeVal(m_valType, p_nnzArr[i], &m_buf[p_chId][l_byteLoc + i * l_valBytes]);
+        }
+        return l_byteLoc;
     }
-    void update_nnzArr(uint32_t p_chId, uint32_t p_byteLoc, double* p_nnzArr) {
-        double float64Arr[m_memBytes / 8];
-        for (uint32_t i = 0; i < m_memBytes / 8; i++) {
-            float64Arr[i] = p_nnzArr[i];
+    void update_nnzArr(uint32_t p_chId, uint32_t p_byteLoc, const double* p_nnzArr) {
+        uint32_t l_valBytes = getValBytes(m_valType);
+        for (uint32_t i = 0; i < m_parEntries; i++) {
+            storeVal(m_valType, p_nnzArr[i], &m_buf[p_chId][p_byteLoc + i * l_valBytes]);
         }
-        memcpy(&m_buf[p_chId][p_byteLoc], reinterpret_cast<uint8_t*>(float64Arr), m_memBytes * sizeof(uint8_t));
     }
     
 
@@ -659,6 +1074,7 @@ class NnzStore {
             int32Arr[1] = m_totalRowIdxBks[i];
             int32Arr[2] = m_totalColIdxBks[i];
             int32Arr[3] = m_totalNnzBks[i];
+            int32Arr[4] = m_valType;
 
             memcpy(&m_buf[i][0], reinterpret_cast<uint8_t*>(int32Arr), m_memBytes * sizeof(uint8_t));
         }
@@ -672,6 +1088,7 @@ class NnzStore {
             int32Arr[1] = m_totalRowIdxBks[i];
             int32Arr[2] = m_totalColIdxBks[i];
             int32Arr[3] = m_totalNnzBks[i];
+            int32Arr[4] = m_valType;
 
             memcpy(&m_buf[i][0], reinterpret_cast<uint8_t*>(int32Arr), m_memBytes * sizeof(uint8_t));
             saveBin(filenames[i], (char*)&m_buf[i][0], sizeof(uint8_t) * m_buf[i].size());
@@ -684,6 +1101,7 @@ class NnzStore {
     std::vector<uint32_t> m_totalColIdxBks;
     std::vector<uint32_t> m_totalNnzBks;
     uint32_t m_memBytes, m_parEntries, m_accLatency, m_channels;
+    SpmValType m_valType = VAL_FP64;
     std::vector<std::vector<uint8_t, alignedAllocator<uint8_t> > > m_buf;
 };
 
@@ -697,12 +1115,18 @@ struct CooMatInfo {
     std::string m_name;
     uint32_t m_m;
     uint32_t m_n;
-    uint32_t m_nnz;
+    uint64_t m_nnz;
 };
 
+// m, n and the per partition counts are 32-bit on the card, the total nnzs of a matrix may exceed 32 bits
 struct MatPartition {
-    uint32_t m_m, m_n, m_nnz;
-    uint32_t m_mPad, m_nPad, m_nnzPad;
+    uint32_t m_m, m_n;
+    uint64_t m_nnz;
+    uint32_t m_mPad, m_nPad;
+    uint64_t m_nnzPad;
+    // Signature parameters the partition was generated with
+    uint32_t m_parEntries = 0, m_accLatency = 0, m_channels = 0;
+    uint32_t m_maxRows = 0, m_maxCols = 0, m_memBits = 0;
     void* m_rbParamPtr;
     uint32_t m_rbParamSize;
     void* m_parParamPtr;
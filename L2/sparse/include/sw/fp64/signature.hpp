@@ -23,16 +23,38 @@
 #include <fstream>
 #include <assert.h>
 #include <thread>
-#include <unordered_map>
 #include "spmException.hpp"
 #include "utils.hpp"
 
 #define DIV_CEIL(x, y) (((x) + (y)-1) / (y))
 #define ZERO_VAL std::numeric_limits<uint32_t>::max()
+// data index of the padded entries
+#define ZERO_DATA std::numeric_limits<uint64_t>::max()
+#define SIG_UPDATE_BLOCK_NNZS (1 << 16)
 
 namespace xf {
 namespace sparse {
 
+// how gen_chPars splits each padded partition into row ranges for the channels
+enum ChParStrategy {
+    // each channel takes rows until it holds 1/channels of the partition nnzs, the last channel takes the rest
+    CHPAR_EVEN_SPLIT = 0,
+    // the ranges minimize the largest channel nnzs of the partition, larger ranges go to the channels with fewer
+    // memory blocks so far
+    CHPAR_BALANCED = 1
+};
+
+// reordering gen_sig applies to the matrix before partitioning it
+enum SpmReorder {
+    REORDER_NONE = 0,
+    // cols are renumbered in the order the rows first use them, when that lowers the estimated padding. x has to be
+    // given in the new col order, see getColPerm
+    REORDER_PAD = 1,
+    // rows and cols of a square matrix are renumbered with Reverse Cuthill-McKee, which keeps the entries of a row
+    // block in fewer partitions. x and y have to be permuted, see getColPerm and getRowPerm
+    REORDER_RCM = 2
+};
+
 class Signature {
    public:
     Signature() = default;
@@ -41,13 +63,15 @@ class Signature {
               uint32_t channels,
               uint32_t maxRows,
               uint32_t maxCols,
-              uint32_t memBits) {
+              uint32_t memBits,
+              ChParStrategy chParStrategy = CHPAR_EVEN_SPLIT) {
         m_parEntries = parEntries;
         m_accLatency = accLatency;
         m_channels = channels;
         m_maxRows = maxRows;
         m_maxCols = maxCols;
         m_memBits = memBits;
+        m_chParStrategy = chParStrategy;
         m_rbParam.init(m_memBits, m_channels);
         m_parParam.init(m_memBits, m_channels);
         m_nnzStore.init(m_memBits, parEntries, accLatency, m_channels);
@@ -58,160 +82,376 @@ class Signature {
               uint32_t channels,
               uint32_t maxRows,
               uint32_t maxCols,
-              uint32_t memBits) {
+              uint32_t memBits,
+              ChParStrategy chParStrategy = CHPAR_EVEN_SPLIT) {
         m_parEntries = parEntries;
         m_accLatency = accLatency;
         m_channels = channels;
         m_maxRows = maxRows;
         m_maxCols = maxCols;
         m_memBits = memBits;
+        m_chParStrategy = chParStrategy;
         m_rbParam.init(m_memBits, m_channels);
         m_parParam.init(m_memBits, m_channels);
         m_nnzStore.init(m_memBits, parEntries, accLatency, m_channels);
         m_chParSpms.resize(m_channels);
     }
 
-    SparseMatrix add_spm(std::vector<uint32_t>& p_row,
-                         std::vector<uint32_t>& p_col,
-                         std::vector<uint32_t>& p_data,
-                         uint32_t& p_m,
-                         uint32_t& p_n,
-                         uint32_t& p_nnz,
-                         uint32_t& p_minRowId,
-                         uint32_t& p_minColId) {
-        SparseMatrix l_spm;
-        l_spm.create_matrix(p_row, p_col, p_data);
-        p_m = l_spm.getM();
-        p_n = l_spm.getN();
-        p_nnz = l_spm.getNnz();
-        p_minRowId = l_spm.getMinRowId();
-        p_minColId = l_spm.getMinColId();
-        return l_spm;
-    }
-
-    void gen_rbs(SparseMatrix& p_spm, std::vector<SparseMatrix>& p_rbSpms) {
-        m_mPad = p_spm.getM();
-        m_nPad = DIV_CEIL(p_spm.getN(), m_parEntries) * m_parEntries;
-        m_rbParam.add_dummyInfo();
-        m_rbParam.m_totalRows = p_spm.getM();
-        m_rbParam.m_totalRbs = 0;
-        uint32_t l_numPars = 0;
-        uint32_t l_sId = 0;
-        uint32_t l_eId = 0;
+    // estimated padded nnzs of the row sorted p_spm with col j renumbered to p_colPerm[j], or kept when p_colPerm is
+    // empty. Each row pays m_parEntries entries per col group it uses in a partition, rounded up to
+    // m_parEntries * m_accLatency, partitions are assumed to start at multiples of m_maxCols.
+    uint64_t estimate_nnzPad(SparseMatrix& p_spm, const std::vector<uint32_t>& p_colPerm) {
+        uint64_t l_nnz = p_spm.getNnz();
+        uint32_t l_rowNnzMod = m_parEntries * m_accLatency;
+        uint32_t l_parGroups = m_maxCols / m_parEntries;
+        uint32_t l_chunks = DIV_CEIL(l_nnz, SIG_UPDATE_BLOCK_NNZS);
+        std::vector<uint64_t> l_chunkPads(l_chunks, 0);
+        const std::vector<uint32_t>& l_rows = p_spm.getRows();
+        parallelFor(m_threads, l_chunks, [&](uint32_t k) {
+            // a chunk covers the rows that start in it
+            uint64_t l_sId = (uint64_t)k * SIG_UPDATE_BLOCK_NNZS;
+            uint64_t l_eId = std::min<uint64_t>(l_nnz, l_sId + SIG_UPDATE_BLOCK_NNZS);
+            while ((l_sId > 0) && (l_sId < l_eId) && (l_rows[l_sId] == l_rows[l_sId - 1])) {
+                l_sId++;
+            }
+            while ((l_eId < l_nnz) && (l_rows[l_eId] == l_rows[l_eId - 1])) {
+                l_eId++;
+            }
+            std::vector<uint32_t> l_groups;
+            for (uint64_t i = l_sId; i < l_eId;) {
+                l_groups.clear();
+                uint64_t j = i;
+                for (; (j < l_eId) && (l_rows[j] == l_rows[i]); j++) {
+                    uint32_t l_col = p_colPerm.empty() ? p_spm.getCol(j) : p_colPerm[p_spm.getCol(j)];
+                    l_groups.push_back(l_col / m_parEntries);
+                }
+                std::sort(l_groups.begin(), l_groups.end());
+                uint32_t l_parEntries = 0;
+                for (uint32_t g = 0; g < l_groups.size(); g++) {
+                    if ((g > 0) && (l_groups[g] == l_groups[g - 1])) {
+                        continue;
+                    }
+                    if ((g > 0) && (l_groups[g] / l_parGroups != l_groups[g - 1] / l_parGroups)) {
+                        l_chunkPads[k] += DIV_CEIL(l_parEntries, l_rowNnzMod) * l_rowNnzMod;
+                        l_parEntries = 0;
+                    }
+                    l_parEntries += m_parEntries;
+                }
+                l_chunkPads[k] += DIV_CEIL(l_parEntries, l_rowNnzMod) * l_rowNnzMod;
+                i = j;
+            }
+        });
+        return std::accumulate(l_chunkPads.begin(), l_chunkPads.end(), (uint64_t)0);
+    }
+
+    // col permutation numbering the cols in the order the rows of the row sorted p_spm first use them, cols without
+    // entries come last
+    std::vector<uint32_t> gen_padColPerm(SparseMatrix& p_spm) {
+        uint32_t l_n = p_spm.getN();
+        std::vector<uint32_t> l_colPerm(l_n, ZERO_VAL);
+        uint32_t l_nextColId = 0;
+        for (uint64_t i = 0; i < p_spm.getNnz(); i++) {
+            uint32_t l_col = p_spm.getCol(i);
+            if (l_col >= l_n) {
+                throw SpmInvalidValue("Col index out of range in gen_padColPerm.");
+            }
+            if (l_colPerm[l_col] == ZERO_VAL) {
+                l_colPerm[l_col] = l_nextColId++;
+            }
+        }
+        for (uint32_t j = 0; j < l_n; j++) {
+            if (l_colPerm[j] == ZERO_VAL) {
+                l_colPerm[j] = l_nextColId++;
+            }
+        }
+        return l_colPerm;
+    }
+
+    // Reverse Cuthill-McKee permutation of the pattern of p_spm + p_spm^T, row i becomes row l_perm[i]. The
+    // breadth-first search of each connected component starts from a pseudo-peripheral row found from the row with
+    // the fewest neighbours of the component.
+    std::vector<uint32_t> gen_rcmPerm(SparseMatrix& p_spm) {
+        uint32_t l_n = p_spm.getM();
+        // sorted neighbour lists of the symmetric pattern without the diagonal
+        std::vector<uint64_t> l_adjPtr(l_n + 1, 0);
+        for (uint64_t i = 0; i < p_spm.getNnz(); i++) {
+            uint32_t l_row = p_spm.getRow(i), l_col = p_spm.getCol(i);
+            if ((l_row >= l_n) || (l_col >= l_n)) {
+                throw SpmInvalidValue("Index out of range in gen_rcmPerm.");
+            }
+            if (l_row != l_col) {
+                l_adjPtr[l_row + 1]++;
+                l_adjPtr[l_col + 1]++;
+            }
+        }
+        std::partial_sum(l_adjPtr.begin(), l_adjPtr.end(), l_adjPtr.begin());
+        std::vector<uint32_t> l_adj;
+        std::vector<uint64_t> l_pos(l_adjPtr.begin(), l_adjPtr.end() - 1);
+        try {
+            l_adj.resize(l_adjPtr[l_n]);
+        } catch (const std::bad_alloc&) {
+            throw SpmAllocFailed("Failed to allocate memory used for reordering.");
+        }
+        for (uint64_t i = 0; i < p_spm.getNnz(); i++) {
+            uint32_t l_row = p_spm.getRow(i), l_col = p_spm.getCol(i);
+            if (l_row != l_col) {
+                l_adj[l_pos[l_row]++] = l_col;
+                l_adj[l_pos[l_col]++] = l_row;
+            }
+        }
+        std::vector<uint32_t> l_deg(l_n);
+        parallelFor(m_threads, l_n, [&](uint32_t r) {
+            std::sort(l_adj.begin() + l_adjPtr[r], l_adj.begin() + l_adjPtr[r + 1]);
+            l_deg[r] = std::unique(l_adj.begin() + l_adjPtr[r], l_adj.begin() + l_adjPtr[r + 1]) -
+                       (l_adj.begin() + l_adjPtr[r]);
+        });
+
+        // l_order gets the Cuthill-McKee order, rows already in it are never visited again
+        std::vector<uint32_t> l_order;
+        l_order.reserve(l_n);
+        std::vector<uint32_t> l_mark(l_n, 0);
+        uint32_t l_stamp = 0;
+        const uint32_t l_done = ZERO_VAL;
+        // breadth-first search from p_root within its component, returns the rows of the last level in p_last and
+        // the number of levels, the visited rows are appended to p_visit when it is not nullptr
+        std::vector<uint32_t> l_level, l_next;
+        auto l_bfs = [&](uint32_t p_root, std::vector<uint32_t>& p_last, std::vector<uint32_t>* p_visit) {
+            l_stamp++;
+            l_mark[p_root] = l_stamp;
+            l_level.assign(1, p_root);
+            uint32_t l_depth = 0;
+            while (!l_level.empty()) {
+                l_depth++;
+                p_last = l_level;
+                l_next.clear();
+                for (uint32_t r : l_level) {
+                    if (p_visit != nullptr) {
+                        p_visit->push_back(r);
+                    }
+                    for (uint64_t k = l_adjPtr[r]; k < l_adjPtr[r] + l_deg[r]; k++) {
+                        uint32_t l_nb = l_adj[k];
+                        if ((l_mark[l_nb] != l_stamp) && (l_mark[l_nb] != l_done)) {
+                            l_mark[l_nb] = l_stamp;
+                            l_next.push_back(l_nb);
+                        }
+                    }
+                }
+                l_level.swap(l_next);
+            }
+            return l_depth;
+        };
+        auto l_lessDeg = [&](uint32_t a, uint32_t b) {
+            return (l_deg[a] < l_deg[b]) || ((l_deg[a] == l_deg[b]) && (a < b));
+        };
+        std::vector<uint32_t> l_comp, l_last;
+        for (uint32_t i = 0; i < l_n; i++) {
+            if (l_mark[i] == l_done) {
+                continue;
+            }
+            l_comp.clear();
+            l_bfs(i, l_last, &l_comp);
+            uint32_t l_root = *std::min_element(l_comp.begin(), l_comp.end(), l_lessDeg);
+            uint32_t l_depth = l_bfs(l_root, l_last, nullptr);
+            while (true) {
+                uint32_t l_cand = *std::min_element(l_last.begin(), l_last.end(), l_lessDeg);
+                uint32_t l_candDepth = l_bfs(l_cand, l_last, nullptr);
+                if (l_candDepth <= l_depth) {
+                    break;
+                }
+                l_root = l_cand;
+                l_depth = l_candDepth;
+            }
+            // Cuthill-McKee order of the component, the neighbours of a row are added by increasing degree
+            uint32_t l_head = l_order.size();
+            l_order.push_back(l_root);
+            l_mark[l_root] = l_done;
+            while (l_head < l_order.size()) {
+                uint32_t r = l_order[l_head++];
+                uint32_t l_sId = l_order.size();
+                for (uint64_t k = l_adjPtr[r]; k < l_adjPtr[r] + l_deg[r]; k++) {
+                    uint32_t l_nb = l_adj[k];
+                    if (l_mark[l_nb] != l_done) {
+                        l_mark[l_nb] = l_done;
+                        l_order.push_back(l_nb);
+                    }
+                }
+                std::sort(l_order.begin() + l_sId, l_order.end(), l_lessDeg);
+            }
+        }
+        std::vector<uint32_t> l_perm(l_n);
+        for (uint32_t k = 0; k < l_n; k++) {
+            l_perm[l_order[k]] = l_n - 1 - k;
+        }
+        return l_perm;
+    }
+
+    // apply the reordering selected by setReorder to p_spm, m_rowPerm and m_colPerm are left empty when the rows
+    // and cols are kept
+    void reorder(SparseMatrix& p_spm) {
+        m_rowPerm.clear();
+        m_colPerm.clear();
+        m_nnzPadEst[0] = m_nnzPadEst[1] = 0;
+        if (m_reorder == REORDER_NONE) {
+            return;
+        }
+        if (m_reorder == REORDER_RCM) {
+            if (p_spm.getM() != p_spm.getN()) {
+                throw SpmInvalidValue("RCM reordering needs a square matrix.");
+            }
+            m_rowPerm = gen_rcmPerm(p_spm);
+            p_spm.permuteRows(m_rowPerm);
+            p_spm.permuteCols(m_rowPerm);
+            m_colPerm = m_rowPerm;
+            return;
+        }
+        p_spm.setSortThreads(m_threads);
         p_spm.sort_by_row();
-        uint32_t l_minRowId = p_spm.getMinRowId();
+        std::vector<uint32_t> l_colPerm = gen_padColPerm(p_spm);
+        m_nnzPadEst[0] = estimate_nnzPad(p_spm, std::vector<uint32_t>());
+        m_nnzPadEst[1] = estimate_nnzPad(p_spm, l_colPerm);
+        if (m_nnzPadEst[1] < m_nnzPadEst[0]) {
+            p_spm.permuteCols(l_colPerm);
+            m_colPerm.swap(l_colPerm);
+        } else {
+            m_nnzPadEst[1] = m_nnzPadEst[0];
+        }
+    }
 
+    // end entry of each row block of the row sorted p_spm
+    std::vector<uint64_t> get_rbEnds(SparseMatrix& p_spm) {
+        uint64_t l_sId = 0;
+        uint64_t l_eId = 0;
+        uint32_t l_minRowId = p_spm.getMinRowId();
+        std::vector<uint64_t> l_rbEnds;
         const std::vector<uint32_t> &l_tmp = p_spm.getRows();
         auto l_up = l_tmp.begin();
         while (l_eId < p_spm.getNnz()) {
             l_up = upper_bound(l_tmp.begin(), l_tmp.end(), l_minRowId + m_maxRows, isLessEqual);
             l_eId = l_up - l_tmp.begin();
             if (l_eId > l_sId) {
-                std::vector<uint32_t> l_row = p_spm.getSubRows(l_sId, l_eId);
-                std::vector<uint32_t> l_col = p_spm.getSubCols(l_sId, l_eId);
-                std::vector<uint32_t> l_data = p_spm.getSubDatas(l_sId, l_eId);
-
-                uint32_t l_m, l_n, l_nnz, l_spmMinRowId, l_spmMinColId = 0;
-                SparseMatrix l_rbSpm = add_spm(l_row, l_col, l_data, l_m, l_n, l_nnz, l_spmMinRowId, l_spmMinColId);
-                p_rbSpms.push_back(l_rbSpm);
-                if (l_m > m_maxRows) {
-                    throw SpmParFailed("Matrix partition failed in gen_rbs.");
-                }
-                assert(l_m <= m_maxRows);
+                l_rbEnds.push_back(l_eId);
                 l_sId = l_eId;
-                m_rbParam.add_rbIdxInfo(l_spmMinRowId, l_spmMinColId, l_n, l_numPars);
-                m_rbParam.add_rbSizeInfo(l_m, l_nnz);
-                for (uint32_t i = 0; i < 6; i++) {
-                    m_rbParam.add_dummyInfo();
-                }
-                m_rbParam.m_totalRbs += 1;
                 if (l_eId < p_spm.getNnz()) {
                     l_minRowId = p_spm.getRow(l_eId);
                 }
             }
         }
+        return l_rbEnds;
     }
 
-    void genPars4Rb(unsigned int p_rbId, SparseMatrix& p_rbSpm, std::vector<SparseMatrix>& p_parSpms) {
+    void gen_rbs(SparseMatrix& p_spm, std::vector<SpmView>& p_rbs) {
+        m_mPad = p_spm.getM();
+        m_nPad = DIV_CEIL(p_spm.getN(), m_parEntries) * m_parEntries;
+        m_rbParam.add_dummyInfo();
+        m_rbParam.m_totalRows = p_spm.getM();
+        m_rbParam.m_totalRbs = 0;
+        uint32_t l_numPars = 0;
+        p_spm.setSortThreads(m_threads);
+        p_spm.sort_by_row();
+
+        // row block boundaries only depend on the sorted row list, the views are computed in parallel
+        std::vector<uint64_t> l_rbEnds = get_rbEnds(p_spm);
+        uint32_t l_totalRbs = l_rbEnds.size();
+        p_rbs.resize(l_totalRbs);
+        parallelFor(m_threads, l_totalRbs, [&](uint32_t i) {
+            p_rbs[i] = p_spm.getView((i == 0) ? 0 : l_rbEnds[i - 1], l_rbEnds[i]);
+        });
+        for (uint32_t i = 0; i < l_totalRbs; ++i) {
+            SpmView& l_rb = p_rbs[i];
+            if (l_rb.m_m > m_maxRows) {
+                throw SpmParFailed("Matrix partition failed in gen_rbs.");
+            }
+            // the nnzs of a row block are a 32-bit field of rbParam
+            if (l_rb.m_nnz > std::numeric_limits<uint32_t>::max()) {
+                throw SpmParFailed("Row block " + std::to_string(i) + " has more than 2^32 nnzs in gen_rbs.");
+            }
+            assert(l_rb.m_m <= m_maxRows);
+            m_rbParam.add_rbIdxInfo(l_rb.m_minRowId, l_rb.m_minColId, l_rb.m_n, l_numPars);
+            m_rbParam.add_rbSizeInfo(l_rb.m_m, l_rb.m_nnz);
+            for (uint32_t i = 0; i < 6; i++) {
+                m_rbParam.add_dummyInfo();
+            }
+            m_rbParam.m_totalRbs += 1;
+        }
+    }
+
+    void genPars4Rb(unsigned int p_rbId, SparseMatrix& p_spm, SpmView& p_rb, std::vector<SpmView>& p_pars) {
         std::vector<uint32_t> l_rbInfo = m_rbParam.get_rbInfo(p_rbId, 1);
-        assert(p_rbSpm.getNnz() == l_rbInfo[1]);
-        assert(p_rbSpm.getM() == l_rbInfo[0]);
-        assert(p_rbSpm.getM() <= m_maxRows);
+        assert(p_rb.m_nnz == l_rbInfo[1]);
+        assert(p_rb.m_m == l_rbInfo[0]);
+        assert(p_rb.m_m <= m_maxRows);
         uint32_t l_rbPars = 0;
-        p_rbSpm.sort_by_col();
-        uint32_t l_minColId = (p_rbSpm.getMinColId() / m_parEntries) * m_parEntries;
-        uint32_t l_sId = 0, l_eId = 0;
-        const std::vector<uint32_t>& l_tmp = p_rbSpm.getCols();
+        uint64_t l_rbEnd = p_rb.m_offset + p_rb.m_nnz;
+        p_spm.sort_by_col(p_rb.m_offset, l_rbEnd);
+        uint32_t l_minColId = (p_rb.m_minColId / m_parEntries) * m_parEntries;
+        uint64_t l_sId = p_rb.m_offset, l_eId = p_rb.m_offset;
+        const std::vector<uint32_t>& l_tmp = p_spm.getCols();
         auto l_up = l_tmp.begin();
-        while (l_eId < p_rbSpm.getNnz()) {
-            l_up = upper_bound(l_tmp.begin(), l_tmp.end(), l_minColId + m_maxCols, isLessEqual);
+        while (l_eId < l_rbEnd) {
+            l_up = upper_bound(l_tmp.begin() + p_rb.m_offset, l_tmp.begin() + l_rbEnd, l_minColId + m_maxCols,
+                               isLessEqual);
             l_eId = l_up - l_tmp.begin();
             if (l_eId > l_sId) {
-                std::vector<uint32_t> l_row = p_rbSpm.getSubRows(l_sId, l_eId);
-                std::vector<uint32_t> l_col = p_rbSpm.getSubCols(l_sId, l_eId);
-                std::vector<uint32_t> l_data = p_rbSpm.getSubDatas(l_sId, l_eId);
-                uint32_t l_m = 0, l_n = 0, l_nnz = 0, l_spmMinRowId = 0, l_spmMinColId = 0;
-                SparseMatrix l_parSpm = add_spm(l_row, l_col, l_data, l_m, l_n, l_nnz, l_spmMinRowId, l_spmMinColId);
-                p_parSpms.push_back(l_parSpm);
-                if ((l_m > m_maxRows) || (l_n > m_maxCols)) {
+                SpmView l_par = p_spm.getView(l_sId, l_eId);
+                p_pars.push_back(l_par);
+                if ((l_par.m_m > m_maxRows) || (l_par.m_n > m_maxCols)) {
                     throw SpmParFailed("Matrix partition failed in genPars4Rb.");
                 }
-                assert(l_m <= m_maxRows);
-                assert(l_n <= m_maxCols);
+                assert(l_par.m_m <= m_maxRows);
+                assert(l_par.m_n <= m_maxCols);
                 l_sId = l_eId;
                 l_rbPars += 1;
-                if (l_eId < p_rbSpm.getNnz()) {
-                    l_minColId = (p_rbSpm.getCol(l_eId) / m_parEntries) * m_parEntries;
+                if (l_eId < l_rbEnd) {
+                    l_minColId = (p_spm.getCol(l_eId) / m_parEntries) * m_parEntries;
                 }
             }
         }
         m_rbParam.set_numPars(p_rbId, l_rbPars);
     }
-    void gen_pars(std::vector<SparseMatrix>& p_rbSpms, std::vector<SparseMatrix>& p_parSpms) {
-        uint32_t l_totalRbs = p_rbSpms.size();
-        std::vector<std::vector<SparseMatrix> > l_parSpms(l_totalRbs);
-#pragma omp parallel for schedule(dynamic)
-        for (uint32_t i = 0; i < l_totalRbs; ++i) {
-            genPars4Rb(i, p_rbSpms[i], l_parSpms[i]);
-        }
+    void gen_pars(SparseMatrix& p_spm, std::vector<SpmView>& p_rbs, std::vector<SpmView>& p_pars) {
+        uint32_t l_totalRbs = p_rbs.size();
+        std::vector<std::vector<SpmView> > l_pars(l_totalRbs);
+        parallelFor(m_threads, l_totalRbs, [&](uint32_t i) { genPars4Rb(i, p_spm, p_rbs[i], l_pars[i]); });
         for (uint32_t i = 0; i < l_totalRbs; ++i) {
-            p_parSpms.insert(p_parSpms.end(), l_parSpms[i].begin(), l_parSpms[i].end());
+            p_pars.insert(p_pars.end(), l_pars[i].begin(), l_pars[i].end());
         }
     }
 
-    void pad_par(SparseMatrix& p_parSpm, SparseMatrix& p_paddedParSpm) {
-        uint32_t l_nnzs = p_parSpm.getNnz();
-
-        std::vector<uint32_t> l_row;
-        std::vector<uint32_t> l_col;
-        std::vector<uint32_t> l_data;
-        std::unordered_map<int, int> l_rowNnzs;
-        for (uint32_t i = 0; i < l_nnzs; i++) {
-            uint32_t r = p_parSpm.getRow(i);
-            ++l_rowNnzs[r];
-        }
-        uint32_t l_sId = 0;
+    // pad the row sorted partition p_par, padded entries are written to p_row, p_col and p_data when they are not
+    // nullptr, returns the number of padded entries
+    uint64_t pad_par(SparseMatrix& p_spm, SpmView& p_par, uint32_t* p_row, uint32_t* p_col, uint64_t* p_data) {
+        uint64_t l_nnzs = p_par.m_nnz;
+        uint64_t l_padNnzs = 0;
+        auto l_add = [&](uint32_t p_rowId, uint32_t p_colId, uint64_t p_dataItem) {
+            if (p_row != nullptr) {
+                p_row[l_padNnzs] = p_rowId;
+                p_col[l_padNnzs] = p_colId;
+                p_data[l_padNnzs] = p_dataItem;
+            }
+            l_padNnzs++;
+        };
+        uint64_t l_sId = p_par.m_offset;
         while (l_nnzs > 0) {
-            uint32_t l_rowId = p_parSpm.getRow(l_sId);
-            uint32_t l_cRowNnzs = l_rowNnzs[l_rowId];
+            uint32_t l_rowId = p_spm.getRow(l_sId);
+            uint32_t l_cRowNnzs = 1;
+            while ((l_cRowNnzs < l_nnzs) && (p_spm.getRow(l_sId + l_cRowNnzs) == l_rowId)) {
+                l_cRowNnzs++;
+            }
             l_nnzs -= l_cRowNnzs;
             uint32_t l_modId = 0;
             uint32_t l_idx = 0;
-            uint32_t l_colIdBase = (p_parSpm.getCol(l_sId) / m_parEntries) * m_parEntries;
+            uint32_t l_colIdBase = (p_spm.getCol(l_sId) / m_parEntries) * m_parEntries;
             uint32_t l_rRowNnzs = 0;
             while (l_idx < l_cRowNnzs) {
-                uint32_t l_dataItem = p_parSpm.getData(l_sId + l_idx);
-                uint32_t l_colId = p_parSpm.getCol(l_sId + l_idx);
+                uint64_t l_dataItem = p_spm.getData(l_sId + l_idx);
+                uint32_t l_colId = p_spm.getCol(l_sId + l_idx);
                 if (l_modId == 0) {
                     l_colIdBase = (l_colId / m_parEntries) * m_parEntries;
                 }
-                l_row.push_back(l_rowId);
                 if (l_colId != (l_colIdBase + l_modId)) {
-                    l_col.push_back(l_colIdBase + l_modId);
-                    l_data.push_back(ZERO_VAL);
+                    l_add(l_rowId, l_colIdBase + l_modId, ZERO_DATA);
                 } else {
-                    l_col.push_back(l_colId);
-                    l_data.push_back(l_dataItem);
+                    l_add(l_rowId, l_colId, l_dataItem);
                     l_idx += 1;
                 }
                 l_rRowNnzs += 1;
@@ -220,72 +460,195 @@ class Signature {
             l_sId += l_cRowNnzs;
 
             while ((l_rRowNnzs % (m_parEntries * m_accLatency)) != 0) {
-                l_row.push_back(l_rowId);
-                l_col.push_back(l_colIdBase + l_modId);
-                l_data.push_back(ZERO_VAL);
+                l_add(l_rowId, l_colIdBase + l_modId, ZERO_DATA);
                 l_modId = (l_modId + 1) % m_parEntries;
                 l_rRowNnzs += 1;
             }
         }
-        p_paddedParSpm.create_matrix(l_row, l_col, l_data);
-    }
-
-    void create_padPar(unsigned int p_id, SparseMatrix& p_parSpm, SparseMatrix& p_paddedParSpm) {
-        p_parSpm.sort_by_row();
-        pad_par(p_parSpm, p_paddedParSpm);
+        return l_padNnzs;
     }
 
-    void gen_paddedPars(std::vector<SparseMatrix>& p_rbSpms, std::vector<SparseMatrix>& p_paddedParSpms) {
-        std::vector<SparseMatrix> l_parSpms;
-        gen_pars(p_rbSpms, l_parSpms);
-
-        unsigned int l_size = l_parSpms.size();
-        p_paddedParSpms.resize(l_size);
+    // pad all partitions of p_spm into one COO buffer p_padSpm, p_paddedPars are views of p_padSpm
+    void gen_paddedPars(SparseMatrix& p_spm,
+                        std::vector<SpmView>& p_rbs,
+                        SparseMatrix& p_padSpm,
+                        std::vector<SpmView>& p_paddedPars) {
+        std::vector<SpmView> l_pars;
+        gen_pars(p_spm, p_rbs, l_pars);
 
-#pragma omp parallel for schedule(dynamic)
+        unsigned int l_size = l_pars.size();
+        std::vector<uint64_t> l_padOffsets(l_size + 1, 0);
+        parallelFor(m_threads, l_size, [&](uint32_t i) {
+            p_spm.sort_by_row(l_pars[i].m_offset, l_pars[i].m_offset + l_pars[i].m_nnz);
+            l_padOffsets[i + 1] = pad_par(p_spm, l_pars[i], nullptr, nullptr, nullptr);
+        });
         for (unsigned int i = 0; i < l_size; i++) {
-            create_padPar(i, l_parSpms[i], p_paddedParSpms[i]);
+            // the nnzs of a partition and of its channel partitions are 32-bit fields of parParam
+            if (l_padOffsets[i + 1] > std::numeric_limits<uint32_t>::max()) {
+                throw SpmParFailed("Partition " + std::to_string(i) + " has more than 2^32 nnzs in gen_paddedPars.");
+            }
+            l_padOffsets[i + 1] += l_padOffsets[i];
         }
+        p_padSpm.resizeEntries(l_padOffsets[l_size]);
+        p_paddedPars.resize(l_size);
+        parallelFor(m_threads, l_size, [&](uint32_t i) {
+            uint64_t l_off = l_padOffsets[i];
+            pad_par(p_spm, l_pars[i], p_padSpm.m_row_list.data() + l_off, p_padSpm.m_col_list.data() + l_off,
+                    p_padSpm.m_data_list.data() + l_off);
+            p_paddedPars[i] = p_padSpm.getView(l_off, l_padOffsets[i + 1]);
+        });
     }
 
-    void gen_chPars(std::vector<SparseMatrix>& p_paddedParSpms, std::vector<std::vector<SparseMatrix> >& p_chParSpms) {
-        m_parParam.add_dummyInfo();
-        uint32_t l_totalPars = p_paddedParSpms.size();
-        for (uint32_t i = 0; i < l_totalPars; i++) {
-            SparseMatrix l_parSpm = p_paddedParSpms[i];
-            assert(l_parSpm.getMinColId() % m_parEntries == 0);
-            uint32_t l_baseParAddr = l_parSpm.getMinColId() / m_parEntries;
-            uint32_t l_colBks = DIV_CEIL(l_parSpm.getN(), m_parEntries);
-            uint32_t l_rows = l_parSpm.getM();
-            uint32_t l_nnzs = l_parSpm.getNnz();
+    // memory blocks a channel partition with p_nnzs padded entries takes in m_nnzStore, see gen_nnzStore,
+    // p_idxBits is its entry of parParam block 7, see SpmIdxType
+    uint32_t get_chParBks(uint32_t p_nnzs, uint32_t p_idxBits = 0) const {
+        uint32_t l_rowBkIdxs = m_memBits / getIdxBits(p_idxBits & 0xff);
+        uint32_t l_colBkIdxs = m_memBits / getIdxBits(p_idxBits >> 8);
+        return DIV_CEIL(p_nnzs, l_rowBkIdxs * m_parEntries * m_accLatency) +
+               DIV_CEIL(p_nnzs, l_colBkIdxs * m_parEntries) +
+               DIV_CEIL(p_nnzs / m_parEntries, m_nnzStore.getValGroups());
+    }
+    // index encoding of channel p_chId of partition p_parId, see SpmIdxType
+    uint32_t get_chParIdxBits(uint32_t p_parId, uint32_t p_chId) const {
+        return (m_idxType == IDX_U16) ? 0 : m_chParIdxBits[p_parId * m_channels + p_chId];
+    }
+    // narrowest delta width of the index stream (p_list[i] / p_div - p_base) of a channel partition, i steps by
+    // p_gap over the p_nnzs padded entries, 0 when 16-bit indices are needed
+    static uint32_t get_deltaBits(
+        const uint32_t* p_list, uint32_t p_gap, uint32_t p_nnzs, uint32_t p_div, uint32_t p_base) {
+        int64_t l_minDelta = 0, l_maxDelta = 0, l_prevIdx = 0;
+        for (uint32_t i = 0; i < p_nnzs; i += p_gap) {
+            int64_t l_idx = (int64_t)(p_list[i] / p_div) - p_base;
+            l_minDelta = std::min(l_minDelta, l_idx - l_prevIdx);
+            l_maxDelta = std::max(l_maxDelta, l_idx - l_prevIdx);
+            l_prevIdx = l_idx;
+        }
+        return getDeltaBits(l_minDelta, l_maxDelta);
+    }
+
+    // split the padded partition p_par into m_channels row ranges, p_ends gets the end entry of each range relative
+    // to p_par.m_offset
+    void split_par(SparseMatrix& p_padSpm, SpmView& p_par, uint32_t* p_ends) {
+        uint32_t l_nnzs = p_par.m_nnz;
+        if (m_chParStrategy == CHPAR_EVEN_SPLIT) {
             uint32_t l_nnzsPerCh = l_nnzs / m_channels;
-            m_nnzPad += l_nnzs;
             uint32_t l_sId = 0, l_eId = 0;
-            uint32_t l_chBaseAddr[m_channels];
-            memset(l_chBaseAddr, 0, m_channels * sizeof(uint32_t));
-            uint32_t l_chCols[m_channels];
-            memset(l_chCols, 0, m_channels * sizeof(uint32_t));
-            uint32_t l_chNnzs[m_channels];
-            memset(l_chNnzs, 0, m_channels * sizeof(uint32_t));
             for (uint32_t c = 0; c < m_channels; c++) {
-                if ((c == m_channels - 1) || (l_sId + l_nnzsPerCh >= l_parSpm.getNnz())) {
-                    l_eId = l_parSpm.getNnz();
+                if ((c == m_channels - 1) || (l_sId + l_nnzsPerCh >= l_nnzs)) {
+                    l_eId = l_nnzs;
                 } else {
                     l_eId = l_sId + l_nnzsPerCh;
                 }
-                while ((l_eId > 0) && (l_eId < l_parSpm.getNnz()) &&
-                        (l_parSpm.getRow(l_eId) == l_parSpm.getRow(l_eId - 1))) {
+                while ((l_eId > 0) && (l_eId < l_nnzs) &&
+                       (p_padSpm.getRow(p_par.m_offset + l_eId) == p_padSpm.getRow(p_par.m_offset + l_eId - 1))) {
                     l_eId += 1;
                 }
+                p_ends[c] = l_eId;
+                l_sId = l_eId;
+            }
+            return;
+        }
+        // end entry of each row, the padded partition is row sorted
+        std::vector<uint32_t> l_rowEnds;
+        uint32_t l_maxRowNnzs = 0;
+        for (uint32_t i = 1; i <= l_nnzs; i++) {
+            if ((i == l_nnzs) || (p_padSpm.getRow(p_par.m_offset + i) != p_padSpm.getRow(p_par.m_offset + i - 1))) {
+                uint32_t l_sId = l_rowEnds.empty() ? 0 : l_rowEnds.back();
+                l_maxRowNnzs = std::max(l_maxRowNnzs, i - l_sId);
+                l_rowEnds.push_back(i);
+            }
+        }
+        // greedy ranges whose nnzs do not exceed p_limit, returns the number of ranges
+        auto l_fill = [&](uint32_t p_limit, uint32_t* p_rangeEnds) {
+            uint32_t l_ranges = 0, l_sId = 0;
+            for (uint32_t r = 0; r < l_rowEnds.size(); r++) {
+                if (l_rowEnds[r] - l_sId > p_limit) {
+                    if (p_rangeEnds != nullptr) {
+                        p_rangeEnds[l_ranges] = l_rowEnds[r - 1];
+                    }
+                    l_ranges++;
+                    l_sId = l_rowEnds[r - 1];
+                }
+            }
+            if (p_rangeEnds != nullptr) {
+                p_rangeEnds[l_ranges] = l_nnzs;
+            }
+            return l_ranges + 1;
+        };
+        // smallest largest range that still fits into m_channels ranges
+        uint32_t l_low = std::max(l_maxRowNnzs, DIV_CEIL(l_nnzs, m_channels)), l_high = l_nnzs;
+        while (l_low < l_high) {
+            uint32_t l_mid = l_low + (l_high - l_low) / 2;
+            if (l_fill(l_mid, nullptr) <= m_channels) {
+                l_high = l_mid;
+            } else {
+                l_low = l_mid + 1;
+            }
+        }
+        uint32_t l_ranges = (l_nnzs == 0) ? 0 : l_fill(l_low, p_ends);
+        for (uint32_t c = l_ranges; c < m_channels; c++) {
+            p_ends[c] = l_nnzs;
+        }
+    }
 
-                std::vector<uint32_t> l_row = l_parSpm.getSubRows(l_sId, l_eId);
-                std::vector<uint32_t> l_col = l_parSpm.getSubCols(l_sId, l_eId);
-                std::vector<uint32_t> l_data = l_parSpm.getSubDatas(l_sId, l_eId);
-
+    // channel partitions are computed in parallel and staged per partition, parParam is then filled in
+    // partition order
+    void gen_chPars(SparseMatrix& p_padSpm,
+                    std::vector<SpmView>& p_paddedPars,
+                    std::vector<std::vector<SpmView> >& p_chPars) {
+        m_parParam.add_dummyInfo();
+        uint32_t l_totalPars = p_paddedPars.size();
+        for (uint32_t c = 0; c < m_channels; c++) {
+            p_chPars[c].resize(l_totalPars);
+        }
+        std::vector<uint32_t> l_parChBaseAddr(l_totalPars * m_channels, 0);
+        std::vector<uint32_t> l_parChCols(l_totalPars * m_channels, 0);
+        std::vector<uint32_t> l_parChNnzs(l_totalPars * m_channels, 0);
+        std::vector<uint32_t> l_parRangeEnds(l_totalPars * m_channels, 0);
+        parallelFor(m_threads, l_totalPars, [&](uint32_t i) {
+            split_par(p_padSpm, p_paddedPars[i], &l_parRangeEnds[i * m_channels]);
+        });
+        // range r of partition i goes to channel l_parChRanges[i * m_channels + r]
+        std::vector<uint32_t> l_parChRanges(l_totalPars * m_channels, 0);
+        for (uint32_t i = 0; i < l_totalPars; i++) {
+            std::iota(l_parChRanges.begin() + i * m_channels, l_parChRanges.begin() + (i + 1) * m_channels, 0);
+        }
+        if (m_chParStrategy == CHPAR_BALANCED) {
+            // the largest range goes to the channel with the fewest blocks so far
+            std::vector<uint64_t> l_chBks(m_channels, 0);
+            std::vector<uint32_t> l_ranges(m_channels), l_chs(m_channels), l_rangeBks(m_channels);
+            for (uint32_t i = 0; i < l_totalPars; i++) {
+                const uint32_t* l_ends = &l_parRangeEnds[i * m_channels];
+                for (uint32_t r = 0; r < m_channels; r++) {
+                    l_rangeBks[r] = get_chParBks(l_ends[r] - ((r == 0) ? 0 : l_ends[r - 1]));
+                }
+                std::iota(l_ranges.begin(), l_ranges.end(), 0);
+                std::iota(l_chs.begin(), l_chs.end(), 0);
+                std::stable_sort(l_ranges.begin(), l_ranges.end(),
+                                 [&](uint32_t a, uint32_t b) { return l_rangeBks[a] > l_rangeBks[b]; });
+                std::stable_sort(l_chs.begin(), l_chs.end(),
+                                 [&](uint32_t a, uint32_t b) { return l_chBks[a] < l_chBks[b]; });
+                for (uint32_t k = 0; k < m_channels; k++) {
+                    l_parChRanges[i * m_channels + l_ranges[k]] = l_chs[k];
+                    l_chBks[l_chs[k]] += l_rangeBks[l_ranges[k]];
+                }
+            }
+        }
+        parallelFor(m_threads, l_totalPars, [&](uint32_t i) {
+            SpmView& l_par = p_paddedPars[i];
+            assert(l_par.m_minColId % m_parEntries == 0);
+            uint32_t l_baseParAddr = l_par.m_minColId / m_parEntries;
+            uint32_t l_sId = 0;
+            uint32_t* l_chBaseAddr = &l_parChBaseAddr[i * m_channels];
+            uint32_t* l_chCols = &l_parChCols[i * m_channels];
+            uint32_t* l_chNnzs = &l_parChNnzs[i * m_channels];
+            for (uint32_t r = 0; r < m_channels; r++) {
+                uint32_t c = l_parChRanges[i * m_channels + r];
+                uint32_t l_eId = l_parRangeEnds[i * m_channels + r];
+                SpmView l_chPar = p_padSpm.getView(l_par.m_offset + l_sId, l_par.m_offset + l_eId);
                 l_sId = l_eId;
-                uint32_t l_m = 0, l_n = 0, l_nnz = 0, l_minRowId = 0, l_minColId = 0;
-                SparseMatrix l_chParSpm = add_spm(l_row, l_col, l_data, l_m, l_n, l_nnz, l_minRowId, l_minColId);
-                p_chParSpms[c].push_back(l_chParSpm);
+                p_chPars[c][i] = l_chPar;
+                uint32_t l_m = l_chPar.m_m, l_n = l_chPar.m_n, l_nnz = l_chPar.m_nnz, l_minColId = l_chPar.m_minColId;
                 assert(l_m <= m_maxRows);
                 assert(l_n <= m_maxCols);
                 assert(l_minColId % m_parEntries == 0);
@@ -298,11 +661,18 @@ class Signature {
                 l_chCols[c] = l_n;
                 l_chNnzs[c] = l_nnz;
             }
+        });
+        for (uint32_t i = 0; i < l_totalPars; i++) {
+            SpmView& l_par = p_paddedPars[i];
+            uint32_t l_baseParAddr = l_par.m_minColId / m_parEntries;
+            uint32_t l_colBks = DIV_CEIL(l_par.m_n, m_parEntries);
+            uint32_t* l_chCols = &l_parChCols[i * m_channels];
+            m_nnzPad += l_par.m_nnz;
             // assert for sum
             m_parParam.add_chInfo32(l_chCols);
-            m_parParam.add_chInfo32(l_chNnzs);
-            m_parParam.add_parInfo(l_baseParAddr, l_colBks, l_rows, l_nnzs);
-            m_parParam.add_chInfo16(l_chBaseAddr);
+            m_parParam.add_chInfo32(&l_parChNnzs[i * m_channels]);
+            m_parParam.add_parInfo(l_baseParAddr, l_colBks, l_par.m_m, l_par.m_nnz);
+            m_parParam.add_chInfo16(&l_parChBaseAddr[i * m_channels]);
             uint32_t l_chColsParEntries[m_channels];
             memset(l_chColsParEntries, 0, m_channels * sizeof(uint32_t));
 
@@ -315,61 +685,92 @@ class Signature {
         m_parParam.m_totalPars = l_totalPars;
     }
 
-    void update_rbParams(std::vector<std::vector<SparseMatrix> >& p_chParSpms) {
+    void update_rbParams(std::vector<std::vector<SpmView> >& p_chPars) {
         uint32_t l_totalRbs = m_rbParam.m_totalRbs;
-        uint32_t l_sRbParId = 0;
+        std::vector<uint32_t> l_sRbParIds(l_totalRbs + 1, 0);
         for (uint32_t rbId = 0; rbId < l_totalRbs; rbId++) {
+            l_sRbParIds[rbId + 1] = l_sRbParIds[rbId] + m_rbParam.get_rbInfo(rbId, 0)[3];
+        }
+        // each row block only writes its own entries in m_rbParam
+        parallelFor(m_threads, l_totalRbs, [&](uint32_t rbId) {
             std::vector<uint32_t> l_rbInfo = m_rbParam.get_rbInfo(rbId, 0);
             uint32_t l_sRbRowId = l_rbInfo[0];
             uint32_t l_rbNumPars = l_rbInfo[3];
+            uint32_t l_sRbParId = l_sRbParIds[rbId];
             uint32_t l_chRbMinRowId[m_channels];
             memset(l_chRbMinRowId, 0, m_channels * sizeof(uint32_t));
             uint32_t l_chRbRows[m_channels];
             memset(l_chRbRows, 0, m_channels * sizeof(uint32_t));
             uint32_t l_chRbNnzs[m_channels];
             memset(l_chRbNnzs, 0, m_channels * sizeof(uint32_t));
+            uint64_t l_sumChRbNnzs = 0;
             for (uint32_t c = 0; c < m_channels; c++) {
                 uint32_t l_minRowId = l_sRbRowId;
                 uint32_t l_endRowId = l_sRbRowId;
                 for (uint32_t parId = 0; parId < l_rbNumPars; parId++) {
                     uint32_t l_parID = l_sRbParId + parId;
-                    SparseMatrix l_chParSpm = p_chParSpms[c][l_parID];
-                    if ((l_minRowId > l_chParSpm.getMinRowId()) && (l_chParSpm.getNnz() != 0)) {
-                        l_minRowId = l_chParSpm.getMinRowId();
+                    const SpmView& l_chPar = p_chPars[c][l_parID];
+                    if ((l_minRowId > l_chPar.m_minRowId) && (l_chPar.m_nnz != 0)) {
+                        l_minRowId = l_chPar.m_minRowId;
                     }
-                    if (l_endRowId < l_chParSpm.getMinRowId() + l_chParSpm.getM()) {
-                        l_endRowId = l_chParSpm.getMinRowId() + l_chParSpm.getM();
+                    if (l_endRowId < l_chPar.m_minRowId + l_chPar.m_m) {
+                        l_endRowId = l_chPar.m_minRowId + l_chPar.m_m;
                     }
-                    l_chRbNnzs[c] = l_chRbNnzs[c] + l_chParSpm.getNnz();
+                    l_chRbNnzs[c] = l_chRbNnzs[c] + l_chPar.m_nnz;
+                    l_sumChRbNnzs += l_chPar.m_nnz;
                 }
                 l_chRbMinRowId[c] = l_minRowId - l_sRbRowId;
                 l_chRbRows[c] = l_endRowId - l_minRowId;
                 assert(l_chRbRows[c] <= m_maxRows);
             }
-            uint32_t l_sumChRbNnzs = 0;
-            for (uint32_t i = 0; i < m_channels; i++) {
-                l_sumChRbNnzs += l_chRbNnzs[i];
+            // the padded nnzs of a row block are 32-bit fields of rbParam, the channel sums are bounded by the total
+            if (l_sumChRbNnzs > std::numeric_limits<uint32_t>::max()) {
+                throw SpmParFailed("Padded row block " + std::to_string(rbId) +
+                                   " has more than 2^32 nnzs in update_rbParams.");
             }
             m_rbParam.set_numNnzs(rbId, l_sumChRbNnzs);
             m_rbParam.set_chInfo16(rbId, 0, l_chRbMinRowId);
             m_rbParam.set_chInfo16(rbId, 1, l_chRbRows);
             m_rbParam.set_chInfo32(rbId, l_chRbNnzs);
-            l_sRbParId += l_rbNumPars;
-        }
+        });
     }
 
-    void gen_nnzStore(const double* p_data) {
-        m_nnzStore.reserveMem(m_nnzPad);
-        for (uint32_t c = 0; c < m_channels; c++) {
-            m_nnzStore.add_dummyInfo(c);
-        }
+    // also records where each original nnz is stored in m_nnzStore, see update_nnzStore
+    void gen_nnzStore(SparseMatrix& p_padSpm, const double* p_data) {
         uint32_t l_memIdxWidth = m_memBits / 16;
         uint32_t l_rowIdxGap = m_parEntries * m_accLatency;
-        uint32_t l_rowIdxMod = l_memIdxWidth * l_rowIdxGap;
-        uint32_t l_colIdxMod = l_memIdxWidth * m_parEntries;
 
-#pragma omp parallel for schedule(dynamic)
+        uint32_t l_valGroups = m_nnzStore.getValGroups();
+        uint32_t l_valBytes = getValBytes(m_nnzStore.getValType());
+
+        // 16-bit indices bound the size of delta encoded ones
+        std::vector<size_t> l_chBks(m_channels, 1);
+        for (uint32_t c = 0; c < m_channels; c++) {
+            for (const SpmView& l_chPar : m_chParSpms[c]) {
+                l_chBks[c] += get_chParBks(l_chPar.m_nnz);
+            }
+            // byte locations within a channel buffer are 32-bit
+            if (l_chBks[c] * (m_memBits / 8) > std::numeric_limits<uint32_t>::max()) {
+                throw SpmNotSupported("The nnzVal buffer of channel " + std::to_string(c) + " exceeds 4 GB.");
+            }
+        }
+        m_nnzStore.reserveMem(l_chBks);
+        uint32_t l_totalPars = m_parParam.m_totalPars;
+        m_chParIdxBits.assign((m_idxType == IDX_U16) ? 0 : (size_t)l_totalPars * m_channels, 0);
+        if (m_channels > std::numeric_limits<uint8_t>::max() + 1) {
+            throw SpmNotSupported("More than 256 channels are not supported by gen_nnzStore.");
+        }
+        try {
+            m_nnzChs.assign(m_nnz, 0);
+            m_nnzByteLocs.assign(m_nnz, 0);
+        } catch (const std::bad_alloc&) {
+            throw SpmAllocFailed("Failed to allocate memory used for storing nnz locations.");
+        }
         for (uint32_t c = 0; c < m_channels; c++) {
+            m_nnzStore.add_dummyInfo(c);
+        }
+
+        parallelFor(m_threads, m_channels, [&](uint32_t c) {
             uint32_t l_sParId = 0;
             for (uint32_t rbId = 0; rbId < m_rbParam.m_totalRbs; rbId++) {
                 std::vector<uint32_t> l_rbInfo = m_rbParam.get_rbInfo(rbId, 0);
@@ -379,95 +780,122 @@ class Signature {
                     uint32_t l_parId = l_sParId + parId;
                     uint32_t l_sParColId = m_parParam.get_parInfo(l_parId)[0];
 
-                    SparseMatrix l_chParSpm = m_chParSpms[c][l_parId];
-                    m_nnzStore.m_totalRowIdxBks[c] += DIV_CEIL(l_chParSpm.getNnz(), l_rowIdxMod);
-                    m_nnzStore.m_totalColIdxBks[c] += DIV_CEIL(l_chParSpm.getNnz(), l_colIdxMod);
-                    m_nnzStore.m_totalNnzBks[c] += l_chParSpm.getNnz() / m_parEntries;
+                    const SpmView& l_chPar = m_chParSpms[c][l_parId];
+                    const uint32_t* l_row = p_padSpm.m_row_list.data() + l_chPar.m_offset;
+                    const uint32_t* l_col = p_padSpm.m_col_list.data() + l_chPar.m_offset;
+                    const uint64_t* l_data = p_padSpm.m_data_list.data() + l_chPar.m_offset;
                     uint32_t l_sChRbRowId = m_rbParam.get_chInfo16(rbId, 0)[c] + l_sRbRowId;
                     uint32_t l_sChParColId = m_parParam.get_chInfo16(l_parId, 0)[c] + l_sParColId;
+                    uint32_t l_rowBits = 0, l_colBits = 0;
+                    if (m_idxType == IDX_DELTA) {
+                        l_rowBits = get_deltaBits(l_row, l_rowIdxGap, l_chPar.m_nnz, 1, l_sChRbRowId);
+                        l_colBits = get_deltaBits(l_col, m_parEntries, l_chPar.m_nnz, m_parEntries, l_sChParColId);
+                        m_chParIdxBits[l_parId * m_channels + c] = (l_colBits << 8) | l_rowBits;
+                    }
+                    uint32_t l_rowBkIdxs = m_memBits / getIdxBits(l_rowBits);
+                    uint32_t l_colBkIdxs = m_memBits / getIdxBits(l_colBits);
+                    uint32_t l_rowIdxMod = l_rowBkIdxs * l_rowIdxGap;
+                    uint32_t l_colIdxMod = l_colBkIdxs * m_parEntries;
+                    m_nnzStore.m_totalRowIdxBks[c] += DIV_CEIL(l_chPar.m_nnz, l_rowIdxMod);
+                    m_nnzStore.m_totalColIdxBks[c] += DIV_CEIL(l_chPar.m_nnz, l_colIdxMod);
+                    m_nnzStore.m_totalNnzBks[c] += DIV_CEIL(l_chPar.m_nnz / m_parEntries, l_valGroups);
+                    int32_t l_deltas[m_memBits / 2];
+                    int64_t l_prevRowIdx = 0, l_prevColIdx = 0;
                     uint32_t l_rowIdx[l_memIdxWidth];
                     memset(l_rowIdx, 0, l_memIdxWidth * sizeof(uint32_t));
                     uint32_t l_colIdx[l_memIdxWidth];
                     memset(l_colIdx, 0, l_memIdxWidth * sizeof(uint32_t));
                     double l_nnz[m_parEntries];
                     memset(l_nnz, 0, m_parEntries * sizeof(double));
-                    for (uint32_t i = 0; i < l_chParSpm.getNnz(); i = i + m_parEntries) {
-                        if (i % l_rowIdxMod == 0) {
+                    for (uint32_t i = 0; i < l_chPar.m_nnz; i = i + m_parEntries) {
+                        if ((i % l_rowIdxMod == 0) && (l_rowBits == 0)) {
                             for (uint32_t j = 0; j < l_memIdxWidth; j++) {
-                                if (i + j * l_rowIdxGap < l_chParSpm.getNnz()) {
-                                    l_rowIdx[j] = l_chParSpm.getRow(i + j * l_rowIdxGap) - l_sChRbRowId;
+                                if (i + j * l_rowIdxGap < l_chPar.m_nnz) {
+                                    l_rowIdx[j] = l_row[i + j * l_rowIdxGap] - l_sChRbRowId;
                                 }
                             }
                             m_nnzStore.add_idxArr(c, l_rowIdx);
+                        } else if (i % l_rowIdxMod == 0) {
+                            for (uint32_t j = 0; j < l_rowBkIdxs; j++) {
+                                int64_t l_idx = l_prevRowIdx;
+                                if (i + j * l_rowIdxGap < l_chPar.m_nnz) {
+                                    l_idx = l_row[i + j * l_rowIdxGap] - l_sChRbRowId;
+                                }
+                                l_deltas[j] = l_idx - l_prevRowIdx;
+                                l_prevRowIdx = l_idx;
+                            }
+                            m_nnzStore.add_deltaArr(c, l_deltas, l_rowBits);
                         }
-                        if (i % l_colIdxMod == 0) {
+                        if ((i % l_colIdxMod == 0) && (l_colBits == 0)) {
                             for (uint32_t j = 0; j < l_memIdxWidth; j++) {
-                                if (i + j * m_parEntries < l_chParSpm.getNnz()) {
-                                    l_colIdx[j] =
-                                        l_chParSpm.getCol(i + j * m_parEntries) / m_parEntries - l_sChParColId;
+                                if (i + j * m_parEntries < l_chPar.m_nnz) {
+                                    l_colIdx[j] = l_col[i + j * m_parEntries] / m_parEntries - l_sChParColId;
                                 }
                             }
                             m_nnzStore.add_idxArr(c, l_colIdx);
+                        } else if (i % l_colIdxMod == 0) {
+                            for (uint32_t j = 0; j < l_colBkIdxs; j++) {
+                                int64_t l_idx = l_prevColIdx;
+                                if (i + j * m_parEntries < l_chPar.m_nnz) {
+                                    l_idx = (int64_t)(l_col[i + j * m_parEntries] / m_parEntries) - l_sChParColId;
+                                }
+                                l_deltas[j] = l_idx - l_prevColIdx;
+                                l_prevColIdx = l_idx;
+                            }
+                            m_nnzStore.add_deltaArr(c, l_deltas, l_colBits);
                         }
                         for (uint32_t j = 0; j < m_parEntries; j++) {
-                            uint32_t l_nnzIdx = l_chParSpm.getData(i + j);
-                            l_nnz[j] = (l_nnzIdx == ZERO_VAL) ? 0 : p_data[l_chParSpm.getData(i + j)];
+                            uint64_t l_nnzIdx = l_data[i + j];
+                            l_nnz[j] = (l_nnzIdx == ZERO_DATA) ? 0 : getValue(p_data, l_nnzIdx);
+                        }
+                        uint32_t l_byteLoc = m_nnzStore.add_nnzArr(c, l_nnz, i / m_parEntries);
+                        for (uint32_t j = 0; j < m_parEntries; j++) {
+                            uint64_t l_nnzIdx = l_data[i + j];
+                            if (l_nnzIdx != ZERO_DATA) {
+                                m_nnzChs[l_nnzIdx] = c;
+                                m_nnzByteLocs[l_nnzIdx] = l_byteLoc + j * l_valBytes;
+                            }
                         }
-                        m_nnzStore.add_nnzArr(c, l_nnz);
                     }
                 }
                 l_sParId += l_pars;
             }
-        }
+        });
         for (uint32_t c = 0; c < m_channels; c++) {
             m_nnzStore.m_totalBks[c] =
                 m_nnzStore.m_totalRowIdxBks[c] + m_nnzStore.m_totalColIdxBks[c] + m_nnzStore.m_totalNnzBks[c];
         }
+        for (uint32_t i = 0; (m_idxType != IDX_U16) && (i < l_totalPars); i++) {
+            m_parParam.set_chInfo16(i, 2, &m_chParIdxBits[i * m_channels]);
+        }
     }
+    // padded entries never change, so refreshing the values is a scatter of p_data through the locations
+    // recorded by gen_nnzStore
     void update_nnzStore(const double* p_data) {
-        std::vector<uint32_t> l_bufBytes(m_channels); 
+        uint8_t* l_bufs[m_channels];
         for (uint32_t c = 0; c < m_channels; c++) {
-            l_bufBytes[c]=m_memBits/8;
+            l_bufs[c] = m_nnzStore.m_buf[c].data();
         }
-        uint32_t l_memIdxWidth = m_memBits / 16;
-        uint32_t l_rowIdxGap = m_parEntries * m_accLatency;
-        uint32_t l_rowIdxMod = l_memIdxWidth * l_rowIdxGap;
-        uint32_t l_colIdxMod = l_memIdxWidth * m_parEntries;
-
-        for (uint32_t c = 0; c < m_channels; c++) {
-            uint32_t l_sParId = 0;
-            for (uint32_t rbId = 0; rbId < m_rbParam.m_totalRbs; rbId++) {
-                std::vector<uint32_t> l_rbInfo = m_rbParam.get_rbInfo(rbId, 0);
-                uint32_t l_pars = l_rbInfo[3];
-                uint32_t l_sRbRowId = l_rbInfo[0];
-                (void) l_sRbRowId;  // TODO: remove unused variable if not needed
-                for (uint32_t parId = 0; parId < l_pars; parId++) {
-                    uint32_t l_parId = l_sParId + parId;
-                    uint32_t l_sParColId = m_parParam.get_parInfo(l_parId)[0];
-                    (void) l_sParColId;  // TODO: remove unused variable if not needed
-                    SparseMatrix l_chParSpm = m_chParSpms[c][l_parId];
-                    double l_nnz[m_parEntries];
-                    memset(l_nnz, 0, m_parEntries * sizeof(double));
-                    for (uint32_t i = 0; i < l_chParSpm.getNnz(); i = i + m_parEntries) {
-                        if (i % l_rowIdxMod == 0) {
-                            l_bufBytes[c] += 32;
-                        }
-                        if (i % l_colIdxMod == 0) {
-                            l_bufBytes[c] += 32;
-                        }
-                        for (uint32_t j = 0; j < m_parEntries; j++) {
-                            uint32_t l_nnzIdx = l_chParSpm.getData(i + j);
-                            l_nnz[j] = (l_nnzIdx == ZERO_VAL) ? 0 : p_data[l_chParSpm.getData(i + j)];
-                        }
-                        m_nnzStore.update_nnzArr(c, l_bufBytes[c], l_nnz);
-                        l_bufBytes[c] += 32;
-                    }
+        const uint8_t* l_chs = m_nnzChs.data();
+        const uint32_t* l_byteLocs = m_nnzByteLocs.data();
+        const SpmValType l_valType = m_nnzStore.getValType();
+        uint32_t l_blocks = DIV_CEIL(m_nnz, SIG_UPDATE_BLOCK_NNZS);
+        parallelFor(m_threads, l_blocks, [&](uint32_t b) {
+            uint64_t l_sId = (uint64_t)b * SIG_UPDATE_BLOCK_NNZS;
+            uint64_t l_eId = std::min<uint64_t>(m_nnz, l_sId + SIG_UPDATE_BLOCK_NNZS);
+            if (l_valType == VAL_FP64) {
+                for (uint64_t i = l_sId; i < l_eId; ++i) {
+                    *reinterpret_cast<double*>(l_bufs[l_chs[i]] + l_byteLocs[i]) = getValue(p_data, i);
+                }
+            } else {
+                for (uint64_t i = l_sId; i < l_eId; ++i) {
+                    storeVal(l_valType, getValue(p_data, i), l_bufs[l_chs[i]] + l_byteLocs[i]);
                 }
-                l_sParId += l_pars;
             }
-        }
+        });
     }
 
+    // p_spm is sorted in place and its entries are released once the padded partitions are built
     MatPartition gen_sig(SparseMatrix& p_spm, const double* p_data) {
         m_rbParam.m_buf.clear();
         m_parParam.m_buf.clear();
@@ -481,32 +909,37 @@ class Signature {
         m_m = p_spm.m_m;
         m_n = p_spm.m_n;
         m_nnz = p_spm.m_nnz;
+        m_mirrorSrcs.swap(p_spm.m_mirrorSrcs);
+        m_dataNnz = m_nnz - m_mirrorSrcs.size();
         m_mPad = 0;
         m_nPad = 0;
         m_nnzPad = 0;
-        std::vector<SparseMatrix> l_rbSpms;
-        gen_rbs(p_spm, l_rbSpms); // write into l_rbSpms
-        assert(m_rbParam.m_totalRows == p_spm.getM());
-        std::vector<SparseMatrix> l_paddedParSpms;
-        gen_paddedPars(l_rbSpms, l_paddedParSpms); // write into l_paddedParSpms
-        for (unsigned int i=0; i<l_rbSpms.size(); ++i) {
-            l_rbSpms[i].clearAll();
+        m_stageTimes.clear();
+        TimePointType l_timer[2];
+        l_timer[0] = std::chrono::high_resolution_clock::now();
+        // always called, it also drops the perms of the previous partition
+        reorder(p_spm);
+        if (m_reorder != REORDER_NONE) {
+            addStageTime("reorder", l_timer);
         }
+        std::vector<SpmView> l_rbs;
+        gen_rbs(p_spm, l_rbs); // write into l_rbs
+        assert(m_rbParam.m_totalRows == p_spm.getM());
+        addStageTime("gen_rbs", l_timer);
+        std::vector<SpmView> l_paddedPars;
+        SparseMatrix l_padSpm;
+        gen_paddedPars(p_spm, l_rbs, l_padSpm, l_paddedPars); // write into l_padSpm and l_paddedPars
+        p_spm.clearAll();
+        addStageTime("gen_paddedPars", l_timer);
         for (unsigned int i = 0; i < m_channels; ++i) {
             m_chParSpms[i].clear();
         }
-        gen_chPars(l_paddedParSpms, m_chParSpms); // write into m_chParSpms
-        for (unsigned int i=0; i<l_paddedParSpms.size(); ++i) {
-            l_paddedParSpms[i].clearAll();
-        }
+        gen_chPars(l_padSpm, l_paddedPars, m_chParSpms); // write into m_chParSpms
+        addStageTime("gen_chPars", l_timer);
         update_rbParams(m_chParSpms);
-        gen_nnzStore(p_data);
-        for (unsigned int c = 0; c < m_channels; ++c) {
-            for (unsigned int i=0; i<m_chParSpms[c].size(); ++i) {
-                m_chParSpms[c][i].clearRowIdx();
-                m_chParSpms[c][i].clearColIdx();
-            }
-        }
+        addStageTime("update_rbParams", l_timer);
+        gen_nnzStore(l_padSpm, p_data);
+        addStageTime("gen_nnzStore", l_timer);
         m_rbParam.update_buf();
         m_parParam.update_buf();
         m_nnzStore.update_buf();
@@ -528,6 +961,12 @@ class Signature {
         l_res.m_mPad = m_mPad;
         l_res.m_nPad = m_nPad;
         l_res.m_nnzPad = m_nnzPad;
+        l_res.m_parEntries = m_parEntries;
+        l_res.m_accLatency = m_accLatency;
+        l_res.m_channels = m_channels;
+        l_res.m_maxRows = m_maxRows;
+        l_res.m_maxCols = m_maxCols;
+        l_res.m_memBits = m_memBits;
         return l_res;
     }
 
@@ -551,9 +990,112 @@ class Signature {
         l_res.m_mPad = m_mPad;
         l_res.m_nPad = m_nPad;
         l_res.m_nnzPad = m_nnzPad;
+        l_res.m_parEntries = m_parEntries;
+        l_res.m_accLatency = m_accLatency;
+        l_res.m_channels = m_channels;
+        l_res.m_maxRows = m_maxRows;
+        l_res.m_maxCols = m_maxCols;
+        l_res.m_memBits = m_memBits;
         return l_res;
     }
 
+    // restore the state gen_sig left for p_matPar, whose buffers are copied, so that update_sig can be used without
+    // partitioning the matrix again. p_nnzChs and p_nnzByteLocs are the scatter map of the p_matPar.m_nnz nnzs,
+    // p_mirrorSrcs are the p_mirrors data indices mirrored by the last p_mirrors nnzs, see getMirrorSrcs.
+    void restore_sig(const MatPartition& p_matPar,
+                     const uint8_t* p_nnzChs,
+                     const uint32_t* p_nnzByteLocs,
+                     const uint64_t* p_mirrorSrcs,
+                     uint64_t p_mirrors) {
+        uint32_t l_memBytes = m_memBits / 8;
+        if ((p_matPar.m_nnzValPtr.size() != m_channels) || (p_matPar.m_rbParamSize < l_memBytes) ||
+            (p_matPar.m_parParamSize < l_memBytes)) {
+            throw SpmInvalidValue("Invalid partition used for restoring signature.");
+        }
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            uint32_t l_valType = 0;
+            if (p_matPar.m_nnzValSize[c] >= l_memBytes) {
+                memcpy(&l_valType, reinterpret_cast<const uint8_t*>(p_matPar.m_nnzValPtr[c]) + 16, sizeof(uint32_t));
+            }
+            if ((p_matPar.m_nnzValSize[c] < l_memBytes) || (l_valType != m_nnzStore.getValType())) {
+                throw SpmInvalidValue("Invalid partition used for restoring signature.");
+            }
+        }
+        const uint32_t l_valBytes = getValBytes(m_nnzStore.getValType());
+        if (p_mirrors > p_matPar.m_nnz) {
+            throw SpmInvalidValue("Invalid scatter map used for restoring signature.");
+        }
+        for (uint64_t i = 0; i < p_mirrors; ++i) {
+            if (p_mirrorSrcs[i] >= p_matPar.m_nnz - p_mirrors) {
+                throw SpmInvalidValue("Invalid scatter map used for restoring signature.");
+            }
+        }
+        for (uint64_t i = 0; i < p_matPar.m_nnz; ++i) {
+            if ((p_nnzChs[i] >= m_channels) ||
+                (p_nnzByteLocs[i] > p_matPar.m_nnzValSize[p_nnzChs[i]] - l_valBytes)) {
+                throw SpmInvalidValue("Invalid scatter map used for restoring signature.");
+            }
+        }
+        const uint8_t* l_rbParam = reinterpret_cast<const uint8_t*>(p_matPar.m_rbParamPtr);
+        m_rbParam.m_buf.assign(l_rbParam, l_rbParam + p_matPar.m_rbParamSize);
+        memcpy(&m_rbParam.m_totalRows, &m_rbParam.m_buf[0], sizeof(uint32_t));
+        memcpy(&m_rbParam.m_totalRbs, &m_rbParam.m_buf[4], sizeof(uint32_t));
+        const uint8_t* l_parParam = reinterpret_cast<const uint8_t*>(p_matPar.m_parParamPtr);
+        m_parParam.m_buf.assign(l_parParam, l_parParam + p_matPar.m_parParamSize);
+        memcpy(&m_parParam.m_totalPars, &m_parParam.m_buf[0], sizeof(uint32_t));
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            const uint8_t* l_nnzVal = reinterpret_cast<const uint8_t*>(p_matPar.m_nnzValPtr[c]);
+            m_nnzStore.m_buf[c].assign(l_nnzVal, l_nnzVal + p_matPar.m_nnzValSize[c]);
+            memcpy(&m_nnzStore.m_totalBks[c], &m_nnzStore.m_buf[c][0], sizeof(uint32_t));
+            memcpy(&m_nnzStore.m_totalRowIdxBks[c], &m_nnzStore.m_buf[c][4], sizeof(uint32_t));
+            memcpy(&m_nnzStore.m_totalColIdxBks[c], &m_nnzStore.m_buf[c][8], sizeof(uint32_t));
+            memcpy(&m_nnzStore.m_totalNnzBks[c], &m_nnzStore.m_buf[c][12], sizeof(uint32_t));
+        }
+        m_nnzChs.assign(p_nnzChs, p_nnzChs + p_matPar.m_nnz);
+        m_nnzByteLocs.assign(p_nnzByteLocs, p_nnzByteLocs + p_matPar.m_nnz);
+        m_mirrorSrcs.assign(p_mirrorSrcs, p_mirrorSrcs + p_mirrors);
+        m_dataNnz = p_matPar.m_nnz - p_mirrors;
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            m_chParSpms[c].clear();
+        }
+        m_chParIdxBits.clear();
+        m_m = p_matPar.m_m;
+        m_n = p_matPar.m_n;
+        m_nnz = p_matPar.m_nnz;
+        m_mPad = p_matPar.m_mPad;
+        m_nPad = p_matPar.m_nPad;
+        m_nnzPad = p_matPar.m_nnzPad;
+        m_rowPerm.clear();
+        m_colPerm.clear();
+        m_stageTimes.clear();
+    }
+    // restore the permutations after restore_sig, p_rowPerm and p_colPerm hold the m and n entries of getRowPerm and
+    // getColPerm or are nullptr
+    void restore_perms(const uint32_t* p_rowPerm, const uint32_t* p_colPerm) {
+        auto l_restore = [](const uint32_t* p_perm, uint32_t p_size, std::vector<uint32_t>& p_res) {
+            p_res.clear();
+            if (p_perm == nullptr) {
+                return;
+            }
+            std::vector<bool> l_used(p_size, false);
+            for (uint32_t i = 0; i < p_size; i++) {
+                if ((p_perm[i] >= p_size) || l_used[p_perm[i]]) {
+                    throw SpmInvalidValue("Invalid permutation used for restoring signature.");
+                }
+                l_used[p_perm[i]] = true;
+            }
+            p_res.assign(p_perm, p_perm + p_size);
+        };
+        l_restore(p_rowPerm, m_m, m_rowPerm);
+        l_restore(p_colPerm, m_n, m_colPerm);
+    }
+
+    // channel and byte location in the nnz store of each original nnz, recorded by gen_sig
+    const std::vector<uint8_t>& getNnzChs() const { return m_nnzChs; }
+    const std::vector<uint32_t>& getNnzByteLocs() const { return m_nnzByteLocs; }
+    // data indices mirrored by the last nnzs of a symmetric matrix loaded with SparseMatrix::loadCscSymHalf
+    const std::vector<uint64_t>& getMirrorSrcs() const { return m_mirrorSrcs; }
+
     void store_rbParam(std::string filename) { m_rbParam.write_file(filename); }
 
     void store_parParam(std::string filename) { m_parParam.write_file(filename); }
@@ -561,6 +1103,9 @@ class Signature {
     void store_nnz(std::string* filenames) { m_nnzStore.write_file(filenames); }
 
     void store_info(std::string filename) {
+        if ((m_nnz > std::numeric_limits<uint32_t>::max()) || (m_nnzPad > std::numeric_limits<uint32_t>::max())) {
+            throw SpmNotSupported("info.dat only holds 32-bit nnzs, use storeMatParFile for larger matrices.");
+        }
         uint32_t int32Arr[6];
         memset(int32Arr, 0, 6 * sizeof(uint32_t));
         int32Arr[0] = m_m;
@@ -572,7 +1117,230 @@ class Signature {
         std::ofstream outFile(filename, std::ios::binary);
         outFile.write((char*)&int32Arr[0], sizeof(uint32_t) * 6);
     }
-    int checkUpdateDim(uint32_t p_m, uint32_t p_n, uint32_t p_nnz) {
+    // out-of-core version of gen_sig, row blocks are partitioned in batches that fit into p_memBudget bytes and
+    // each batch is appended to the signature files in p_path, the files are the same as the ones written by
+    // storeMatPar. The row sorted index lists of p_spm (row, col and data index, 16 bytes per nnz) are not counted
+    // in p_memBudget. Only the sizes are returned, update_sig can not be used after gen_sigToFiles.
+    MatPartition gen_sigToFiles(SparseMatrix& p_spm, const double* p_data, std::string p_path, size_t p_memBudget) {
+        m_m = p_spm.getM();
+        m_n = p_spm.getN();
+        m_nnz = p_spm.getNnz();
+        m_mirrorSrcs.swap(p_spm.m_mirrorSrcs);
+        m_dataNnz = m_nnz - m_mirrorSrcs.size();
+        m_mPad = m_m;
+        m_nPad = DIV_CEIL(m_n, m_parEntries) * m_parEntries;
+        m_nnzPad = 0;
+        reorder(p_spm);
+        p_spm.setSortThreads(m_threads);
+        p_spm.sort_by_row();
+        std::vector<uint64_t> l_rbEnds = get_rbEnds(p_spm);
+        uint32_t l_totalRbs = l_rbEnds.size();
+
+        uint32_t l_memBytes = m_memBits / 8;
+        std::vector<uint8_t> l_header(l_memBytes, 0);
+        std::ofstream l_rbFile(p_path + "/rbParam.dat", std::ios::binary);
+        std::ofstream l_parFile(p_path + "/parParam.dat", std::ios::binary);
+        std::vector<std::ofstream> l_nnzFiles(m_channels);
+        for (uint32_t c = 0; c < m_channels; c++) {
+            l_nnzFiles[c].open(p_path + "/nnzVal_" + std::to_string(c) + ".dat", std::ios::binary);
+        }
+        auto l_write = [&](std::ofstream& p_file, const uint8_t* p_buf, size_t p_bytes) {
+            p_file.write(reinterpret_cast<const char*>(p_buf), p_bytes);
+            if (!p_file) {
+                throw SpmInvalidValue("Failed to write signature files into " + p_path + ".");
+            }
+        };
+        l_write(l_rbFile, l_header.data(), l_memBytes);
+        l_write(l_parFile, l_header.data(), l_memBytes);
+        for (uint32_t c = 0; c < m_channels; c++) {
+            l_write(l_nnzFiles[c], l_header.data(), l_memBytes);
+        }
+
+        // estimated bytes of a batch: the copied index lists, their sort buffers, the gathered values and the nnz
+        // locations per nnz, plus the padded index lists and the nnz store per padded nnz
+        double l_bytesPerNnz = 6 * sizeof(uint32_t) + 3 * sizeof(uint64_t) + sizeof(double) + sizeof(uint8_t);
+        uint32_t l_memIdxWidth = m_memBits / 16;
+        double l_bytesPerPadNnz = 2 * sizeof(uint32_t) + sizeof(uint64_t) + getValBytes(m_nnzStore.getValType()) +
+                                  (double)l_memBytes / (l_memIdxWidth * m_parEntries) +
+                                  (double)l_memBytes / (l_memIdxWidth * m_parEntries * m_accLatency);
+        // a row entry is padded to at most m_parEntries * m_accLatency entries, the first batch assumes that bound
+        // and later batches the worst ratio of the batches before
+        double l_padRatio = m_parEntries * m_accLatency;
+        double l_maxPadRatio = 1.0;
+        uint32_t l_totalPars = 0;
+        std::vector<uint32_t> l_totalBks(m_channels, 0), l_totalRowIdxBks(m_channels, 0),
+            l_totalColIdxBks(m_channels, 0), l_totalNnzBks(m_channels, 0);
+        uint32_t l_sRbId = 0;
+        while (l_sRbId < l_totalRbs) {
+            uint64_t l_sId = (l_sRbId == 0) ? 0 : l_rbEnds[l_sRbId - 1];
+            double l_maxNnzs = p_memBudget / (l_bytesPerNnz + l_padRatio * l_bytesPerPadNnz);
+            uint32_t l_eRbId = l_sRbId + 1;
+            while ((l_eRbId < l_totalRbs) && (l_rbEnds[l_eRbId] - l_sId <= l_maxNnzs)) {
+                l_eRbId++;
+            }
+            uint64_t l_eId = l_rbEnds[l_eRbId - 1];
+
+            std::vector<uint32_t> l_rows = p_spm.getSubRows(l_sId, l_eId);
+            std::vector<uint32_t> l_cols = p_spm.getSubCols(l_sId, l_eId);
+            std::vector<uint64_t> l_datas(l_eId - l_sId);
+            std::vector<double> l_vals(l_eId - l_sId);
+            for (uint64_t i = l_sId; i < l_eId; ++i) {
+                l_datas[i - l_sId] = i - l_sId;
+                l_vals[i - l_sId] = getValue(p_data, p_spm.getData(i));
+            }
+            SparseMatrix l_batchSpm;
+            l_batchSpm.create_matrix(l_rows, l_cols, l_datas);
+            l_batchSpm.m_rowSorted = true; // a range of the row sorted p_spm
+            std::vector<uint32_t>().swap(l_rows);
+            std::vector<uint32_t>().swap(l_cols);
+            std::vector<uint64_t>().swap(l_datas);
+
+            Signature l_sig(m_parEntries, m_accLatency, m_channels, m_maxRows, m_maxCols, m_memBits, m_chParStrategy);
+            l_sig.setThreads(m_threads);
+            l_sig.setValType(m_nnzStore.getValType());
+            l_sig.setIdxType(m_idxType);
+            l_sig.gen_sig(l_batchSpm, l_vals.data()); // the batch is already reordered
+            l_write(l_rbFile, l_sig.m_rbParam.m_buf.data() + l_memBytes, l_sig.m_rbParam.m_buf.size() - l_memBytes);
+            l_write(l_parFile, l_sig.m_parParam.m_buf.data() + l_memBytes,
+                    l_sig.m_parParam.m_buf.size() - l_memBytes);
+            for (uint32_t c = 0; c < m_channels; c++) {
+                l_write(l_nnzFiles[c], l_sig.m_nnzStore.m_buf[c].data() + l_memBytes,
+                        l_sig.m_nnzStore.m_buf[c].size() - l_memBytes);
+                l_totalBks[c] += l_sig.m_nnzStore.m_totalBks[c];
+                l_totalRowIdxBks[c] += l_sig.m_nnzStore.m_totalRowIdxBks[c];
+                l_totalColIdxBks[c] += l_sig.m_nnzStore.m_totalColIdxBks[c];
+                l_totalNnzBks[c] += l_sig.m_nnzStore.m_totalNnzBks[c];
+            }
+            l_totalPars += l_sig.m_parParam.m_totalPars;
+            m_nnzPad += l_sig.m_nnzPad;
+            l_maxPadRatio = std::max(l_maxPadRatio, (double)l_sig.m_nnzPad / (l_eId - l_sId));
+            l_padRatio = l_maxPadRatio;
+            l_sRbId = l_eRbId;
+        }
+
+        MatPartition l_res;
+        uint32_t* l_int32Arr = reinterpret_cast<uint32_t*>(l_header.data());
+        l_int32Arr[0] = m_m;
+        l_int32Arr[1] = l_totalRbs;
+        l_rbFile.seekp(0, std::ios::end);
+        l_res.m_rbParamPtr = nullptr;
+        l_res.m_rbParamSize = l_rbFile.tellp();
+        l_rbFile.seekp(0);
+        l_write(l_rbFile, l_header.data(), l_memBytes);
+        l_int32Arr[0] = l_totalPars;
+        l_int32Arr[1] = 0;
+        l_parFile.seekp(0, std::ios::end);
+        l_res.m_parParamPtr = nullptr;
+        l_res.m_parParamSize = l_parFile.tellp();
+        l_parFile.seekp(0);
+        l_write(l_parFile, l_header.data(), l_memBytes);
+        for (uint32_t c = 0; c < m_channels; c++) {
+            m_nnzStore.m_totalBks[c] = l_totalBks[c];
+            l_int32Arr[0] = l_totalBks[c];
+            l_int32Arr[1] = l_totalRowIdxBks[c];
+            l_int32Arr[2] = l_totalColIdxBks[c];
+            l_int32Arr[3] = l_totalNnzBks[c];
+            l_int32Arr[4] = m_nnzStore.getValType();
+            l_nnzFiles[c].seekp(0, std::ios::end);
+            l_res.m_nnzValPtr.push_back(nullptr);
+            l_res.m_nnzValSize.push_back(l_nnzFiles[c].tellp());
+            l_nnzFiles[c].seekp(0);
+            l_write(l_nnzFiles[c], l_header.data(), l_memBytes);
+        }
+        p_spm.clearAll();
+        m_rbParam.m_buf.clear();
+        m_parParam.m_buf.clear();
+        for (uint32_t c = 0; c < m_channels; c++) {
+            m_nnzStore.m_buf[c].clear();
+        }
+        m_nnzChs.clear();
+        m_nnzByteLocs.clear();
+        m_mirrorSrcs.clear();
+        if ((m_nnz <= std::numeric_limits<uint32_t>::max()) && (m_nnzPad <= std::numeric_limits<uint32_t>::max())) {
+            store_info(p_path + "/info.dat");
+        } else {
+            std::cout << "WARNING: info.dat is not written, the nnzs of the matrix exceed 32 bits." << std::endl;
+        }
+        l_res.m_m = m_m;
+        l_res.m_n = m_n;
+        l_res.m_nnz = m_nnz;
+        l_res.m_mPad = m_mPad;
+        l_res.m_nPad = m_nPad;
+        l_res.m_nnzPad = m_nnzPad;
+        l_res.m_parEntries = m_parEntries;
+        l_res.m_accLatency = m_accLatency;
+        l_res.m_channels = m_channels;
+        l_res.m_maxRows = m_maxRows;
+        l_res.m_maxCols = m_maxCols;
+        l_res.m_memBits = m_memBits;
+        return l_res;
+    }
+
+    // number of threads used by gen_sig, 0 means all hardware threads
+    void setThreads(unsigned int p_threads) { m_threads = p_threads; }
+    unsigned int getThreads() { return getNumThreads(m_threads); }
+
+    ChParStrategy getChParStrategy() const { return m_chParStrategy; }
+
+    // reordering applied by gen_sig and gen_sigToFiles, REORDER_NONE by default
+    void setReorder(SpmReorder p_reorder) { m_reorder = p_reorder; }
+    SpmReorder getReorder() const { return m_reorder; }
+    // storage of the values in the nnzVal buffers written by gen_sig and gen_sigToFiles, VAL_FP64 by default
+    void setValType(SpmValType p_valType) { m_nnzStore.setValType(p_valType); }
+    SpmValType getValType() const { return m_nnzStore.getValType(); }
+    // encoding of the index blocks written by gen_sig and gen_sigToFiles, IDX_U16 by default
+    void setIdxType(SpmIdxType p_idxType) { m_idxType = p_idxType; }
+    SpmIdxType getIdxType() const { return m_idxType; }
+    // new col index of each col of the last partitioned matrix, x[j] has to be moved to entry getColPerm()[j] of the
+    // x given to the kernel. Empty when the cols are kept.
+    const std::vector<uint32_t>& getColPerm() const { return m_colPerm; }
+    // new row index of each row, entry getRowPerm()[i] of the y computed by the kernel is y[i]. Empty when the rows
+    // are kept.
+    const std::vector<uint32_t>& getRowPerm() const { return m_rowPerm; }
+    // number of row blocks and partitions of the last partitioned matrix
+    uint32_t getTotalRbs() const { return m_rbParam.m_totalRbs; }
+    uint32_t getTotalPars() const { return m_parParam.m_totalPars; }
+    // estimated padded nnzs before and after the last reordering, see estimate_nnzPad, 0 without reordering
+    uint64_t getNnzPadEst(unsigned int p_after) const { return m_nnzPadEst[p_after]; }
+
+    // memory blocks each channel streams for the last partitioned matrix, the largest one bounds the spmv latency
+    std::vector<uint32_t> getChTotalBks() const {
+        return std::vector<uint32_t>(m_nnzStore.m_totalBks.begin(), m_nnzStore.m_totalBks.begin() + m_channels);
+    }
+    // row and col index blocks each channel streams for the last partitioned matrix
+    std::vector<uint32_t> getChIdxBks() const {
+        std::vector<uint32_t> l_bks(m_channels);
+        for (uint32_t c = 0; c < m_channels; c++) {
+            l_bks[c] = m_nnzStore.m_totalRowIdxBks[c] + m_nnzStore.m_totalColIdxBks[c];
+        }
+        return l_bks;
+    }
+    // largest over average channel blocks of the last partitioned matrix, 1 is a perfect balance
+    double getChImbalance() const {
+        std::vector<uint32_t> l_bks = getChTotalBks();
+        double l_sum = std::accumulate(l_bks.begin(), l_bks.end(), 0.0);
+        return (l_sum == 0) ? 1.0 : *std::max_element(l_bks.begin(), l_bks.end()) * m_channels / l_sum;
+    }
+
+    // sum over all partitions of the largest channel blocks of the partition, the channels finish a partition
+    // together, so this bounds the spmv latency when the partitions are not overlapped
+    uint64_t getParMaxChBks() const {
+        uint64_t l_bks = 0;
+        uint32_t l_totalPars = m_chParSpms.empty() ? 0 : m_chParSpms[0].size();
+        for (uint32_t i = 0; i < l_totalPars; i++) {
+            uint32_t l_maxBks = 0;
+            for (uint32_t c = 0; c < m_channels; c++) {
+                l_maxBks = std::max(l_maxBks, get_chParBks(m_chParSpms[c][i].m_nnz, get_chParIdxBits(i, c)));
+            }
+            l_bks += l_maxBks;
+        }
+        return l_bks;
+    }
+
+    // (stage name, time in ms) of each gen_sig stage of the last partitioned matrix
+    const std::vector<std::pair<std::string, double> >& getStageTimes() const { return m_stageTimes; }
+
+    int checkUpdateDim(uint32_t p_m, uint32_t p_n, uint64_t p_nnz) {
         if ((p_m == m_m) && (p_n == m_n) && (p_nnz == m_nnz)) {
             return 0;
         }
@@ -583,13 +1351,43 @@ class Signature {
     }
 
    private:
-    uint32_t m_m, m_n, m_nnz = 0;
-    uint32_t m_mPad, m_nPad, m_nnzPad = 0;
+    // value of data index p_idx, data indices past the given values belong to mirrored entries
+    double getValue(const double* p_data, uint64_t p_idx) const {
+        return (p_idx < m_dataNnz) ? p_data[p_idx] : p_data[m_mirrorSrcs[p_idx - m_dataNnz]];
+    }
+    // record the time since p_timer[0] for p_stage and restart the timer
+    void addStageTime(std::string p_stage, TimePointType p_timer[2]) {
+        p_timer[1] = std::chrono::high_resolution_clock::now();
+        std::chrono::duration<double> l_durationSec = p_timer[1] - p_timer[0];
+        m_stageTimes.push_back(std::make_pair(p_stage, l_durationSec.count() * 1e3));
+        p_timer[0] = p_timer[1];
+    }
+
+   private:
+    uint32_t m_m, m_n;
+    uint64_t m_nnz = 0;
+    uint32_t m_mPad, m_nPad;
+    uint64_t m_nnzPad = 0;
     uint32_t m_parEntries, m_accLatency, m_channels, m_maxRows, m_maxCols, m_memBits;
+    ChParStrategy m_chParStrategy = CHPAR_EVEN_SPLIT;
+    SpmReorder m_reorder = REORDER_NONE;
+    SpmIdxType m_idxType = IDX_U16;
+    // parParam block 7 entry of each channel partition, empty for IDX_U16
+    std::vector<uint32_t> m_chParIdxBits;
+    std::vector<uint32_t> m_rowPerm, m_colPerm;
+    uint64_t m_nnzPadEst[2] = {0, 0};
     RowBlockParam m_rbParam;
     ParParam m_parParam;
     NnzStore m_nnzStore;
-    std::vector<std::vector<SparseMatrix> > m_chParSpms;
+    // channel and byte location in m_nnzStore of each original nnz
+    std::vector<uint8_t> m_nnzChs;
+    std::vector<uint32_t> m_nnzByteLocs;
+    // number of values given to gen_sig and the data index mirrored by each nnz past them
+    uint64_t m_dataNnz = 0;
+    std::vector<uint64_t> m_mirrorSrcs;
+    std::vector<std::vector<SpmView> > m_chParSpms;
+    unsigned int m_threads = 0; // 0: use all hardware threads
+    std::vector<std::pair<std::string, double> > m_stageTimes;
 };
 
 }
@@ -17,16 +17,35 @@
 #ifndef XILINX_APPS_SPARSE_SPMVHOST_HPP
 #define XILINX_APPS_SPARSE_SPMVHOST_HPP
 
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 #include "sw/xNativeFPGA.hpp"
 #include "sw/fp64/spmException.hpp"
+#include "sw/fp64/matrix_params.hpp"
 
 namespace xilinx_apps {
 namespace sparse {
 
-template <unsigned int t_NumChannels>
+/**
+ * @brief SpmvHost drives the spmv kernels over a signature that stays resident on the card
+ *
+ * run/getY/finish compute one x vector held in the buffers created by createLoadParXbufs and createStoreYbufs.
+ * runBatch computes several x vectors against the same signature through two x and y slots created by
+ * createBatchBufs, the x of the next vector is sent and the y of the previous one read back while the kernels run.
+ * After startAsync, runAsync queues one x vector and returns at once, a host thread keeps both slots queued on the
+ * kernels so that the transfers of one vector overlap the computation of the other. The single and batched runs must
+ * not be used between startAsync and stopAsync.
+ */
+template <unsigned int t_NumChannels, unsigned int t_MemBits>
 class SpmvHost {
     public:
         SpmvHost(){}
+        ~SpmvHost() { stopAsync(); }
         void init(xilinx_apps::hpc_common::FPGA* p_fpga) {
             m_card = p_fpga;
             m_krnLoadNnz.fpga(m_card);
@@ -41,6 +60,7 @@ class SpmvHost {
             m_krnStoreY.createKernel("storeYkernel:{krnl_storeY}");
         }
         void createLoadNnzBufs(const size_t p_bytes[t_NumChannels], void* p_hostPtr[t_NumChannels]) {
+            checkNnzVal(p_bytes, p_hostPtr);
             for (unsigned int i=0; i<t_NumChannels; ++i) {
                 m_krnLoadNnz.createBOfromHostPtr(i, p_bytes[i], p_hostPtr[i]);
                 m_krnLoadNnz.setMemArg(i);
@@ -48,6 +68,7 @@ class SpmvHost {
             }
         }
         void createLoadParXbufs(const size_t p_bytes[2], void* p_hostPtr[2]) {
+            checkParParam(p_bytes[0], p_hostPtr[0]);
             for (unsigned int i=0; i<2; ++i) {
                 m_krnLoadParX.createBOfromHostPtr(i, p_bytes[i], p_hostPtr[i]);
                 m_krnLoadParX.setMemArg(i);
@@ -66,6 +87,7 @@ class SpmvHost {
         }
         void setStoreYrows(const unsigned int p_rows) {
             m_krnStoreY.setScalarArg(0, p_rows);
+            m_storeYrows = p_rows;
         }
         void sendBOs() {
             for (unsigned int i=0; i<t_NumChannels; ++i) {
@@ -90,6 +112,221 @@ class SpmvHost {
             m_krnLoadParX.wait();
             m_krnLoadRbParam.wait();
         }
+        // p_xBytes and p_yBytes are the sizes of one x and one y vector, as passed to createLoadParXbufs and
+        // createStoreYbufs for a single run; calling it again replaces the buffers, e.g. for a new x size
+        void createBatchBufs(const size_t p_xBytes, const size_t p_yBytes) {
+            if (m_asyncThread.joinable()) {
+                throw xf::sparse::SpmInvalidValue("from SpmvHost::createBatchBufs, stopAsync must be called first.");
+            }
+            for (unsigned int i=0; i<2; ++i) {
+                m_batchX[i] = m_krnLoadParX.createBO(1, getBatchBoId(1, i), p_xBytes);
+                m_batchY[i] = m_krnStoreY.createBO(1, getBatchBoId(1, i), p_yBytes);
+            }
+            m_batchXbytes = p_xBytes;
+            m_batchYbytes = p_yBytes;
+        }
+        // y = A * x for p_numVecs vectors, the signature must have been sent with sendBOs
+        void runBatch(const unsigned int p_numVecs, const void* const p_x[], void* const p_y[]) {
+            if (m_batchXbytes == 0) {
+                throw xf::sparse::SpmInvalidValue("from SpmvHost::runBatch, createBatchBufs must be called first.");
+            }
+            if (p_numVecs == 0) {
+                return;
+            }
+            sendBatchX(0, p_x[0]);
+            runBatchSlot(0);
+            for (unsigned int i=0; i<p_numVecs; ++i) {
+                unsigned int l_slot = i % 2;
+                if (i+1 < p_numVecs) {
+                    sendBatchX(1-l_slot, p_x[i+1]);
+                }
+                m_krnStoreY.wait();
+                finish();
+                if (i+1 < p_numVecs) {
+                    runBatchSlot(1-l_slot);
+                }
+                m_krnStoreY.readBO(getBatchBoId(1, l_slot));
+                memcpy(p_y[i], m_batchY[l_slot], m_batchYbytes);
+            }
+            // leave the single run buffers bound for the next run
+            if (m_krnLoadParXbufs.count(1) != 0) {
+                m_krnLoadParX.setMemArg(1);
+            }
+            if (m_krnStoreYbufs.count(1) != 0) {
+                m_krnStoreY.setMemArg(1);
+            }
+        }
+        // needs the buffers of createBatchBufs and the signature sent with sendBOs
+        void startAsync() {
+            if (m_batchXbytes == 0) {
+                throw xf::sparse::SpmInvalidValue("from SpmvHost::startAsync, createBatchBufs must be called first.");
+            }
+            if (m_asyncThread.joinable()) {
+                return;
+            }
+            m_krnLoadNnz.createRuns(2);
+            m_krnLoadParX.createRuns(2);
+            m_krnLoadRbParam.createRuns(2);
+            m_krnStoreY.createRuns(2);
+            for (unsigned int s=0; s<2; ++s) {
+                for (unsigned int i=0; i<t_NumChannels; ++i) {
+                    m_krnLoadNnz.setMemArg(i, i, s);
+                }
+                m_krnLoadParX.setMemArg(0, 0, s);
+                m_krnLoadParX.setMemArg(1, getBatchBoId(1, s), s);
+                m_krnLoadRbParam.setMemArg(0, 0, s);
+                m_krnStoreY.setScalarArg(0, m_storeYrows, s);
+                m_krnStoreY.setMemArg(1, getBatchBoId(1, s), s);
+            }
+            m_asyncStop = false;
+            m_asyncThread = std::thread(&SpmvHost::asyncLoop, this);
+        }
+        // y = A * x, p_x is copied before the call returns, p_y is written when the future is ready, after
+        // p_callback has been called from the host thread
+        std::future<void> runAsync(const void* p_x, void* p_y, std::function<void()> p_callback = nullptr) {
+            if (!m_asyncThread.joinable()) {
+                throw xf::sparse::SpmInvalidValue("from SpmvHost::runAsync, startAsync must be called first.");
+            }
+            AsyncReq l_req;
+            l_req.m_x.assign(static_cast<const uint8_t*>(p_x), static_cast<const uint8_t*>(p_x) + m_batchXbytes);
+            l_req.m_y = p_y;
+            l_req.m_callback = p_callback;
+            std::future<void> l_future = l_req.m_done.get_future();
+            {
+                std::lock_guard<std::mutex> l_lock(m_asyncMutex);
+                m_asyncQueue.push_back(std::move(l_req));
+            }
+            m_asyncCv.notify_one();
+            return l_future;
+        }
+        // returns after the queued vectors have been computed
+        void stopAsync() {
+            if (!m_asyncThread.joinable()) {
+                return;
+            }
+            {
+                std::lock_guard<std::mutex> l_lock(m_asyncMutex);
+                m_asyncStop = true;
+            }
+            m_asyncCv.notify_one();
+            m_asyncThread.join();
+        }
+
+    private:
+        static constexpr unsigned int t_MemBytes = t_MemBits / 8;
+
+        // the kernels read fp64 values and 16-bit indices only, signatures written with other value or index types
+        // are rejected instead of computing a wrong y
+        void checkNnzVal(const size_t p_bytes[t_NumChannels], void* const p_hostPtr[t_NumChannels]) const {
+            for (unsigned int c = 0; c < t_NumChannels; ++c) {
+                uint32_t l_valType = 0;
+                if (p_bytes[c] < t_MemBytes) {
+                    throw xf::sparse::SpmInvalidValue("from SpmvHost, nnzVal_" + std::to_string(c) + " is too small.");
+                }
+                memcpy(&l_valType, reinterpret_cast<const uint8_t*>(p_hostPtr[c]) + 16, sizeof(uint32_t));
+                if (l_valType != xf::sparse::VAL_FP64) {
+                    throw xf::sparse::SpmNotSupported("from SpmvHost, nnzVal_" + std::to_string(c) +
+                                                      " doesn't hold fp64 values.");
+                }
+            }
+        }
+        void checkParParam(const size_t p_bytes, const void* p_hostPtr) const {
+            const uint8_t* l_buf = reinterpret_cast<const uint8_t*>(p_hostPtr);
+            uint32_t l_totalPars = 0;
+            if (p_bytes >= t_MemBytes) {
+                memcpy(&l_totalPars, l_buf, sizeof(uint32_t));
+            }
+            if ((p_bytes < t_MemBytes) || (p_bytes < (1 + 8 * (uint64_t)l_totalPars) * t_MemBytes)) {
+                throw xf::sparse::SpmInvalidValue("from SpmvHost, parParam is too small.");
+            }
+            // block 7 of each partition is 0 for 16-bit indices, see SpmIdxType
+            for (uint32_t p = 0; p < l_totalPars; ++p) {
+                const uint8_t* l_idxBits = l_buf + (1 + 8 * (uint64_t)p + 7) * t_MemBytes;
+                for (unsigned int k = 0; k < t_MemBytes; ++k) {
+                    if (l_idxBits[k] != 0) {
+                        throw xf::sparse::SpmNotSupported("from SpmvHost, parParam holds delta encoded indices.");
+                    }
+                }
+            }
+        }
+
+        struct AsyncReq {
+            std::vector<uint8_t> m_x;
+            void* m_y;
+            std::function<void()> m_callback;
+            std::promise<void> m_done;
+            unsigned int m_slot;
+            bool m_started = false;
+            bool m_failed = false;
+        };
+        // keeps up to two requests queued on the kernels, one per slot, and completes them in order
+        void asyncLoop() {
+            std::deque<AsyncReq> l_inflight;
+            unsigned int l_nextSlot = 0;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> l_lock(m_asyncMutex);
+                    m_asyncCv.wait(l_lock,
+                                   [&] { return m_asyncStop || !m_asyncQueue.empty() || !l_inflight.empty(); });
+                    if (m_asyncQueue.empty() && l_inflight.empty()) {
+                        return;
+                    }
+                    while (l_inflight.size() < 2 && !m_asyncQueue.empty()) {
+                        l_inflight.push_back(std::move(m_asyncQueue.front()));
+                        m_asyncQueue.pop_front();
+                        l_inflight.back().m_slot = l_nextSlot;
+                        l_nextSlot = 1 - l_nextSlot;
+                    }
+                }
+                for (AsyncReq& l_req : l_inflight) {
+                    if (!l_req.m_started) {
+                        l_req.m_started = true;
+                        try {
+                            sendBatchX(l_req.m_slot, l_req.m_x.data());
+                            m_krnLoadNnz.run(l_req.m_slot);
+                            m_krnLoadParX.run(l_req.m_slot);
+                            m_krnLoadRbParam.run(l_req.m_slot);
+                            m_krnStoreY.run(l_req.m_slot);
+                        } catch (...) {
+                            l_req.m_done.set_exception(std::current_exception());
+                            l_req.m_failed = true;
+                        }
+                    }
+                }
+                AsyncReq& l_req = l_inflight.front();
+                if (!l_req.m_failed) {
+                    try {
+                        m_krnStoreY.wait(l_req.m_slot);
+                        m_krnLoadNnz.wait(l_req.m_slot);
+                        m_krnLoadParX.wait(l_req.m_slot);
+                        m_krnLoadRbParam.wait(l_req.m_slot);
+                        m_krnStoreY.readBO(getBatchBoId(1, l_req.m_slot));
+                        memcpy(l_req.m_y, m_batchY[l_req.m_slot], m_batchYbytes);
+                        if (l_req.m_callback) {
+                            l_req.m_callback();
+                        }
+                        l_req.m_done.set_value();
+                    } catch (...) {
+                        l_req.m_done.set_exception(std::current_exception());
+                    }
+                }
+                l_inflight.pop_front();
+            }
+        }
+        // keys of the batch slot BOs, clear of the argument indices used as keys by the single run BOs
+        static int getBatchBoId(const int p_argIdx, const unsigned int p_slot) {
+            return ((p_slot + 1) << 8) | p_argIdx;
+        }
+        void sendBatchX(const unsigned int p_slot, const void* p_x) {
+            memcpy(m_batchX[p_slot], p_x, m_batchXbytes);
+            m_krnLoadParX.sendBO(getBatchBoId(1, p_slot));
+        }
+        void runBatchSlot(const unsigned int p_slot) {
+            m_krnLoadParX.setMemArg(1, getBatchBoId(1, p_slot));
+            m_krnStoreY.setMemArg(1, getBatchBoId(1, p_slot));
+            run();
+        }
+
     private:
         xilinx_apps::hpc_common::FPGA* m_card;
         xilinx_apps::hpc_common::KERNEL m_krnLoadNnz;
@@ -100,6 +337,16 @@ class SpmvHost {
         std::map<const int, void*> m_krnLoadParXbufs;
         std::map<const int, void*> m_krnLoadRbParamBufs;
         std::map<const int, void*> m_krnStoreYbufs;
+        void* m_batchX[2];
+        void* m_batchY[2];
+        size_t m_batchXbytes = 0;
+        size_t m_batchYbytes = 0;
+        unsigned int m_storeYrows = 0;
+        std::thread m_asyncThread;
+        std::mutex m_asyncMutex;
+        std::condition_variable m_asyncCv;
+        std::deque<AsyncReq> m_asyncQueue;
+        bool m_asyncStop = false;
 };
 
 }
@@ -0,0 +1,406 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef XF_SPARSE_SPMVMODEL_HPP
+#define XF_SPARSE_SPMVMODEL_HPP
+
+#include "matrix_params.hpp"
+
+namespace xf {
+namespace sparse {
+
+// bytes moved through each device memory port of the spmv kernels for one y = A * x
+struct SpmvTraffic {
+    std::vector<uint64_t> m_nnzBytes; // loadNnzKernel, one entry per channel
+    uint64_t m_parParamBytes = 0;     // loadParXkernel, partition parameters
+    uint64_t m_xBytes = 0;            // loadParXkernel, x blocks of all partitions
+    uint64_t m_rbParamBytes = 0;      // loadRbParamKernel
+    uint64_t m_yBytes = 0;            // storeYkernel
+
+    uint64_t getMaxNnzBytes() const {
+        return m_nnzBytes.empty() ? 0 : *std::max_element(m_nnzBytes.begin(), m_nnzBytes.end());
+    }
+    uint64_t getTotalBytes() const {
+        return std::accumulate(m_nnzBytes.begin(), m_nnzBytes.end(), (uint64_t)0) + m_parParamBytes + m_xBytes +
+               m_rbParamBytes + m_yBytes;
+    }
+};
+
+// pipeline work of one spmv in memory blocks and rows, the input of SpmvPerfModel
+struct SpmvWork {
+    uint32_t m_channels = 0, m_parEntries = 0, m_accLatency = 0;
+    uint64_t m_vecBks = 0;                // memory blocks of the padded x vector
+    std::vector<uint32_t> m_parColBks;    // x blocks loaded by each partition
+    std::vector<uint64_t> m_parMaxChBks;  // nnz blocks of the busiest channel of each partition
+    std::vector<uint32_t> m_rbRows;       // rows assembled by each row block
+    std::vector<uint32_t> m_rbMaxChRows;  // rows accumulated by the busiest channel of each row block
+    std::vector<uint64_t> m_chBks;        // nnz blocks of each channel
+    std::vector<uint64_t> m_chRows;       // rows accumulated by each channel
+};
+
+/**
+ * @brief SpmvModel is a software functional model of the spmv kernel pipeline
+ *
+ * The rbParam, parParam and nnzVal buffers of a MatPartition are decoded the way loadRbParamKernel,
+ * loadParXkernel, loadNnzKernel and rowAccKernel consume them: every row index covers parEntries * accLatency
+ * values, every col index one block of parEntries x entries relative to the channel's col window of the partition,
+ * and each channel accumulates its rows before assembleYkernel adds the channels of a row block.
+ * Inconsistent buffers are reported with an SpmInvalidValue, so the model can be used to validate signatures.
+ */
+template <typename t_DataType>
+class SpmvModel {
+   public:
+    SpmvModel() = default;
+    SpmvModel(const MatPartition& p_matPar, unsigned int p_threads = 0) { init(p_matPar, p_threads); }
+
+    // decodes the parameter buffers of p_matPar, the buffers must stay valid while run is used
+    void init(const MatPartition& p_matPar, unsigned int p_threads = 0) {
+        m_matPar = p_matPar;
+        m_threads = p_threads;
+        if ((p_matPar.m_parEntries == 0) || (p_matPar.m_accLatency == 0) || (p_matPar.m_channels == 0) ||
+            (p_matPar.m_memBits == 0)) {
+            throw SpmInvalidValue("from SpmvModel, the partition doesn't record its Signature parameters.");
+        }
+        m_memBytes = p_matPar.m_memBits / 8;
+        if (p_matPar.m_nnzValPtr.size() != p_matPar.m_channels) {
+            throw SpmInvalidValue("from SpmvModel, the partition has the wrong number of nnz channels.");
+        }
+        m_channels = p_matPar.m_channels;
+        m_parEntries = p_matPar.m_parEntries;
+        m_memIdxWidth = p_matPar.m_memBits / 16;
+        m_rowIdxGap = m_parEntries * p_matPar.m_accLatency;
+        checkBuf(p_matPar.m_nnzValSize[0], m_memBytes, "nnzVal");
+        m_valType = (SpmValType)getWord<uint32_t>(p_matPar.m_nnzValPtr[0], 16);
+        if ((m_valType != VAL_FP64) && (m_valType != VAL_FP32) && (m_valType != VAL_BF16)) {
+            throw SpmInvalidValue("from SpmvModel, unknown value type in nnzVal_0.");
+        }
+        m_valBytes = getValBytes(m_valType);
+        if ((m_parEntries * m_valBytes > m_memBytes) || (m_memBytes % (m_parEntries * m_valBytes) != 0)) {
+            throw SpmInvalidValue("from SpmvModel, parEntries values don't fit a memory block.");
+        }
+        m_valGroups = m_memBytes / (m_parEntries * m_valBytes);
+        if (m_memIdxWidth % m_valGroups != 0) {
+            throw SpmInvalidValue("from SpmvModel, value blocks don't align with the col index blocks.");
+        }
+
+        checkBuf(p_matPar.m_rbParamSize, m_memBytes, "rbParam");
+        checkBuf(p_matPar.m_parParamSize, m_memBytes, "parParam");
+        m_totalRbs = getWord<uint32_t>(p_matPar.m_rbParamPtr, 4);
+        m_totalPars = getWord<uint32_t>(p_matPar.m_parParamPtr, 0);
+        checkBuf(p_matPar.m_rbParamSize, (1 + 8 * (uint64_t)m_totalRbs) * m_memBytes, "rbParam");
+        checkBuf(p_matPar.m_parParamSize, (1 + 8 * (uint64_t)m_totalPars) * m_memBytes, "parParam");
+
+        std::vector<uint64_t> l_chBks(m_channels);
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            checkBuf(p_matPar.m_nnzValSize[c], m_memBytes, "nnzVal");
+            l_chBks[c] = getWord<uint32_t>(p_matPar.m_nnzValPtr[c], 0);
+            checkBuf(p_matPar.m_nnzValSize[c], (1 + l_chBks[c]) * m_memBytes, "nnzVal");
+            if (getWord<uint32_t>(p_matPar.m_nnzValPtr[c], 16) != m_valType) {
+                throw SpmInvalidValue("from SpmvModel, nnzVal_" + std::to_string(c) + " has a different value type.");
+            }
+        }
+
+        // nnzVal streams are sequential over row blocks, record where each row block starts in every channel
+        m_rbParIds.assign(m_totalRbs + 1, 0);
+        m_rbChOffsets.assign((uint64_t)(m_totalRbs + 1) * m_channels, m_memBytes);
+        m_traffic = SpmvTraffic();
+        m_traffic.m_nnzBytes.assign(m_channels, 0);
+        m_work = SpmvWork();
+        m_work.m_channels = m_channels;
+        m_work.m_parEntries = m_parEntries;
+        m_work.m_accLatency = p_matPar.m_accLatency;
+        m_work.m_vecBks = DIV_CEIL(p_matPar.m_nPad, m_parEntries);
+        m_work.m_rbRows.resize(m_totalRbs);
+        m_work.m_rbMaxChRows.assign(m_totalRbs, 0);
+        m_work.m_chBks.assign(m_channels, 0);
+        m_work.m_chRows.assign(m_channels, 0);
+        for (uint32_t rbId = 0; rbId < m_totalRbs; ++rbId) {
+            uint32_t l_pars = getRbWord(rbId, 0, 3);
+            m_rbParIds[rbId + 1] = m_rbParIds[rbId] + l_pars;
+            if (m_rbParIds[rbId + 1] > m_totalPars) {
+                throw SpmInvalidValue("from SpmvModel, row blocks reference more partitions than parParam holds.");
+            }
+            m_work.m_rbRows[rbId] = getRbWord(rbId, 1, 0);
+            for (uint32_t c = 0; c < m_channels; ++c) {
+                uint64_t l_offset = m_rbChOffsets[(uint64_t)rbId * m_channels + c];
+                for (uint32_t parId = m_rbParIds[rbId]; parId < m_rbParIds[rbId + 1]; ++parId) {
+                    l_offset += getChParBks(getParWord(parId, 2, c), getParIdxBits(parId, c)) * m_memBytes;
+                }
+                m_rbChOffsets[(uint64_t)(rbId + 1) * m_channels + c] = l_offset;
+                uint32_t l_chRows = getRbWord16(rbId, 3, c);
+                m_work.m_rbMaxChRows[rbId] = std::max(m_work.m_rbMaxChRows[rbId], l_chRows);
+                m_work.m_chRows[c] += l_chRows;
+            }
+        }
+        if (m_rbParIds[m_totalRbs] != m_totalPars) {
+            throw SpmInvalidValue("from SpmvModel, row blocks don't cover all partitions.");
+        }
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            if (m_rbChOffsets[(uint64_t)m_totalRbs * m_channels + c] != (1 + l_chBks[c]) * m_memBytes) {
+                throw SpmInvalidValue("from SpmvModel, nnzVal_" + std::to_string(c) +
+                                      " size doesn't match the partition parameters.");
+            }
+            m_traffic.m_nnzBytes[c] = (1 + l_chBks[c]) * m_memBytes;
+        }
+        m_work.m_parColBks.resize(m_totalPars);
+        m_work.m_parMaxChBks.assign(m_totalPars, 0);
+        for (uint32_t parId = 0; parId < m_totalPars; ++parId) {
+            m_work.m_parColBks[parId] = getParWord(parId, 4, 1);
+            for (uint32_t c = 0; c < m_channels; ++c) {
+                uint64_t l_bks = getChParBks(getParWord(parId, 2, c), getParIdxBits(parId, c));
+                m_work.m_parMaxChBks[parId] = std::max(m_work.m_parMaxChBks[parId], l_bks);
+                m_work.m_chBks[c] += l_bks;
+            }
+            m_traffic.m_xBytes += (uint64_t)m_work.m_parColBks[parId] * m_memBytes;
+        }
+        m_traffic.m_rbParamBytes = 8 * (uint64_t)m_totalRbs * m_memBytes;
+        m_traffic.m_parParamBytes = 8 * (uint64_t)m_totalPars * m_memBytes;
+        m_traffic.m_yBytes = (uint64_t)DIV_CEIL(p_matPar.m_m, m_parEntries) * m_memBytes;
+    }
+
+    // y = A * x, p_x holds m_n entries and p_y m_m entries of the partitioned matrix
+    void run(const t_DataType* p_x, t_DataType* p_y) const {
+        std::fill(p_y, p_y + m_matPar.m_m, 0);
+        parallelFor(m_threads, m_totalRbs, [&](uint32_t rbId) { runRb(rbId, p_x, p_y); });
+    }
+
+    // the non-zeros of the partitioned matrix as CSR, the entries of a row are ordered by channel and partition
+    void getCsr(std::vector<uint64_t>& p_rowPtr,
+                std::vector<uint32_t>& p_colIdx,
+                std::vector<t_DataType>& p_vals) const {
+        p_rowPtr.assign(m_matPar.m_m + 1, 0);
+        for (unsigned int l_pass = 0; l_pass < 2; ++l_pass) {
+            for (uint32_t rbId = 0; rbId < m_totalRbs; ++rbId) {
+                const uint64_t l_sRow = getRbWord(rbId, 0, 0);
+                decodeRb(rbId, [&](uint32_t p_c, uint32_t p_row, uint64_t p_col, const t_DataType* p_groupVals) {
+                    const uint64_t l_row = l_sRow + getRbWord16(rbId, 2, p_c) + p_row;
+                    for (uint32_t j = 0; j < m_parEntries; ++j) {
+                        if (p_groupVals[j] == 0) {
+                            continue;
+                        }
+                        if (l_row >= m_matPar.m_m) {
+                            throwErr("value outside of the matrix", rbId);
+                        }
+                        if (l_pass == 0) {
+                            p_rowPtr[l_row + 1]++;
+                        } else {
+                            uint64_t l_idx = p_rowPtr[l_row]++;
+                            p_colIdx[l_idx] = p_col + j;
+                            p_vals[l_idx] = p_groupVals[j];
+                        }
+                    }
+                });
+            }
+            if (l_pass == 0) {
+                std::partial_sum(p_rowPtr.begin(), p_rowPtr.end(), p_rowPtr.begin());
+                p_colIdx.resize(p_rowPtr[m_matPar.m_m]);
+                p_vals.resize(p_rowPtr[m_matPar.m_m]);
+            } else {
+                // the fill advanced each row start to the next row
+                std::copy_backward(p_rowPtr.begin(), p_rowPtr.end() - 1, p_rowPtr.end());
+                p_rowPtr[0] = 0;
+            }
+        }
+    }
+
+    const SpmvTraffic& getTraffic() const { return m_traffic; }
+    const SpmvWork& getWork() const { return m_work; }
+    uint32_t getTotalRbs() const { return m_totalRbs; }
+    uint32_t getTotalPars() const { return m_totalPars; }
+
+   private:
+    template <typename t_Type>
+    static t_Type getWord(const void* p_buf, uint64_t p_byteOffset) {
+        t_Type l_val;
+        memcpy(&l_val, reinterpret_cast<const uint8_t*>(p_buf) + p_byteOffset, sizeof(t_Type));
+        return l_val;
+    }
+    static void checkBuf(uint64_t p_size, uint64_t p_bytes, const char* p_name) {
+        if (p_size < p_bytes) {
+            throw SpmInvalidValue(std::string("from SpmvModel, ") + p_name + " buffer is too small.");
+        }
+    }
+    // 32-bit word p_word of block p_bk of a row block, see RowBlockParam
+    uint32_t getRbWord(uint32_t p_rbId, uint32_t p_bk, uint32_t p_word) const {
+        return getWord<uint32_t>(m_matPar.m_rbParamPtr, (1 + 8 * (uint64_t)p_rbId + p_bk) * m_memBytes + p_word * 4);
+    }
+    uint16_t getRbWord16(uint32_t p_rbId, uint32_t p_bk, uint32_t p_word) const {
+        return getWord<uint16_t>(m_matPar.m_rbParamPtr, (1 + 8 * (uint64_t)p_rbId + p_bk) * m_memBytes + p_word * 2);
+    }
+    // 32-bit word of a partition, counted from the first block of the partition, see ParParam
+    uint32_t getParWord(uint32_t p_parId, uint32_t p_bk, uint32_t p_word) const {
+        return getWord<uint32_t>(m_matPar.m_parParamPtr,
+                                 (1 + 8 * (uint64_t)p_parId + p_bk) * m_memBytes + p_word * 4);
+    }
+    uint16_t getParWord16(uint32_t p_parId, uint32_t p_bk, uint32_t p_word) const {
+        return getWord<uint16_t>(m_matPar.m_parParamPtr,
+                                 (1 + 8 * (uint64_t)p_parId + p_bk) * m_memBytes + p_word * 2);
+    }
+    // index encoding of a channel partition recorded in parParam block 7, see SpmIdxType
+    uint32_t getParIdxBits(uint32_t p_parId, uint32_t p_chId) const {
+        uint32_t l_idxBits = getParWord16(p_parId, 7, p_chId);
+        for (uint32_t l_bits : {l_idxBits & 0xff, l_idxBits >> 8}) {
+            if ((l_bits != 0) && (l_bits != 2) && (l_bits != 4) && (l_bits != 8)) {
+                throw SpmInvalidValue("from SpmvModel, invalid index encoding of partition " +
+                                      std::to_string(p_parId) + " in channel " + std::to_string(p_chId) + ".");
+            }
+        }
+        return l_idxBits;
+    }
+    // row index, col index and value blocks of a channel partition, see Signature::gen_nnzStore
+    uint64_t getChParBks(uint32_t p_nnzs, uint32_t p_idxBits) const {
+        uint32_t l_rowIdxMod = m_matPar.m_memBits / getIdxBits(p_idxBits & 0xff) * m_rowIdxGap;
+        uint32_t l_colIdxMod = m_matPar.m_memBits / getIdxBits(p_idxBits >> 8) * m_parEntries;
+        return DIV_CEIL(p_nnzs, l_rowIdxMod) + DIV_CEIL(p_nnzs, l_colIdxMod) +
+               DIV_CEIL(p_nnzs / m_parEntries, m_valGroups);
+    }
+    // entries of the index block at p_bk, p_prevIdx is the last index of the stream for delta encoded blocks
+    void loadIdxBk(const uint8_t* p_bk, uint32_t p_deltaBits, uint32_t* p_idx, uint32_t& p_prevIdx) const {
+        if (p_deltaBits == 0) {
+            for (uint32_t j = 0; j < m_memIdxWidth; ++j) {
+                p_idx[j] = getWord<uint16_t>(p_bk, 2 * j);
+            }
+            return;
+        }
+        for (uint32_t j = 0; j < m_matPar.m_memBits / p_deltaBits; ++j) {
+            p_prevIdx += loadDelta(p_bk, j, p_deltaBits);
+            p_idx[j] = p_prevIdx;
+        }
+    }
+
+    // p_func(c, row, col, vals) receives the groups of parEntries values of row block p_rbId channel by channel, row
+    // is counted from the first row of channel c and col is the col of vals[0]
+    template <typename t_Func>
+    void decodeRb(uint32_t p_rbId, t_Func p_func) const {
+        const uint32_t l_rbRows = getRbWord(p_rbId, 1, 0);
+        const uint64_t l_xEntries = (uint64_t)m_matPar.m_nPad;
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            const uint32_t l_chRowOff = getRbWord16(p_rbId, 2, c);
+            const uint32_t l_chRows = getRbWord16(p_rbId, 3, c);
+            if ((l_chRows > m_matPar.m_maxRows) || (l_chRowOff + l_chRows > l_rbRows)) {
+                throwErr("row range of channel " + std::to_string(c), p_rbId);
+            }
+            const uint8_t* l_buf = reinterpret_cast<const uint8_t*>(m_matPar.m_nnzValPtr[c]);
+            uint64_t l_offset = m_rbChOffsets[(uint64_t)p_rbId * m_channels + c];
+            uint32_t l_rowIdx[m_matPar.m_memBits / 2];
+            uint32_t l_colIdx[m_matPar.m_memBits / 2];
+            const uint8_t* l_valBk = nullptr;
+            t_DataType l_vals[m_parEntries];
+            for (uint32_t parId = m_rbParIds[p_rbId]; parId < m_rbParIds[p_rbId + 1]; ++parId) {
+                const uint32_t l_baseParAddr = getParWord(parId, 4, 0);
+                const uint32_t l_colBks = getParWord(parId, 4, 1);
+                const uint32_t l_chNnzs = getParWord(parId, 2, c);
+                const uint32_t l_chBaseAddr = getParWord16(parId, 5, c);
+                const uint32_t l_chColBks = getParWord16(parId, 6, c);
+                if ((l_chNnzs % m_rowIdxGap != 0) || ((l_chNnzs != 0) && (l_chBaseAddr + l_chColBks > l_colBks)) ||
+                    (((uint64_t)l_baseParAddr + l_colBks) * m_parEntries > l_xEntries)) {
+                    throwErr("partition " + std::to_string(parId) + " of channel " + std::to_string(c), p_rbId);
+                }
+                const uint64_t l_sColBk = (uint64_t)l_baseParAddr + l_chBaseAddr;
+                const uint32_t l_idxBits = getParIdxBits(parId, c);
+                const uint32_t l_rowBits = l_idxBits & 0xff, l_colBits = l_idxBits >> 8;
+                const uint32_t l_rowIdxMod = m_matPar.m_memBits / getIdxBits(l_rowBits) * m_rowIdxGap;
+                const uint32_t l_colIdxMod = m_matPar.m_memBits / getIdxBits(l_colBits) * m_parEntries;
+                uint32_t l_prevRowIdx = 0, l_prevColIdx = 0;
+                for (uint32_t i = 0; i < l_chNnzs; i += m_parEntries) {
+                    if (i % l_rowIdxMod == 0) {
+                        loadIdxBk(l_buf + l_offset, l_rowBits, l_rowIdx, l_prevRowIdx);
+                        l_offset += m_memBytes;
+                    }
+                    if (i % l_colIdxMod == 0) {
+                        loadIdxBk(l_buf + l_offset, l_colBits, l_colIdx, l_prevColIdx);
+                        l_offset += m_memBytes;
+                    }
+                    const uint32_t l_group = i / m_parEntries;
+                    if (l_group % m_valGroups == 0) {
+                        l_valBk = l_buf + l_offset;
+                        l_offset += m_memBytes;
+                    }
+                    const uint8_t* l_groupVals = l_valBk + (l_group % m_valGroups) * m_parEntries * m_valBytes;
+                    for (uint32_t j = 0; j < m_parEntries; ++j) {
+                        l_vals[j] = loadVal(m_valType, l_groupVals + j * m_valBytes);
+                    }
+                    const uint32_t l_row = l_rowIdx[(i % l_rowIdxMod) / m_rowIdxGap];
+                    const uint32_t l_colBk = l_colIdx[(i % l_colIdxMod) / m_parEntries];
+                    if ((l_row >= l_chRows) || (l_colBk >= l_chColBks)) {
+                        throwErr("nnz index of partition " + std::to_string(parId) + " in channel " +
+                                     std::to_string(c),
+                                 p_rbId);
+                    }
+                    const uint64_t l_sCol = (l_sColBk + l_colBk) * m_parEntries;
+                    for (uint32_t j = 0; j < m_parEntries; ++j) {
+                        if ((l_vals[j] != 0) && (l_sCol + j >= m_matPar.m_n)) {
+                            throwErr("value outside of the matrix in channel " + std::to_string(c), p_rbId);
+                        }
+                    }
+                    p_func(c, l_row, l_sCol, l_vals);
+                }
+            }
+        }
+    }
+
+    void runRb(uint32_t p_rbId, const t_DataType* p_x, t_DataType* p_y) const {
+        const uint32_t l_sRbRowId = getRbWord(p_rbId, 0, 0);
+        const uint32_t l_rbRows = getRbWord(p_rbId, 1, 0);
+        std::vector<t_DataType> l_rbAcc(l_rbRows, 0);
+        std::vector<std::vector<t_DataType> > l_chAcc(m_channels);
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            l_chAcc[c].assign(getRbWord16(p_rbId, 3, c), 0);
+        }
+        decodeRb(p_rbId, [&](uint32_t p_c, uint32_t p_row, uint64_t p_col, const t_DataType* p_vals) {
+            t_DataType l_sum = 0;
+            for (uint32_t j = 0; j < m_parEntries; ++j) {
+                if (p_vals[j] != 0) {
+                    l_sum += p_vals[j] * p_x[p_col + j];
+                }
+            }
+            l_chAcc[p_c][p_row] += l_sum;
+        });
+        for (uint32_t c = 0; c < m_channels; ++c) {
+            const uint32_t l_chRowOff = getRbWord16(p_rbId, 2, c);
+            for (uint32_t r = 0; r < l_chAcc[c].size(); ++r) {
+                l_rbAcc[l_chRowOff + r] += l_chAcc[c][r];
+            }
+        }
+        for (uint32_t r = 0; r < l_rbRows; ++r) {
+            if (l_sRbRowId + r < m_matPar.m_m) {
+                p_y[l_sRbRowId + r] = l_rbAcc[r];
+            } else if (l_rbAcc[r] != 0) {
+                throwErr("value outside of the matrix", p_rbId);
+            }
+        }
+    }
+    void throwErr(const std::string& p_what, uint32_t p_rbId) const {
+        throw SpmInvalidValue("from SpmvModel, invalid " + p_what + " in row block " + std::to_string(p_rbId) + ".");
+    }
+
+   private:
+    MatPartition m_matPar;
+    unsigned int m_threads = 0;
+    uint32_t m_memBytes = 0, m_channels = 0, m_parEntries = 0;
+    uint32_t m_memIdxWidth = 0, m_rowIdxGap = 0;
+    SpmValType m_valType = VAL_FP64;
+    uint32_t m_valBytes = 0, m_valGroups = 0; // value groups of parEntries in a value block
+    uint32_t m_totalRbs = 0, m_totalPars = 0;
+    std::vector<uint32_t> m_rbParIds;     // first partition of each row block
+    std::vector<uint64_t> m_rbChOffsets;  // byte offset of each row block in each nnzVal buffer
+    SpmvTraffic m_traffic;
+    SpmvWork m_work;
+};
+
+}
+}
+#endif
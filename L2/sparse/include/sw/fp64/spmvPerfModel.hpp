@@ -0,0 +1,206 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef XF_SPARSE_SPMVPERFMODEL_HPP
+#define XF_SPARSE_SPMVPERFMODEL_HPP
+
+#include "spmvModel.hpp"
+
+namespace xf {
+namespace sparse {
+
+// terms of the performance model, each one is a cycle count scaled by a calibrated weight
+enum SpmvPerfTerm {
+    PERF_TERM_NNZ = 0,    // nnz blocks of the busiest channel of each partition, at the HBM burst efficiency
+    PERF_TERM_X = 1,      // x blocks loaded by each partition, at the HBM burst efficiency
+    PERF_TERM_RELOAD = 2, // read latency paid by each partition before its x blocks arrive
+    PERF_TERM_ACC = 3,    // accumulator pipeline of accLatency cycles drained by each partition and row block
+    PERF_TERM_ROWS = 4,   // row blocks of parEntries rows accumulated by the busiest channel and assembled into y
+    PERF_TERM_VEC = 5,    // JPCG vector updates of each iteration
+    PERF_TERM_LAUNCH = 6, // fixed cost of a kernel run
+    PERF_TERMS = 7
+};
+
+// uncalibrated defaults describe the PCG xclbin, a calibration only changes m_weights
+struct SpmvPerfParams {
+    double m_clockMHz = 300;         // kernel clock
+    uint32_t m_burstBks = 64;        // memory blocks per HBM burst
+    double m_burstGapCycles = 8;     // idle cycles of a memory port between two bursts
+    double m_xLatencyCycles = 128;   // cycles from the x request of a partition to its first x block
+    double m_vecPasses = 2;          // sequential passes over the vectors in a JPCG iteration
+    double m_launchCycles = 30000;   // kernel start and finish
+    std::array<double, PERF_TERMS> m_weights{{1, 1, 1, 1, 1, 1, 1}};
+};
+
+/**
+ * @brief SpmvPerfModel estimates the run time of the spmv kernels, and of JPCG solves, from the work recorded by
+ * SpmvModel
+ *
+ * The busiest channel paces each partition, as the channels share the x stream, and the partitions of a row block
+ * are processed one after another. calibrate fits the term weights to the samples added with addSample, usually
+ * solver times reported by xJPCG_getMetrics.
+ */
+class SpmvPerfModel {
+   public:
+    SpmvPerfModel(const SpmvPerfParams& p_params = SpmvPerfParams()) : m_params(p_params) {}
+
+    // unweighted cycles of each term, p_pcgIters == 0 models one spmv, otherwise a JPCG solve of p_pcgIters
+    std::array<double, PERF_TERMS> getTerms(const SpmvWork& p_work, uint32_t p_pcgIters = 0) const {
+        const double l_bkCycles = 1.0 + m_params.m_burstGapCycles / m_params.m_burstBks;
+        std::array<double, PERF_TERMS> l_terms;
+        l_terms.fill(0);
+        for (uint32_t p = 0; p < p_work.m_parColBks.size(); ++p) {
+            l_terms[PERF_TERM_NNZ] += p_work.m_parMaxChBks[p] * l_bkCycles;
+            l_terms[PERF_TERM_X] += p_work.m_parColBks[p] +
+                                    DIV_CEIL(p_work.m_parColBks[p], m_params.m_burstBks) * m_params.m_burstGapCycles;
+        }
+        l_terms[PERF_TERM_RELOAD] = p_work.m_parColBks.size() * m_params.m_xLatencyCycles;
+        l_terms[PERF_TERM_ACC] = (double)(p_work.m_parColBks.size() + p_work.m_rbRows.size()) * p_work.m_accLatency;
+        for (uint32_t r = 0; r < p_work.m_rbRows.size(); ++r) {
+            l_terms[PERF_TERM_ROWS] += DIV_CEIL(p_work.m_rbMaxChRows[r], p_work.m_parEntries) +
+                                       DIV_CEIL(p_work.m_rbRows[r], p_work.m_parEntries);
+        }
+        if (p_pcgIters != 0) {
+            l_terms[PERF_TERM_VEC] = p_work.m_vecBks * m_params.m_vecPasses * l_bkCycles;
+            for (unsigned int t = 0; t < PERF_TERM_LAUNCH; ++t) {
+                l_terms[t] *= p_pcgIters;
+            }
+        }
+        l_terms[PERF_TERM_LAUNCH] = m_params.m_launchCycles;
+        return l_terms;
+    }
+    double estimateCycles(const SpmvWork& p_work, uint32_t p_pcgIters = 0) const {
+        std::array<double, PERF_TERMS> l_terms = getTerms(p_work, p_pcgIters);
+        double l_cycles = 0;
+        for (unsigned int t = 0; t < PERF_TERMS; ++t) {
+            l_cycles += m_params.m_weights[t] * l_terms[t];
+        }
+        return l_cycles;
+    }
+    double estimateSeconds(const SpmvWork& p_work, uint32_t p_pcgIters = 0) const {
+        return estimateCycles(p_work, p_pcgIters) / (m_params.m_clockMHz * 1e6);
+    }
+    // busy cycles of each channel in one spmv, the x stream and the rows of a channel are not shared
+    std::vector<double> estimateChCycles(const SpmvWork& p_work) const {
+        std::array<double, PERF_TERMS> l_terms = getTerms(p_work);
+        const std::array<double, PERF_TERMS>& l_w = m_params.m_weights;
+        const double l_bkCycles = 1.0 + m_params.m_burstGapCycles / m_params.m_burstBks;
+        double l_shared = l_w[PERF_TERM_X] * l_terms[PERF_TERM_X] + l_w[PERF_TERM_RELOAD] * l_terms[PERF_TERM_RELOAD] +
+                          l_w[PERF_TERM_ACC] * l_terms[PERF_TERM_ACC];
+        std::vector<double> l_chCycles(p_work.m_channels);
+        for (uint32_t c = 0; c < p_work.m_channels; ++c) {
+            l_chCycles[c] = l_shared + l_w[PERF_TERM_NNZ] * p_work.m_chBks[c] * l_bkCycles +
+                            l_w[PERF_TERM_ROWS] * DIV_CEIL(p_work.m_chRows[c], p_work.m_parEntries);
+        }
+        return l_chCycles;
+    }
+
+    // a measured run time of p_work, see getTerms for p_pcgIters
+    void addSample(const SpmvWork& p_work, uint32_t p_pcgIters, double p_seconds) {
+        if (!(p_seconds > 0)) {
+            throw SpmInvalidValue("from SpmvPerfModel, measured run time must be positive.");
+        }
+        m_samples.push_back(getTerms(p_work, p_pcgIters));
+        m_sampleSeconds.push_back(p_seconds);
+    }
+    uint32_t getSamples() const { return m_sampleSeconds.size(); }
+    // relative error of the current weights for each sample
+    std::vector<double> getSampleErrors() const {
+        std::vector<double> l_errs(m_samples.size());
+        for (uint32_t i = 0; i < m_samples.size(); ++i) {
+            double l_cycles = 0;
+            for (unsigned int t = 0; t < PERF_TERMS; ++t) {
+                l_cycles += m_params.m_weights[t] * m_samples[i][t];
+            }
+            l_errs[i] = l_cycles / (m_params.m_clockMHz * 1e6) / m_sampleSeconds[i] - 1;
+        }
+        return l_errs;
+    }
+    // least squares fit of the weights to the relative errors of the samples, p_lambda pulls the weights towards 1
+    // so that terms the samples don't exercise keep their default; returns the rms relative error after the fit
+    double calibrate(double p_lambda = 1e-2) {
+        if (m_samples.empty()) {
+            throw SpmInvalidValue("from SpmvPerfModel, no samples to calibrate against.");
+        }
+        const unsigned int N = PERF_TERMS;
+        double l_mat[N][N + 1];
+        for (unsigned int j = 0; j < N; ++j) {
+            for (unsigned int k = 0; k <= N; ++k) {
+                l_mat[j][k] = (k == j) ? p_lambda : 0;
+            }
+            l_mat[j][N] = p_lambda;
+        }
+        for (uint32_t i = 0; i < m_samples.size(); ++i) {
+            double l_a[N];
+            for (unsigned int t = 0; t < N; ++t) {
+                l_a[t] = m_samples[i][t] / (m_params.m_clockMHz * 1e6) / m_sampleSeconds[i];
+            }
+            for (unsigned int j = 0; j < N; ++j) {
+                for (unsigned int k = 0; k < N; ++k) {
+                    l_mat[j][k] += l_a[j] * l_a[k];
+                }
+                l_mat[j][N] += l_a[j];
+            }
+        }
+        // Gaussian elimination with partial pivoting, the matrix is positive definite for p_lambda > 0
+        for (unsigned int j = 0; j < N; ++j) {
+            unsigned int l_pivot = j;
+            for (unsigned int k = j + 1; k < N; ++k) {
+                if (fabs(l_mat[k][j]) > fabs(l_mat[l_pivot][j])) {
+                    l_pivot = k;
+                }
+            }
+            if (l_mat[l_pivot][j] == 0) {
+                throw SpmInternalError("from SpmvPerfModel, singular calibration system.");
+            }
+            for (unsigned int k = 0; k <= N; ++k) {
+                std::swap(l_mat[j][k], l_mat[l_pivot][k]);
+            }
+            for (unsigned int r = j + 1; r < N; ++r) {
+                double l_f = l_mat[r][j] / l_mat[j][j];
+                for (unsigned int k = j; k <= N; ++k) {
+                    l_mat[r][k] -= l_f * l_mat[j][k];
+                }
+            }
+        }
+        for (unsigned int j = N; j-- > 0;) {
+            double l_sum = l_mat[j][N];
+            for (unsigned int k = j + 1; k < N; ++k) {
+                l_sum -= l_mat[j][k] * m_params.m_weights[k];
+            }
+            // a negative weight has no physical meaning, the term is dropped instead
+            m_params.m_weights[j] = std::max(0.0, l_sum / l_mat[j][j]);
+        }
+        std::vector<double> l_errs = getSampleErrors();
+        double l_sumSq = 0;
+        for (double l_err : l_errs) {
+            l_sumSq += l_err * l_err;
+        }
+        return sqrt(l_sumSq / l_errs.size());
+    }
+
+    const SpmvPerfParams& getParams() const { return m_params; }
+    void setParams(const SpmvPerfParams& p_params) { m_params = p_params; }
+
+   private:
+    SpmvPerfParams m_params;
+    std::vector<std::array<double, PERF_TERMS> > m_samples;
+    std::vector<double> m_sampleSeconds;
+};
+
+}
+}
+#endif
@@ -51,7 +51,7 @@ CooMatInfo loadMatInfo(std::string path) {
     l_matInfo.m_name = infos[0];
     l_matInfo.m_m = stoi(infos[1]);
     l_matInfo.m_n = stoi(infos[2]);
-    l_matInfo.m_nnz = stoi(infos[3]);
+    l_matInfo.m_nnz = stoull(infos[3]);
     return l_matInfo;
 }
 
@@ -67,6 +67,10 @@ void storeMatPar(std::string path, MatPartition& p_matPar) {
         saveBin(l_nnzFileNames[i], p_matPar.m_nnzValPtr[i], p_matPar.m_nnzValSize[i]);
     }
     std::string l_infoFileName(path + "/info.dat");
+    if ((p_matPar.m_nnz > std::numeric_limits<uint32_t>::max()) ||
+        (p_matPar.m_nnzPad > std::numeric_limits<uint32_t>::max())) {
+        throw SpmNotSupported("info.dat only holds 32-bit nnzs, use storeMatParFile for larger matrices.");
+    }
     int int32Arr[6];
     memset(int32Arr, 0, 6 * sizeof(int));
     int32Arr[0] = p_matPar.m_m;
@@ -80,5 +84,189 @@ void storeMatPar(std::string path, MatPartition& p_matPar) {
     outFile.close();
 }
 
+uint32_t crc32(const void* p_buf, size_t p_bytes, uint32_t p_crc) {
+    static const std::vector<uint32_t> l_table = [] {
+        std::vector<uint32_t> l_tab(256);
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t l_c = i;
+            for (unsigned int k = 0; k < 8; ++k) {
+                l_c = (l_c & 1) ? (0xEDB88320u ^ (l_c >> 1)) : (l_c >> 1);
+            }
+            l_tab[i] = l_c;
+        }
+        return l_tab;
+    }();
+    const uint8_t* l_buf = reinterpret_cast<const uint8_t*>(p_buf);
+    uint32_t l_crc = ~p_crc;
+    for (size_t i = 0; i < p_bytes; ++i) {
+        l_crc = l_table[(l_crc ^ l_buf[i]) & 0xff] ^ (l_crc >> 8);
+    }
+    return ~l_crc;
+}
+
+uint64_t hash64(const void* p_buf, size_t p_bytes, uint64_t p_hash) {
+    const uint64_t l_mul = 0x9e3779b97f4a7c15ULL;
+    auto l_mix = [](uint64_t p_val) {
+        p_val ^= p_val >> 33;
+        p_val *= 0xff51afd7ed558ccdULL;
+        p_val ^= p_val >> 33;
+        return p_val;
+    };
+    const uint8_t* l_buf = reinterpret_cast<const uint8_t*>(p_buf);
+    uint64_t l_hash = p_hash ^ (p_bytes * l_mul);
+    size_t l_words = p_bytes / sizeof(uint64_t);
+    for (size_t i = 0; i < l_words; ++i) {
+        uint64_t l_word;
+        memcpy(&l_word, l_buf + i * sizeof(uint64_t), sizeof(uint64_t));
+        l_hash = (l_hash ^ l_mix(l_word)) * l_mul;
+        l_hash = (l_hash << 31) | (l_hash >> 33);
+    }
+    uint64_t l_tail = 0;
+    memcpy(&l_tail, l_buf + l_words * sizeof(uint64_t), p_bytes % sizeof(uint64_t));
+    l_hash = (l_hash ^ l_mix(l_tail)) * l_mul;
+    return l_mix(l_hash);
+}
+
+void storeMatParFile(std::string filename, MatPartition& p_matPar, const SigFileSections& p_extraSections) {
+    uint32_t l_sections = p_matPar.m_nnzValPtr.size() + 2 + p_extraSections.size();
+    std::vector<void*> l_ptrs;
+    std::vector<uint64_t> l_bytes;
+    l_ptrs.push_back(p_matPar.m_rbParamPtr);
+    l_bytes.push_back(p_matPar.m_rbParamSize);
+    l_ptrs.push_back(p_matPar.m_parParamPtr);
+    l_bytes.push_back(p_matPar.m_parParamSize);
+    for (unsigned int i = 0; i < p_matPar.m_nnzValPtr.size(); ++i) {
+        l_ptrs.push_back(p_matPar.m_nnzValPtr[i]);
+        l_bytes.push_back(p_matPar.m_nnzValSize[i]);
+    }
+    for (unsigned int i = 0; i < p_extraSections.size(); ++i) {
+        l_ptrs.push_back(p_extraSections[i].first);
+        l_bytes.push_back(p_extraSections[i].second);
+    }
+
+    SigFileHeader l_header;
+    memset(&l_header, 0, sizeof(l_header));
+    memcpy(l_header.m_magic, SIG_FILE_MAGIC, sizeof(SIG_FILE_MAGIC));
+    l_header.m_version = SIG_FILE_VERSION;
+    size_t l_tableBytes = sizeof(SigFileHeader) + l_sections * sizeof(SigFileSection);
+    l_header.m_headerBytes = DIV_CEIL(l_tableBytes, SIG_FILE_ALIGN) * SIG_FILE_ALIGN;
+    l_header.m_parEntries = p_matPar.m_parEntries;
+    l_header.m_accLatency = p_matPar.m_accLatency;
+    l_header.m_channels = p_matPar.m_channels;
+    l_header.m_maxRows = p_matPar.m_maxRows;
+    l_header.m_maxCols = p_matPar.m_maxCols;
+    l_header.m_memBits = p_matPar.m_memBits;
+    l_header.m_m = p_matPar.m_m;
+    l_header.m_n = p_matPar.m_n;
+    l_header.m_nnz = p_matPar.m_nnz;
+    l_header.m_mPad = p_matPar.m_mPad;
+    l_header.m_nPad = p_matPar.m_nPad;
+    l_header.m_nnzPad = p_matPar.m_nnzPad;
+    l_header.m_sections = l_sections;
+
+    std::vector<uint8_t> l_headerBuf(l_header.m_headerBytes, 0);
+    SigFileSection* l_table = reinterpret_cast<SigFileSection*>(l_headerBuf.data() + sizeof(SigFileHeader));
+    uint64_t l_offset = l_header.m_headerBytes;
+    for (uint32_t i = 0; i < l_sections; ++i) {
+        l_table[i].m_offset = l_offset;
+        l_table[i].m_bytes = l_bytes[i];
+        l_table[i].m_crc = crc32(l_ptrs[i], l_bytes[i]);
+        l_offset += DIV_CEIL(l_bytes[i], SIG_FILE_ALIGN) * SIG_FILE_ALIGN;
+    }
+    memcpy(l_headerBuf.data(), &l_header, sizeof(SigFileHeader));
+    l_header.m_headerCrc = crc32(l_headerBuf.data(), l_tableBytes);
+    memcpy(l_headerBuf.data(), &l_header, sizeof(SigFileHeader));
+
+    std::ofstream l_file(filename, std::ios::binary);
+    l_file.write(reinterpret_cast<char*>(l_headerBuf.data()), l_headerBuf.size());
+    std::vector<char> l_pad(SIG_FILE_ALIGN, 0);
+    for (uint32_t i = 0; i < l_sections; ++i) {
+        l_file.write(reinterpret_cast<char*>(l_ptrs[i]), l_bytes[i]);
+        l_file.write(l_pad.data(), DIV_CEIL(l_bytes[i], SIG_FILE_ALIGN) * SIG_FILE_ALIGN - l_bytes[i]);
+    }
+    if (!l_file) {
+        throw SpmInvalidValue("Failed to write signature file " + filename + ".");
+    }
+}
+
+MatPartition loadMatParFile(MappedBinFile& p_file,
+                            uint32_t p_parEntries,
+                            uint32_t p_accLatency,
+                            uint32_t p_channels,
+                            uint32_t p_maxRows,
+                            uint32_t p_maxCols,
+                            uint32_t p_memBits,
+                            bool p_verify,
+                            SigFileSections* p_extraSections) {
+    uint8_t* l_buf = reinterpret_cast<uint8_t*>(p_file.data());
+    if ((p_file.size() < sizeof(SigFileHeader)) || (memcmp(l_buf, SIG_FILE_MAGIC, sizeof(SIG_FILE_MAGIC)) != 0)) {
+        throw SpmInvalidValue("Not a signature file.");
+    }
+    SigFileHeader l_header;
+    memcpy(&l_header, l_buf, sizeof(SigFileHeader));
+    if (l_header.m_version != SIG_FILE_VERSION) {
+        throw SpmNotSupported("Signature file version " + std::to_string(l_header.m_version) + " is not supported.");
+    }
+    size_t l_tableBytes = sizeof(SigFileHeader) + (size_t)l_header.m_sections * sizeof(SigFileSection);
+    if ((l_tableBytes > l_header.m_headerBytes) || (l_header.m_headerBytes > p_file.size())) {
+        throw SpmInvalidValue("Signature file header is damaged.");
+    }
+    uint32_t l_headerCrc = l_header.m_headerCrc;
+    SigFileHeader l_crcHeader = l_header;
+    l_crcHeader.m_headerCrc = 0;
+    uint32_t l_crc = crc32(&l_crcHeader, sizeof(SigFileHeader));
+    l_crc = crc32(l_buf + sizeof(SigFileHeader), l_tableBytes - sizeof(SigFileHeader), l_crc);
+    if (l_crc != l_headerCrc) {
+        throw SpmInvalidValue("Signature file header is damaged.");
+    }
+    if ((l_header.m_parEntries != p_parEntries) || (l_header.m_accLatency != p_accLatency) ||
+        (l_header.m_channels != p_channels) || (l_header.m_maxRows != p_maxRows) ||
+        (l_header.m_maxCols != p_maxCols) || (l_header.m_memBits != p_memBits) ||
+        (l_header.m_sections < p_channels + 2)) {
+        throw SpmInvalidValue("Signature file was generated with different partition parameters.");
+    }
+
+    std::vector<SigFileSection> l_table(l_header.m_sections);
+    memcpy(l_table.data(), l_buf + sizeof(SigFileHeader), l_tableBytes - sizeof(SigFileHeader));
+    for (uint32_t i = 0; i < l_header.m_sections; ++i) {
+        if ((l_table[i].m_offset % SIG_FILE_ALIGN != 0) || (l_table[i].m_offset > p_file.size()) ||
+            (l_table[i].m_bytes > p_file.size() - l_table[i].m_offset)) {
+            throw SpmInvalidValue("Signature file section " + std::to_string(i) + " is out of range.");
+        }
+        if (p_verify && (crc32(l_buf + l_table[i].m_offset, l_table[i].m_bytes) != l_table[i].m_crc)) {
+            throw SpmInvalidValue("Signature file section " + std::to_string(i) + " is damaged.");
+        }
+    }
+
+    MatPartition l_res;
+    l_res.m_m = l_header.m_m;
+    l_res.m_n = l_header.m_n;
+    l_res.m_nnz = l_header.m_nnz;
+    l_res.m_mPad = l_header.m_mPad;
+    l_res.m_nPad = l_header.m_nPad;
+    l_res.m_nnzPad = l_header.m_nnzPad;
+    l_res.m_parEntries = l_header.m_parEntries;
+    l_res.m_accLatency = l_header.m_accLatency;
+    l_res.m_channels = l_header.m_channels;
+    l_res.m_maxRows = l_header.m_maxRows;
+    l_res.m_maxCols = l_header.m_maxCols;
+    l_res.m_memBits = l_header.m_memBits;
+    l_res.m_rbParamPtr = l_buf + l_table[0].m_offset;
+    l_res.m_rbParamSize = l_table[0].m_bytes;
+    l_res.m_parParamPtr = l_buf + l_table[1].m_offset;
+    l_res.m_parParamSize = l_table[1].m_bytes;
+    for (uint32_t i = 2; i < p_channels + 2; ++i) {
+        l_res.m_nnzValPtr.push_back(l_buf + l_table[i].m_offset);
+        l_res.m_nnzValSize.push_back(l_table[i].m_bytes);
+    }
+    if (p_extraSections != nullptr) {
+        p_extraSections->clear();
+        for (uint32_t i = p_channels + 2; i < l_header.m_sections; ++i) {
+            p_extraSections->push_back(std::make_pair(l_buf + l_table[i].m_offset, l_table[i].m_bytes));
+        }
+    }
+    return l_res;
+}
+
 }
 }
@@ -0,0 +1,676 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#include <sys/resource.h>
+#include <unistd.h>
+#include "gen_signature.hpp"
+#include "spmvPerfModel.hpp"
+
+using namespace std;
+
+// check that the row (p_keyId=0) or col (p_keyId=1) list is sorted and each entry still matches its original
+// coordinates through the data index list
+bool checkSorted(xf::sparse::SparseMatrix& p_spm,
+                 unsigned int p_keyId,
+                 const vector<uint32_t>& p_rowIdx,
+                 const vector<uint32_t>& p_colIdx) {
+    const vector<uint32_t>& l_key = (p_keyId == 0) ? p_spm.getRows() : p_spm.getCols();
+    for (uint32_t i = 0; i < p_spm.getNnz(); ++i) {
+        uint32_t l_dataIdx = p_spm.getData(i);
+        if ((p_spm.getRow(i) != p_rowIdx[l_dataIdx]) || (p_spm.getCol(i) != p_colIdx[l_dataIdx])) {
+            return false;
+        }
+        if ((i > 0) && (l_key[i - 1] > l_key[i])) {
+            return false;
+        }
+        if ((i > 0) && (l_key[i - 1] == l_key[i]) && (p_spm.getData(i - 1) > l_dataIdx)) {
+            return false; // not stable
+        }
+    }
+    return true;
+}
+
+// SpmPar with the kernel parameters of this build
+class BenchPar : public xf::sparse::SpmPar<SPARSE_dataType> {
+   public:
+    BenchPar(xf::sparse::ChParStrategy p_chParStrategy = xf::sparse::CHPAR_EVEN_SPLIT)
+        : xf::sparse::SpmPar<SPARSE_dataType>(SPARSE_parEntries,
+                                              SPARSE_accLatency,
+                                              SPARSE_hbmChannels,
+                                              SPARSE_maxRows,
+                                              SPARSE_maxCols,
+                                              SPARSE_hbmMemBits,
+                                              p_chParStrategy) {}
+};
+
+// COO matrix of the data path, the values are left empty when p_withData is false
+struct BenchMat {
+    xf::sparse::CooMatInfo m_info;
+    vector<uint32_t> m_rowIdx;
+    vector<uint32_t> m_colIdx;
+    vector<SPARSE_dataType> m_data;
+};
+
+BenchMat loadBenchMat(string p_dataPath, bool p_withData = true) {
+    BenchMat l_mat;
+    l_mat.m_info = xf::sparse::loadMatInfo(p_dataPath);
+    l_mat.m_rowIdx.resize(l_mat.m_info.m_nnz);
+    l_mat.m_colIdx.resize(l_mat.m_info.m_nnz);
+    readBin(p_dataPath + "row.bin", l_mat.m_rowIdx.data(), l_mat.m_info.m_nnz * sizeof(uint32_t));
+    readBin(p_dataPath + "col.bin", l_mat.m_colIdx.data(), l_mat.m_info.m_nnz * sizeof(uint32_t));
+    if (p_withData) {
+        l_mat.m_data.resize(l_mat.m_info.m_nnz);
+        readBin(p_dataPath + "data.bin", l_mat.m_data.data(), l_mat.m_info.m_nnz * sizeof(SPARSE_dataType));
+    }
+    return l_mat;
+}
+
+void printMatInfo(const BenchMat& p_mat) {
+    printf("INFO: matrix %s, m, n, nnzs = %d, %d, %llu\n", p_mat.m_info.m_name.c_str(), p_mat.m_info.m_m,
+           p_mat.m_info.m_n, (unsigned long long)p_mat.m_info.m_nnz);
+}
+
+// partition the matrix with the values p_data, its own ones by default
+xf::sparse::MatPartition partitionBenchMat(BenchPar& p_spmPar,
+                                           const BenchMat& p_mat,
+                                           const SPARSE_dataType* p_data = nullptr) {
+    return p_spmPar.partitionCooMat(p_mat.m_info.m_m, p_mat.m_info.m_n, p_mat.m_info.m_nnz, p_mat.m_rowIdx.data(),
+                                    p_mat.m_colIdx.data(), (p_data == nullptr) ? p_mat.m_data.data() : p_data, 0);
+}
+
+// 1, 2, 4, ... threads up to and including p_maxThreads
+vector<unsigned int> getThreadCounts(unsigned int p_maxThreads) {
+    vector<unsigned int> l_threads;
+    for (unsigned int t = 1; t < p_maxThreads; t *= 2) {
+        l_threads.push_back(t);
+    }
+    l_threads.push_back(p_maxThreads);
+    return l_threads;
+}
+
+// y = A x of a COO spmv, the spmv model results are checked against it; m_yMax is the largest |y|, but at least 1,
+// and scales the error bounds
+struct RefSpmv {
+    vector<SPARSE_dataType> m_x;
+    vector<SPARSE_dataType> m_y;
+    SPARSE_dataType m_yMax;
+};
+
+RefSpmv refSpmv(const BenchMat& p_mat) {
+    RefSpmv l_ref;
+    l_ref.m_x.resize(p_mat.m_info.m_n);
+    l_ref.m_y.assign(p_mat.m_info.m_m, 0);
+    for (uint32_t i = 0; i < p_mat.m_info.m_n; ++i) {
+        l_ref.m_x[i] = 1.0 + (i % 17) * 0.125;
+    }
+    for (uint64_t i = 0; i < p_mat.m_info.m_nnz; ++i) {
+        l_ref.m_y[p_mat.m_rowIdx[i]] += p_mat.m_data[i] * l_ref.m_x[p_mat.m_colIdx[i]];
+    }
+    l_ref.m_yMax = 1;
+    for (uint32_t i = 0; i < p_mat.m_info.m_m; ++i) {
+        l_ref.m_yMax = max(l_ref.m_yMax, (SPARSE_dataType)fabs(l_ref.m_y[i]));
+    }
+    return l_ref;
+}
+
+// largest |y - yRef| over all rows
+SPARSE_dataType maxErr(const vector<SPARSE_dataType>& p_y, const vector<SPARSE_dataType>& p_yRef) {
+    SPARSE_dataType l_err = 0;
+    for (size_t i = 0; i < p_yRef.size(); ++i) {
+        l_err = max(l_err, (SPARSE_dataType)fabs(p_y[i] - p_yRef[i]));
+    }
+    return l_err;
+}
+
+int benchSort(string p_dataPath, unsigned int p_maxThreads) {
+    TimePointType l_timer[2];
+    BenchMat l_mat = loadBenchMat(p_dataPath, false);
+    const xf::sparse::CooMatInfo& l_matInfo = l_mat.m_info;
+
+    printMatInfo(l_mat);
+    printf("DATA_CSV:, threads, sort_by_row [ms], sort_by_col [ms]\n");
+    bool l_pass = true;
+    for (unsigned int t : getThreadCounts(p_maxThreads)) {
+        double l_timeMs[2];
+        for (unsigned int k = 0; k < 2; ++k) {
+            xf::sparse::SparseMatrix l_spm;
+            l_spm.loadCoo(l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_mat.m_rowIdx.data(), l_mat.m_colIdx.data(),
+                          0);
+            l_spm.setSortThreads(t);
+            l_timer[0] = chrono::high_resolution_clock::now();
+            if (k == 0) {
+                l_spm.sort_by_row();
+            } else {
+                l_spm.sort_by_col();
+            }
+            showTimeData(k == 0 ? "INFO: sort_by_row time: " : "INFO: sort_by_col time: ", l_timer[0], l_timer[1],
+                         &l_timeMs[k]);
+            l_pass = l_pass && checkSorted(l_spm, k, l_mat.m_rowIdx, l_mat.m_colIdx);
+        }
+        printf("DATA_CSV:, %d, %f, %f\n", t, l_timeMs[0], l_timeMs[1]);
+    }
+    if (!l_pass) {
+        printf("ERROR: sorted matrix is wrong.\n");
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
+
+double getPeakRssMB() {
+    struct rusage l_usage;
+    getrusage(RUSAGE_SELF, &l_usage);
+    return l_usage.ru_maxrss / 1024.0;
+}
+
+// current resident set size, read from /proc/self/statm
+double getRssMB() {
+    long l_pages = 0, l_resident = 0;
+    FILE* l_file = fopen("/proc/self/statm", "r");
+    if (l_file != nullptr) {
+        if (fscanf(l_file, "%ld %ld", &l_pages, &l_resident) != 2) {
+            l_resident = 0;
+        }
+        fclose(l_file);
+    }
+    return l_resident * (sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0));
+}
+
+// copy of all signature buffers, used to check that partitioning is deterministic across thread counts
+vector<vector<uint8_t> > getSigBufs(xf::sparse::MatPartition& p_matPar) {
+    vector<vector<uint8_t> > l_bufs;
+    uint8_t* l_rbParam = reinterpret_cast<uint8_t*>(p_matPar.m_rbParamPtr);
+    uint8_t* l_parParam = reinterpret_cast<uint8_t*>(p_matPar.m_parParamPtr);
+    l_bufs.push_back(vector<uint8_t>(l_rbParam, l_rbParam + p_matPar.m_rbParamSize));
+    l_bufs.push_back(vector<uint8_t>(l_parParam, l_parParam + p_matPar.m_parParamSize));
+    for (unsigned int i = 0; i < p_matPar.m_nnzValPtr.size(); ++i) {
+        uint8_t* l_nnzVal = reinterpret_cast<uint8_t*>(p_matPar.m_nnzValPtr[i]);
+        l_bufs.push_back(vector<uint8_t>(l_nnzVal, l_nnzVal + p_matPar.m_nnzValSize[i]));
+    }
+    return l_bufs;
+}
+
+int benchPartition(string p_dataPath, unsigned int p_maxThreads) {
+    TimePointType l_timer[2];
+    BenchMat l_mat = loadBenchMat(p_dataPath);
+    const xf::sparse::CooMatInfo& l_matInfo = l_mat.m_info;
+    double l_inputMB = l_matInfo.m_nnz * (2 * sizeof(uint32_t) + sizeof(SPARSE_dataType)) / (1024.0 * 1024.0);
+    double l_loadedMB = getPeakRssMB();
+
+    vector<vector<uint8_t> > l_refBufs;
+    bool l_pass = true;
+    for (unsigned int t : getThreadCounts(p_maxThreads)) {
+        BenchPar l_spmPar;
+        l_spmPar.setThreads(t);
+        l_timer[0] = chrono::high_resolution_clock::now();
+        xf::sparse::MatPartition l_matPar = partitionBenchMat(l_spmPar, l_mat);
+        double l_timeMs = 0;
+        showTimeData("INFO: Matrix partition time: ", l_timer[0], l_timer[1], &l_timeMs);
+        double l_peakMB = getPeakRssMB();
+        double l_sigMB = l_matPar.m_rbParamSize + l_matPar.m_parParamSize;
+        for (unsigned int i = 0; i < l_matPar.m_nnzValSize.size(); ++i) {
+            l_sigMB += l_matPar.m_nnzValSize[i];
+        }
+        l_sigMB /= (1024.0 * 1024.0);
+        if (l_refBufs.empty()) {
+            l_refBufs = getSigBufs(l_matPar);
+            printf("INFO: matrix %s, m, n, nnzs = %d, %d, %llu, padded nnzs = %llu\n", l_matInfo.m_name.c_str(),
+                   l_matPar.m_m, l_matPar.m_n, (unsigned long long)l_matPar.m_nnz,
+                   (unsigned long long)l_matPar.m_nnzPad);
+            printf("DATA_CSV:, matrix_name, input COO [MB], signature [MB], RSS after loading [MB], peak RSS [MB], "
+                   "partition time [ms]\n");
+            printf("DATA_CSV:, %s, %f, %f, %f, %f, %f\n", l_matInfo.m_name.c_str(), l_inputMB, l_sigMB,
+                   l_loadedMB, l_peakMB, l_timeMs);
+            printf("DATA_CSV:, threads, partition time [ms]");
+            for (auto& l_stage : l_spmPar.getStageTimes()) {
+                printf(", %s [ms]", l_stage.first.c_str());
+            }
+            printf("\n");
+        } else if (getSigBufs(l_matPar) != l_refBufs) {
+            printf("ERROR: signature generated with %d threads differs from the single thread one.\n", t);
+            l_pass = false;
+        }
+        printf("DATA_CSV:, %d, %f", t, l_timeMs);
+        for (auto& l_stage : l_spmPar.getStageTimes()) {
+            printf(", %f", l_stage.second);
+        }
+        printf("\n");
+    }
+    return l_pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// partition the matrix given in COO, CSR or CSC format, the COO arrays are released before the partition so that
+// the RSS numbers only reflect the chosen input format
+int benchInput(string p_dataPath, string p_format) {
+    TimePointType l_timer[2];
+    BenchMat l_mat = loadBenchMat(p_dataPath);
+    const xf::sparse::CooMatInfo& l_matInfo = l_mat.m_info;
+
+    vector<uint32_t> l_ptr, l_idx;
+    vector<SPARSE_dataType> l_val;
+    if ((p_format == "csr") || (p_format == "csc")) {
+        // stable counting sort along rows (CSR) or cols (CSC)
+        bool l_csr = (p_format == "csr");
+        const vector<uint32_t>& l_major = l_csr ? l_mat.m_rowIdx : l_mat.m_colIdx;
+        const vector<uint32_t>& l_minor = l_csr ? l_mat.m_colIdx : l_mat.m_rowIdx;
+        uint32_t l_dim = l_csr ? l_matInfo.m_m : l_matInfo.m_n;
+        l_ptr.assign(l_dim + 1, 0);
+        l_idx.resize(l_matInfo.m_nnz);
+        l_val.resize(l_matInfo.m_nnz);
+        for (uint32_t i = 0; i < l_matInfo.m_nnz; ++i) {
+            l_ptr[l_major[i] + 1]++;
+        }
+        partial_sum(l_ptr.begin(), l_ptr.end(), l_ptr.begin());
+        vector<uint32_t> l_pos(l_ptr.begin(), l_ptr.end() - 1);
+        for (uint32_t i = 0; i < l_matInfo.m_nnz; ++i) {
+            uint32_t l_dst = l_pos[l_major[i]]++;
+            l_idx[l_dst] = l_minor[i];
+            l_val[l_dst] = l_mat.m_data[i];
+        }
+        vector<uint32_t>().swap(l_mat.m_rowIdx);
+        vector<uint32_t>().swap(l_mat.m_colIdx);
+        vector<SPARSE_dataType>().swap(l_mat.m_data);
+    } else if (p_format != "coo") {
+        printf("ERROR: unknown input format %s, use coo, csr or csc.\n", p_format.c_str());
+        return EXIT_FAILURE;
+    }
+    double l_inputMB =
+        (l_ptr.size() + l_idx.size() + l_mat.m_rowIdx.size() + l_mat.m_colIdx.size()) * sizeof(uint32_t) +
+        (l_val.size() + l_mat.m_data.size()) * sizeof(SPARSE_dataType);
+    l_inputMB /= (1024.0 * 1024.0);
+    double l_loadedMB = getRssMB();
+
+    BenchPar l_spmPar;
+    xf::sparse::MatPartition l_matPar;
+    l_timer[0] = chrono::high_resolution_clock::now();
+    if (p_format == "csr") {
+        l_matPar = l_spmPar.partitionCsrMat(l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_ptr.data(),
+                                            l_idx.data(), l_val.data(), 0);
+    } else if (p_format == "csc") {
+        l_matPar = l_spmPar.partitionCscMat(l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_idx.data(),
+                                            l_ptr.data(), l_val.data(), 0);
+    } else {
+        l_matPar = partitionBenchMat(l_spmPar, l_mat);
+    }
+    double l_timeMs = 0;
+    showTimeData("INFO: Matrix partition time: ", l_timer[0], l_timer[1], &l_timeMs);
+    double l_peakMB = getPeakRssMB();
+    // the hash lets the runs of the different formats be checked against each other
+    uint64_t l_sigHash = 0;
+    for (auto& l_buf : getSigBufs(l_matPar)) {
+        l_sigHash = xf::sparse::hash64(l_buf.data(), l_buf.size(), l_sigHash);
+    }
+    printf("INFO: matrix %s, m, n, nnzs = %d, %d, %llu, padded nnzs = %llu\n", l_matInfo.m_name.c_str(), l_matPar.m_m,
+           l_matPar.m_n, (unsigned long long)l_matPar.m_nnz, (unsigned long long)l_matPar.m_nnzPad);
+    printf("DATA_CSV:, matrix_name, format, input [MB], RSS after loading [MB], peak RSS [MB], partition time [ms], "
+           "signature hash\n");
+    printf("DATA_CSV:, %s, %s, %f, %f, %f, %f, %016llx\n", l_matInfo.m_name.c_str(), p_format.c_str(), l_inputMB,
+           l_loadedMB, l_peakMB, l_timeMs, (unsigned long long)l_sigHash);
+    return EXIT_SUCCESS;
+}
+
+// per channel memory blocks of the matrix partitioned with each channel partition strategy
+int benchBalance(string p_dataPath) {
+    TimePointType l_timer[2];
+    BenchMat l_mat = loadBenchMat(p_dataPath);
+
+    printMatInfo(l_mat);
+    printf("DATA_CSV:, strategy, partition time [ms], max channel blocks, average channel blocks, imbalance, "
+           "sum of partition max channel blocks, blocks of channel 0 .. %d\n",
+           SPARSE_hbmChannels - 1);
+    const char* l_names[] = {"even_split", "balanced"};
+    xf::sparse::ChParStrategy l_strategies[] = {xf::sparse::CHPAR_EVEN_SPLIT, xf::sparse::CHPAR_BALANCED};
+    for (unsigned int s = 0; s < 2; ++s) {
+        BenchPar l_spmPar(l_strategies[s]);
+        double l_timeMs = 0;
+        l_timer[0] = chrono::high_resolution_clock::now();
+        partitionBenchMat(l_spmPar, l_mat);
+        showTimeData("INFO: Matrix partition time: ", l_timer[0], l_timer[1], &l_timeMs);
+        vector<uint32_t> l_bks = l_spmPar.getChTotalBks();
+        double l_avgBks = accumulate(l_bks.begin(), l_bks.end(), 0.0) / l_bks.size();
+        printf("DATA_CSV:, %s, %f, %d, %f, %f, %llu", l_names[s], l_timeMs, *max_element(l_bks.begin(), l_bks.end()),
+               l_avgBks, l_spmPar.getChImbalance(), (unsigned long long)l_spmPar.getParMaxChBks());
+        for (uint32_t l_chBks : l_bks) {
+            printf(", %d", l_chBks);
+        }
+        printf("\n");
+    }
+    return EXIT_SUCCESS;
+}
+
+// padding overhead and partitions per row block of the matrix partitioned without and with reordering
+int benchReorder(string p_dataPath) {
+    TimePointType l_timer[2];
+    BenchMat l_mat = loadBenchMat(p_dataPath);
+    const xf::sparse::CooMatInfo& l_matInfo = l_mat.m_info;
+
+    printMatInfo(l_mat);
+    printf("DATA_CSV:, matrix_name, reorder, partition time [ms], padded nnzs, padded nnzs / nnzs, "
+           "estimated padded nnzs before, estimated padded nnzs after, cols renumbered, row blocks, partitions, "
+           "partitions / row block\n");
+    const char* l_names[] = {"none", "pad", "rcm"};
+    xf::sparse::SpmReorder l_reorders[] = {xf::sparse::REORDER_NONE, xf::sparse::REORDER_PAD, xf::sparse::REORDER_RCM};
+    // RCM is a symmetric reordering and only applies to square matrices
+    unsigned int l_numReorders = (l_matInfo.m_m == l_matInfo.m_n) ? 3 : 2;
+    for (unsigned int r = 0; r < l_numReorders; ++r) {
+        BenchPar l_spmPar;
+        l_spmPar.setReorder(l_reorders[r]);
+        double l_timeMs = 0;
+        l_timer[0] = chrono::high_resolution_clock::now();
+        xf::sparse::MatPartition l_matPar = partitionBenchMat(l_spmPar, l_mat);
+        showTimeData("INFO: Matrix partition time: ", l_timer[0], l_timer[1], &l_timeMs);
+        printf("DATA_CSV:, %s, %s, %f, %llu, %f, %llu, %llu, %s, %u, %u, %f\n", l_matInfo.m_name.c_str(), l_names[r],
+               l_timeMs, (unsigned long long)l_matPar.m_nnzPad, (double)l_matPar.m_nnzPad / l_matPar.m_nnz,
+               (unsigned long long)l_spmPar.getNnzPadEst(0), (unsigned long long)l_spmPar.getNnzPadEst(1),
+               l_spmPar.getColPerm().empty() ? "no" : "yes", l_spmPar.getTotalRbs(), l_spmPar.getTotalPars(),
+               (double)l_spmPar.getTotalPars() / l_spmPar.getTotalRbs());
+    }
+    return EXIT_SUCCESS;
+}
+
+// modelled device memory traffic of one spmv for each partition strategy, the y of the software kernel model is
+// checked against a COO spmv
+int benchModel(string p_dataPath) {
+    TimePointType l_timer[2];
+    BenchMat l_mat = loadBenchMat(p_dataPath);
+    const xf::sparse::CooMatInfo& l_matInfo = l_mat.m_info;
+
+    RefSpmv l_ref = refSpmv(l_mat);
+    vector<SPARSE_dataType> l_xPerm(l_matInfo.m_n), l_y(l_matInfo.m_m), l_yPerm(l_matInfo.m_m);
+
+    printMatInfo(l_mat);
+    printf("DATA_CSV:, strategy, reorder, model time [ms], max channel nnz bytes, total bytes, x bytes, "
+           "param bytes, max y error, estimated spmv time [us], estimated channel imbalance\n");
+    xf::sparse::SpmvPerfModel l_perfModel;
+    const char* l_strategyNames[] = {"even_split", "balanced"};
+    const char* l_reorderNames[] = {"none", "pad", "rcm"};
+    unsigned int l_numReorders = (l_matInfo.m_m == l_matInfo.m_n) ? 3 : 2;
+    bool l_pass = true;
+    for (unsigned int s = 0; s < 2; ++s) {
+        for (unsigned int r = 0; r < l_numReorders; ++r) {
+            BenchPar l_spmPar((xf::sparse::ChParStrategy)s);
+            l_spmPar.setReorder((xf::sparse::SpmReorder)r);
+            xf::sparse::MatPartition l_matPar = partitionBenchMat(l_spmPar, l_mat);
+            double l_timeMs = 0;
+            l_timer[0] = chrono::high_resolution_clock::now();
+            xf::sparse::SpmvModel<SPARSE_dataType> l_model(l_matPar);
+            l_spmPar.permuteVec(false, l_matInfo.m_n, l_ref.m_x.data(), l_xPerm.data());
+            l_model.run(l_xPerm.data(), l_yPerm.data());
+            l_spmPar.unpermuteVec(true, l_matInfo.m_m, l_yPerm.data(), l_y.data());
+            showTimeData("INFO: Spmv model time: ", l_timer[0], l_timer[1], &l_timeMs);
+            SPARSE_dataType l_err = maxErr(l_y, l_ref.m_y);
+            l_pass = l_pass && (l_err <= 1e-10 * l_ref.m_yMax);
+            const xf::sparse::SpmvTraffic& l_traffic = l_model.getTraffic();
+            // busiest over average channel cycles
+            vector<double> l_chCycles = l_perfModel.estimateChCycles(l_model.getWork());
+            double l_imbalance = *max_element(l_chCycles.begin(), l_chCycles.end()) * l_chCycles.size() /
+                                 accumulate(l_chCycles.begin(), l_chCycles.end(), 0.0);
+            printf("DATA_CSV:, %s, %s, %f, %llu, %llu, %llu, %llu, %e, %f, %f\n", l_strategyNames[s],
+                   l_reorderNames[r], l_timeMs, (unsigned long long)l_traffic.getMaxNnzBytes(),
+                   (unsigned long long)l_traffic.getTotalBytes(), (unsigned long long)l_traffic.m_xBytes,
+                   (unsigned long long)(l_traffic.m_parParamBytes + l_traffic.m_rbParamBytes), l_err,
+                   l_perfModel.estimateSeconds(l_model.getWork()) * 1e6, l_imbalance);
+        }
+    }
+    if (!l_pass) {
+        printf("ERROR: matrix %s spmv model result differs.\n", l_matInfo.m_name.c_str());
+    }
+    return l_pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// nnz value storage and spmv accuracy of each value type, the values are accumulated in double precision, so the y
+// of the software kernel model must match a COO spmv with the rounded values
+int benchPrecision(string p_dataPath) {
+    BenchMat l_mat = loadBenchMat(p_dataPath);
+    const xf::sparse::CooMatInfo& l_matInfo = l_mat.m_info;
+
+    RefSpmv l_ref = refSpmv(l_mat);
+    vector<SPARSE_dataType> l_y(l_matInfo.m_m);
+
+    printMatInfo(l_mat);
+    printf("DATA_CSV:, matrix_name, value type, max channel nnz bytes, total nnz bytes, nnz bytes / fp64 nnz bytes, "
+           "estimated spmv time [us], max relative y error\n");
+    xf::sparse::SpmvPerfModel l_perfModel;
+    const char* l_names[] = {"fp64", "fp32", "bf16"};
+    uint64_t l_fp64Bytes = 0;
+    bool l_pass = true;
+    for (unsigned int t = 0; t < 3; ++t) {
+        xf::sparse::SpmValType l_valType = (xf::sparse::SpmValType)t;
+        BenchPar l_spmPar;
+        l_spmPar.setValType(l_valType);
+        xf::sparse::MatPartition l_matPar = partitionBenchMat(l_spmPar, l_mat);
+        xf::sparse::SpmvModel<SPARSE_dataType> l_model(l_matPar);
+        l_model.run(l_ref.m_x.data(), l_y.data());
+
+        vector<SPARSE_dataType> l_yRound(l_matInfo.m_m, 0);
+        uint8_t l_valBuf[sizeof(double)];
+        for (uint64_t i = 0; i < l_matInfo.m_nnz; ++i) {
+            xf::sparse::storeVal(l_valType, l_mat.m_data[i], l_valBuf);
+            l_yRound[l_mat.m_rowIdx[i]] += xf::sparse::loadVal(l_valType, l_valBuf) * l_ref.m_x[l_mat.m_colIdx[i]];
+        }
+        SPARSE_dataType l_err = maxErr(l_y, l_ref.m_y);
+        l_pass = l_pass && (maxErr(l_y, l_yRound) <= 1e-10 * l_ref.m_yMax);
+        const xf::sparse::SpmvTraffic& l_traffic = l_model.getTraffic();
+        uint64_t l_nnzBytes = accumulate(l_matPar.m_nnzValSize.begin(), l_matPar.m_nnzValSize.end(), (uint64_t)0);
+        l_fp64Bytes = (t == 0) ? l_nnzBytes : l_fp64Bytes;
+        printf("DATA_CSV:, %s, %s, %llu, %llu, %f, %f, %e\n", l_matInfo.m_name.c_str(), l_names[t],
+               (unsigned long long)l_traffic.getMaxNnzBytes(), (unsigned long long)l_nnzBytes,
+               (double)l_nnzBytes / l_fp64Bytes, l_perfModel.estimateSeconds(l_model.getWork()) * 1e6,
+               l_err / l_ref.m_yMax);
+    }
+    if (!l_pass) {
+        printf("ERROR: matrix %s spmv model result differs from the rounded values.\n", l_matInfo.m_name.c_str());
+    }
+    return l_pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// index block bytes of the 16-bit and the delta encoded index streams, the y of the software kernel model is
+// checked against a COO spmv for both
+int benchIndex(string p_dataPath) {
+    BenchMat l_mat = loadBenchMat(p_dataPath);
+    const xf::sparse::CooMatInfo& l_matInfo = l_mat.m_info;
+
+    RefSpmv l_ref = refSpmv(l_mat);
+    vector<SPARSE_dataType> l_y(l_matInfo.m_m);
+
+    printMatInfo(l_mat);
+    printf("DATA_CSV:, matrix_name, index type, index bytes, index bytes / 16-bit index bytes, total nnz bytes, "
+           "max channel nnz bytes, partition time [ms]\n");
+    const char* l_names[] = {"u16", "delta"};
+    uint64_t l_u16Bytes = 0;
+    bool l_pass = true;
+    for (unsigned int t = 0; t < 2; ++t) {
+        TimePointType l_timer[2];
+        BenchPar l_spmPar;
+        l_spmPar.setIdxType((xf::sparse::SpmIdxType)t);
+        double l_timeMs = 0;
+        l_timer[0] = chrono::high_resolution_clock::now();
+        xf::sparse::MatPartition l_matPar = partitionBenchMat(l_spmPar, l_mat);
+        showTimeData("INFO: Matrix partition time: ", l_timer[0], l_timer[1], &l_timeMs);
+        xf::sparse::SpmvModel<SPARSE_dataType> l_model(l_matPar);
+        l_model.run(l_ref.m_x.data(), l_y.data());
+        l_pass = l_pass && (maxErr(l_y, l_ref.m_y) <= 1e-10 * l_ref.m_yMax);
+        vector<uint32_t> l_idxBks = l_spmPar.getChIdxBks();
+        uint64_t l_idxBytes = accumulate(l_idxBks.begin(), l_idxBks.end(), (uint64_t)0) * SPARSE_hbmMemBits / 8;
+        l_u16Bytes = (t == 0) ? l_idxBytes : l_u16Bytes;
+        uint64_t l_nnzBytes = accumulate(l_matPar.m_nnzValSize.begin(), l_matPar.m_nnzValSize.end(), (uint64_t)0);
+        printf("DATA_CSV:, %s, %s, %llu, %f, %llu, %llu, %f\n", l_matInfo.m_name.c_str(), l_names[t],
+               (unsigned long long)l_idxBytes, (l_u16Bytes == 0) ? 1.0 : (double)l_idxBytes / l_u16Bytes,
+               (unsigned long long)l_nnzBytes, (unsigned long long)l_model.getTraffic().getMaxNnzBytes(), l_timeMs);
+    }
+    if (!l_pass) {
+        printf("ERROR: matrix %s spmv model result differs.\n", l_matInfo.m_name.c_str());
+    }
+    return l_pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// fit the performance model to the solver times in the DATA_CSV lines of pcgtest logs, each matrix is read from
+// p_dataPath and partitioned the way the logged run did
+int benchCalibrate(string p_dataPath, const vector<string>& p_logs) {
+    xf::sparse::SpmvPerfModel l_perfModel;
+    vector<string> l_names;
+    vector<xf::sparse::SpmvWork> l_works;
+    vector<uint32_t> l_iters;
+    vector<double> l_seconds;
+    for (const string& l_log : p_logs) {
+        ifstream l_file(l_log);
+        if (!l_file.is_open()) {
+            printf("ERROR: cannot open %s.\n", l_log.c_str());
+            return EXIT_FAILURE;
+        }
+        string l_line;
+        while (getline(l_file, l_line)) {
+            if (l_line.compare(0, 9, "DATA_CSV:") != 0) {
+                continue;
+            }
+            vector<string> l_fields;
+            size_t l_start = l_line.find(',');
+            while (l_start != string::npos) {
+                size_t l_end = l_line.find(',', l_start + 1);
+                string l_field = l_line.substr(l_start + 1, l_end - l_start - 1);
+                l_field.erase(0, l_field.find_first_not_of(' '));
+                l_fields.push_back(l_field);
+                l_start = l_end;
+            }
+            if (l_fields.size() < 7 || l_fields[0] == "matrix_name") {
+                continue;
+            }
+            BenchMat l_mat = loadBenchMat(p_dataPath + l_fields[0] + "/");
+            BenchPar l_spmPar;
+            if (l_fields.size() > 7 && l_fields[7] == "rcm") {
+                l_spmPar.setReorder(xf::sparse::REORDER_RCM);
+            }
+            xf::sparse::MatPartition l_matPar = partitionBenchMat(l_spmPar, l_mat);
+            xf::sparse::SpmvModel<SPARSE_dataType> l_model(l_matPar);
+            l_names.push_back(l_fields[0] + ((l_fields.size() > 7) ? " " + l_fields[7] : ""));
+            l_works.push_back(l_model.getWork());
+            l_iters.push_back(max(atoi(l_fields[3].c_str()), 1));
+            l_seconds.push_back(atof(l_fields[6].c_str()));
+            l_perfModel.addSample(l_works.back(), l_iters.back(), l_seconds.back());
+        }
+    }
+    if (l_perfModel.getSamples() == 0) {
+        printf("ERROR: no pcgtest results found.\n");
+        return EXIT_FAILURE;
+    }
+    vector<double> l_defaultErrs = l_perfModel.getSampleErrors();
+    double l_rmsErr = l_perfModel.calibrate();
+    vector<double> l_errs = l_perfModel.getSampleErrors();
+    printf("DATA_CSV:, matrix, iterations, solver time [s], default estimate [s], calibrated estimate [s]\n");
+    for (uint32_t i = 0; i < l_works.size(); ++i) {
+        printf("DATA_CSV:, %s, %d, %f, %f, %f\n", l_names[i].c_str(), l_iters[i], l_seconds[i],
+               l_seconds[i] * (1 + l_defaultErrs[i]), l_seconds[i] * (1 + l_errs[i]));
+    }
+    const char* l_termNames[] = {"nnz", "x", "x reload", "accumulation", "rows", "vectors", "launch"};
+    printf("INFO: calibrated weights:");
+    for (unsigned int t = 0; t < xf::sparse::PERF_TERMS; ++t) {
+        printf(" %s %f%s", l_termNames[t], l_perfModel.getParams().m_weights[t],
+               (t + 1 < xf::sparse::PERF_TERMS) ? "," : "\n");
+    }
+    printf("INFO: rms relative error after calibration %f\n", l_rmsErr);
+    return EXIT_SUCCESS;
+}
+
+int benchUpdate(string p_dataPath, unsigned int p_maxThreads, unsigned int p_iters) {
+    TimePointType l_timer[2];
+    BenchMat l_mat = loadBenchMat(p_dataPath);
+    const xf::sparse::CooMatInfo& l_matInfo = l_mat.m_info;
+    vector<SPARSE_dataType> l_newData(l_matInfo.m_nnz);
+    for (uint64_t i = 0; i < l_matInfo.m_nnz; ++i) {
+        l_newData[i] = l_mat.m_data[i] * 2 + 1;
+    }
+
+    // reference signature of the new values, partitioned from scratch
+    BenchPar l_refPar;
+    xf::sparse::MatPartition l_refMatPar = partitionBenchMat(l_refPar, l_mat, l_newData.data());
+    vector<vector<uint8_t> > l_refBufs = getSigBufs(l_refMatPar);
+
+    printf("INFO: matrix %s, m, n, nnzs = %d, %d, %llu, padded nnzs = %llu\n", l_matInfo.m_name.c_str(),
+           l_refMatPar.m_m, l_refMatPar.m_n, (unsigned long long)l_refMatPar.m_nnz,
+           (unsigned long long)l_refMatPar.m_nnzPad);
+    printf("DATA_CSV:, threads, partition time [ms], update time [ms], update time per nnz [ns]\n");
+    bool l_pass = true;
+    for (unsigned int t : getThreadCounts(p_maxThreads)) {
+        BenchPar l_spmPar;
+        l_spmPar.setThreads(t);
+        double l_parTimeMs = 0, l_updateTimeMs = 0;
+        l_timer[0] = chrono::high_resolution_clock::now();
+        partitionBenchMat(l_spmPar, l_mat);
+        showTimeData("INFO: Matrix partition time: ", l_timer[0], l_timer[1], &l_parTimeMs);
+        xf::sparse::MatPartition l_matPar;
+        l_timer[0] = chrono::high_resolution_clock::now();
+        for (unsigned int i = 0; i < p_iters; ++i) {
+            l_matPar = l_spmPar.updateMat((i % 2 == 0) ? l_mat.m_data.data() : l_newData.data());
+        }
+        l_matPar = l_spmPar.updateMat(l_newData.data());
+        showTimeData("INFO: Matrix update time: ", l_timer[0], l_timer[1], &l_updateTimeMs);
+        l_updateTimeMs /= (p_iters + 1);
+        if (getSigBufs(l_matPar) != l_refBufs) {
+            printf("ERROR: updated signature with %d threads differs from the partitioned one.\n", t);
+            l_pass = false;
+        }
+        printf("DATA_CSV:, %d, %f, %f, %f\n", t, l_parTimeMs, l_updateTimeMs,
+               l_updateTimeMs * 1e6 / l_matInfo.m_nnz);
+    }
+    return l_pass ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        cout << "Usage: " << argv[0] << " sort <data_path> [max threads]" << endl;
+        cout << "       " << argv[0] << " partition <data_path> [max threads]" << endl;
+        cout << "       " << argv[0] << " update <data_path> [max threads]" << endl;
+        cout << "       " << argv[0] << " input <data_path> [coo|csr|csc]" << endl;
+        cout << "       " << argv[0] << " balance <data_path>" << endl;
+        cout << "       " << argv[0] << " reorder <data_path>" << endl;
+        cout << "       " << argv[0] << " model <data_path>" << endl;
+        cout << "       " << argv[0] << " precision <data_path>" << endl;
+        cout << "       " << argv[0] << " index <data_path>" << endl;
+        cout << "       " << argv[0] << " calibrate <data_path> <pcgtest log> [pcgtest log ...]" << endl;
+        return EXIT_FAILURE;
+    }
+    int arg = 0;
+    string l_mode = argv[++arg];
+    string l_dataPath = string(argv[++arg]) + "/";
+    if (l_mode == "input") {
+        return benchInput(l_dataPath, (argc > arg + 1) ? argv[++arg] : "coo");
+    } else if (l_mode == "balance") {
+        return benchBalance(l_dataPath);
+    } else if (l_mode == "reorder") {
+        return benchReorder(l_dataPath);
+    } else if (l_mode == "model") {
+        return benchModel(l_dataPath);
+    } else if (l_mode == "precision") {
+        return benchPrecision(l_dataPath);
+    } else if (l_mode == "index") {
+        return benchIndex(l_dataPath);
+    } else if (l_mode == "calibrate") {
+        return benchCalibrate(l_dataPath, vector<string>(argv + arg + 1, argv + argc));
+    }
+    unsigned int l_maxThreads = thread::hardware_concurrency();
+    if (argc > arg + 1) {
+        l_maxThreads = atoi(argv[++arg]);
+    }
+    l_maxThreads = (l_maxThreads == 0) ? 1 : l_maxThreads;
+    if (l_mode == "sort") {
+        return benchSort(l_dataPath, l_maxThreads);
+    } else if (l_mode == "partition") {
+        return benchPartition(l_dataPath, l_maxThreads);
+    } else if (l_mode == "update") {
+        return benchUpdate(l_dataPath, l_maxThreads, 10);
+    }
+    cout << "ERROR: unknown benchmark " << l_mode << endl;
+    return EXIT_FAILURE;
+}
@@ -15,15 +15,57 @@
 */
 
 #include "gen_signature.hpp"
+#include "spmvModel.hpp"
 
 using namespace std;
 
+bool isSamePartition(xf::sparse::MatPartition& p_a, xf::sparse::MatPartition& p_b) {
+    bool l_equal = (p_a.m_nnzPad == p_b.m_nnzPad) && (p_a.m_rbParamSize == p_b.m_rbParamSize) &&
+                   (memcmp(p_a.m_rbParamPtr, p_b.m_rbParamPtr, p_b.m_rbParamSize) == 0) &&
+                   (p_a.m_parParamSize == p_b.m_parParamSize) &&
+                   (memcmp(p_a.m_parParamPtr, p_b.m_parParamPtr, p_b.m_parParamSize) == 0) &&
+                   (p_a.m_nnzValPtr.size() == p_b.m_nnzValPtr.size());
+    for (unsigned int c = 0; l_equal && (c < p_b.m_nnzValPtr.size()); ++c) {
+        l_equal = (p_a.m_nnzValSize[c] == p_b.m_nnzValSize[c]) &&
+                  (memcmp(p_a.m_nnzValPtr[c], p_b.m_nnzValPtr[c], p_b.m_nnzValSize[c]) == 0);
+    }
+    return l_equal;
+}
+
+// compress COO entries along p_major (rows for CSR, cols for CSC), entries keep their COO order within a row/col
+void compressCoo(uint32_t p_dim,
+                 const vector<uint32_t>& p_major,
+                 const vector<uint32_t>& p_minor,
+                 const vector<SPARSE_dataType>& p_data,
+                 vector<uint32_t>& p_ptr,
+                 vector<uint32_t>& p_idx,
+                 vector<SPARSE_dataType>& p_val) {
+    p_ptr.assign(p_dim + 1, 0);
+    p_idx.resize(p_major.size());
+    p_val.resize(p_major.size());
+    for (uint32_t i = 0; i < p_major.size(); ++i) {
+        p_ptr[p_major[i] + 1]++;
+    }
+    partial_sum(p_ptr.begin(), p_ptr.end(), p_ptr.begin());
+    vector<uint32_t> l_pos(p_ptr.begin(), p_ptr.end() - 1);
+    for (uint32_t i = 0; i < p_major.size(); ++i) {
+        uint32_t l_dst = l_pos[p_major[i]]++;
+        p_idx[l_dst] = p_minor[i];
+        p_val[l_dst] = p_data[i];
+    }
+}
+
 int main(int argc, char** argv) {
     TimePointType l_timer[2];
     int arg = 0;
     string dataPath = argv[++arg];
     int l_runs = atoi(argv[++arg]);
     int l_update = atoi(argv[++arg]);
+    // optional memory budget in MB, partition out-of-core when it is given
+    size_t l_memBudgetMB = 0;
+    if (argc > arg + 1) {
+        l_memBudgetMB = atoi(argv[++arg]);
+    }
     string l_dataPath = dataPath + "/"; 
     xf::sparse::CooMatInfo l_matInfo = xf::sparse::loadMatInfo(l_dataPath);
     std::vector<uint32_t> l_rowIdx(l_matInfo.m_nnz);
@@ -40,7 +82,12 @@ int main(int argc, char** argv) {
       
         l_timer[0] = chrono::high_resolution_clock::now();
         xf::sparse::MatPartition l_matPar;
-         if ((i == 0) || (l_update == 0)) {
+        if (l_memBudgetMB != 0) {
+            l_matPar = l_spmPar.partitionCooMatToFiles(l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_rowIdx.data(),
+                                                       l_colIdx.data(), l_data.data(), 0, l_dataPath,
+                                                       l_memBudgetMB * 1024 * 1024);
+        }
+        else if ((i == 0) || (l_update == 0)) {
             l_matPar = l_spmPar.partitionCooMat(l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_rowIdx.data(),
                                                          l_colIdx.data(), l_data.data(), 0); //partition sparse matrix with C storage type
         }
@@ -48,11 +95,129 @@ int main(int argc, char** argv) {
             l_matPar = l_spmPar.updateMat(l_data.data());
         }
         showTimeData("INFO: Matrix partition time: ", l_timer[0], l_timer[1]);
-        storeMatPar(l_dataPath, l_matPar);
+        if (l_memBudgetMB == 0) {
+            storeMatPar(l_dataPath, l_matPar);
+            xf::sparse::storeMatParFile(l_dataPath + "sig.bin", l_matPar);
+            MappedBinFile l_sigFile(l_dataPath + "sig.bin");
+            xf::sparse::MatPartition l_loadedPar =
+                xf::sparse::loadMatParFile(l_sigFile, SPARSE_parEntries, SPARSE_accLatency, SPARSE_hbmChannels,
+                                           SPARSE_maxRows, SPARSE_maxCols, SPARSE_hbmMemBits);
+            if (!isSamePartition(l_loadedPar, l_matPar)) {
+                printf("ERROR: matrix %s partition loaded from sig.bin differs.\n", l_matInfo.m_name.c_str());
+                return EXIT_FAILURE;
+            }
+            // the software kernel model must compute A * x from the partition
+            vector<SPARSE_dataType> l_x(l_matInfo.m_n), l_y(l_matInfo.m_m), l_yRef(l_matInfo.m_m, 0);
+            for (uint32_t j = 0; j < l_matInfo.m_n; ++j) {
+                l_x[j] = 1.0 + (j % 17) * 0.125;
+            }
+            for (uint32_t j = 0; j < l_matInfo.m_nnz; ++j) {
+                l_yRef[l_rowIdx[j]] += l_data[j] * l_x[l_colIdx[j]];
+            }
+            xf::sparse::SpmvModel<SPARSE_dataType> l_model(l_loadedPar);
+            l_model.run(l_x.data(), l_y.data());
+            for (uint32_t j = 0; j < l_matInfo.m_m; ++j) {
+                if (fabs(l_y[j] - l_yRef[j]) > 1e-10 * max(fabs(l_yRef[j]), 1.0)) {
+                    printf("ERROR: matrix %s spmv model result differs at row %d.\n", l_matInfo.m_name.c_str(), j);
+                    return EXIT_FAILURE;
+                }
+            }
+        }
+        if ((l_memBudgetMB == 0) && (i == 0)) {
+            // the CSR and CSC inputs must give the same partition as the COO input
+            vector<uint32_t> l_ptr, l_idx;
+            vector<SPARSE_dataType> l_val;
+            xf::sparse::SpmPar<SPARSE_dataType> l_csrPar(SPARSE_parEntries, SPARSE_accLatency, SPARSE_hbmChannels,
+                                                         SPARSE_maxRows, SPARSE_maxCols, SPARSE_hbmMemBits);
+            compressCoo(l_matInfo.m_m, l_rowIdx, l_colIdx, l_data, l_ptr, l_idx, l_val);
+            xf::sparse::MatPartition l_csrMatPar = l_csrPar.partitionCsrMat(
+                l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_ptr.data(), l_idx.data(), l_val.data(), 0);
+            if (!isSamePartition(l_csrMatPar, l_matPar)) {
+                printf("ERROR: matrix %s partition from CSR input differs.\n", l_matInfo.m_name.c_str());
+                return EXIT_FAILURE;
+            }
+            xf::sparse::SpmPar<SPARSE_dataType> l_cscPar(SPARSE_parEntries, SPARSE_accLatency, SPARSE_hbmChannels,
+                                                         SPARSE_maxRows, SPARSE_maxCols, SPARSE_hbmMemBits);
+            compressCoo(l_matInfo.m_n, l_colIdx, l_rowIdx, l_data, l_ptr, l_idx, l_val);
+            xf::sparse::MatPartition l_cscMatPar = l_cscPar.partitionCscMat(
+                l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_idx.data(), l_ptr.data(), l_val.data(), 0);
+            if (!isSamePartition(l_cscMatPar, l_matPar)) {
+                printf("ERROR: matrix %s partition from CSC input differs.\n", l_matInfo.m_name.c_str());
+                return EXIT_FAILURE;
+            }
+            // a reordered partition must be the partition of the matrix with renumbered cols
+            xf::sparse::SpmPar<SPARSE_dataType> l_reorderPar(SPARSE_parEntries, SPARSE_accLatency, SPARSE_hbmChannels,
+                                                             SPARSE_maxRows, SPARSE_maxCols, SPARSE_hbmMemBits);
+            l_reorderPar.setReorder(xf::sparse::REORDER_PAD);
+            xf::sparse::MatPartition l_reorderMatPar = l_reorderPar.partitionCooMat(
+                l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(), l_data.data(), 0);
+            const vector<uint32_t>& l_colPerm = l_reorderPar.getColPerm();
+            vector<uint32_t> l_permColIdx(l_colIdx);
+            for (uint32_t j = 0; (j < l_permColIdx.size()) && !l_colPerm.empty(); ++j) {
+                l_permColIdx[j] = l_colPerm[l_colIdx[j]];
+            }
+            xf::sparse::SpmPar<SPARSE_dataType> l_permPar(SPARSE_parEntries, SPARSE_accLatency, SPARSE_hbmChannels,
+                                                          SPARSE_maxRows, SPARSE_maxCols, SPARSE_hbmMemBits);
+            xf::sparse::MatPartition l_permMatPar = l_permPar.partitionCooMat(
+                l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_rowIdx.data(), l_permColIdx.data(), l_data.data(), 0);
+            if (!isSamePartition(l_reorderMatPar, l_permMatPar) || (l_reorderMatPar.m_nnzPad > l_matPar.m_nnzPad * 1.01)) {
+                printf("ERROR: matrix %s reordered partition is wrong.\n", l_matInfo.m_name.c_str());
+                return EXIT_FAILURE;
+            }
+            printf("INFO: reordering changes padded nnzs from %llu to %llu\n", (unsigned long long)l_matPar.m_nnzPad,
+                   (unsigned long long)l_reorderMatPar.m_nnzPad);
+            // switching the reordering off again must give the plain partition without the old perms
+            l_reorderPar.setReorder(xf::sparse::REORDER_NONE);
+            l_reorderMatPar = l_reorderPar.partitionCooMat(l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz,
+                                                           l_rowIdx.data(), l_colIdx.data(), l_data.data(), 0);
+            if (!isSamePartition(l_reorderMatPar, l_matPar) || !l_reorderPar.getColPerm().empty() ||
+                (l_reorderPar.getNnzPadEst(0) != 0)) {
+                printf("ERROR: matrix %s partition after turning off reordering is wrong.\n", l_matInfo.m_name.c_str());
+                return EXIT_FAILURE;
+            }
+            if (l_matInfo.m_m == l_matInfo.m_n) {
+                // an RCM partition must be the partition of the matrix with renumbered rows and cols
+                xf::sparse::SpmPar<SPARSE_dataType> l_rcmPar(SPARSE_parEntries, SPARSE_accLatency, SPARSE_hbmChannels,
+                                                             SPARSE_maxRows, SPARSE_maxCols, SPARSE_hbmMemBits);
+                l_rcmPar.setReorder(xf::sparse::REORDER_RCM);
+                xf::sparse::MatPartition l_rcmMatPar = l_rcmPar.partitionCooMat(
+                    l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(), l_data.data(), 0);
+                const vector<uint32_t>& l_perm = l_rcmPar.getRowPerm();
+                vector<uint32_t> l_permRowIdx(l_rowIdx);
+                for (uint32_t j = 0; j < l_permRowIdx.size(); ++j) {
+                    l_permRowIdx[j] = l_perm[l_rowIdx[j]];
+                    l_permColIdx[j] = l_perm[l_colIdx[j]];
+                }
+                xf::sparse::SpmPar<SPARSE_dataType> l_symPermPar(SPARSE_parEntries, SPARSE_accLatency,
+                                                                 SPARSE_hbmChannels, SPARSE_maxRows, SPARSE_maxCols,
+                                                                 SPARSE_hbmMemBits);
+                xf::sparse::MatPartition l_symPermMatPar =
+                    l_symPermPar.partitionCooMat(l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_permRowIdx.data(),
+                                                 l_permColIdx.data(), l_data.data(), 0);
+                if ((l_rcmPar.getColPerm() != l_perm) || !isSamePartition(l_rcmMatPar, l_symPermMatPar)) {
+                    printf("ERROR: matrix %s RCM reordered partition is wrong.\n", l_matInfo.m_name.c_str());
+                    return EXIT_FAILURE;
+                }
+                l_rcmPar.setReorder(xf::sparse::REORDER_NONE);
+                l_rcmMatPar = l_rcmPar.partitionCooMat(l_matInfo.m_m, l_matInfo.m_n, l_matInfo.m_nnz, l_rowIdx.data(),
+                                                       l_colIdx.data(), l_data.data(), 0);
+                if (!isSamePartition(l_rcmMatPar, l_matPar) || !l_rcmPar.getRowPerm().empty() ||
+                    !l_rcmPar.getColPerm().empty()) {
+                    printf("ERROR: matrix %s partition after turning off RCM is wrong.\n", l_matInfo.m_name.c_str());
+                    return EXIT_FAILURE;
+                }
+                printf("INFO: RCM reordering changes partitions per row block from %f to %f\n",
+                       (double)l_spmPar.getTotalPars() / l_spmPar.getTotalRbs(),
+                       (double)l_rcmPar.getTotalPars() / l_rcmPar.getTotalRbs());
+            }
+        }
         printf("INFO: matrix %s partiton done.\n", l_matInfo.m_name.c_str());
-        printf("      Original m, n, nnzs = %d, %d, %d\n", l_matPar.m_m, l_matPar.m_n, l_matPar.m_nnz);
-        printf("      After padding m, n, nnzs = %d, %d, %d\n", l_matPar.m_mPad, l_matPar.m_nPad, l_matPar.m_nnzPad);
+        printf("      Original m, n, nnzs = %d, %d, %llu\n", l_matPar.m_m, l_matPar.m_n,
+               (unsigned long long)l_matPar.m_nnz);
+        printf("      After padding m, n, nnzs = %d, %d, %llu\n", l_matPar.m_mPad, l_matPar.m_nPad,
+               (unsigned long long)l_matPar.m_nnzPad);
         printf("      Padding overhead is %f\n", (double)(l_matPar.m_nnzPad - l_matPar.m_nnz) / l_matPar.m_nnz);
+        printf("      Channel imbalance (max/average blocks) is %f\n", l_spmPar.getChImbalance());
     }
     return EXIT_SUCCESS;
 }
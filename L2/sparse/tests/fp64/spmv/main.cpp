@@ -69,8 +69,10 @@ template <typename T>
 using host_buffer_t = std::vector<T, aligned_allocator<T> >;
 
 int main(int argc, char** argv) {
-    if (argc < 5 || argc > 6) {
-        std::cout << "Usage: " << argv[0] << " <XCLBIN File> <sigature_path> <vector_path> <mtx_name> [device id]" << std::endl;
+    if (argc < 5 || argc > 7) {
+        std::cout << "Usage: " << argv[0]
+                  << " <XCLBIN File> <sigature_path> <vector_path> <mtx_name> [device id] [num of batched vectors]"
+                  << std::endl;
         return EXIT_FAILURE;
     }
 
@@ -96,42 +98,41 @@ int main(int argc, char** argv) {
     l_vecFileNames[1] = l_vecFilePath + "/refVec.dat";
     l_vecFileNames[2] = l_vecFilePath + "/outVec.dat";
 
-    // I/O Data Vectors
-    host_buffer_t<uint8_t> l_nnzBuf[SPARSE_hbmChannels];
+    // I/O Data Vectors, signature files are mapped instead of being copied into host buffers
+    MappedBinFile l_sigFiles[SPARSE_hbmChannels + 2];
     void* l_nnzBufPtr[SPARSE_hbmChannels];
     size_t l_nnzBufBytes[SPARSE_hbmChannels];
-    host_buffer_t<uint8_t> l_parXbuf[2];
+    host_buffer_t<uint8_t> l_xBuf;
     void* l_parXbufPtr[2];
     size_t l_parXbufBytes[2];
-    host_buffer_t<uint8_t> l_rbParamBuf;
+    void* l_rbParamBufPtr;
     size_t l_rbParamBufBytes;
     host_buffer_t<uint8_t> l_yBuf;
     size_t l_yBufBytes;
     host_buffer_t<uint8_t> l_refBuf;
 
     for (unsigned int i = 0; i < SPARSE_hbmChannels + 2; ++i) {
-        size_t l_bytes = getBinBytes(l_sigFileNames[i]);
+        if (!l_sigFiles[i].open(l_sigFileNames[i])) {
+            return EXIT_FAILURE;
+        }
+        size_t l_bytes = l_sigFiles[i].size();
         if (i < SPARSE_hbmChannels) {
-            readBin<uint8_t, aligned_allocator<uint8_t> >(l_sigFileNames[i], l_bytes, l_nnzBuf[i]);
-            l_nnzBufPtr[i] = l_nnzBuf[i].data();
+            l_nnzBufPtr[i] = l_sigFiles[i].data();
             l_nnzBufBytes[i] = l_bytes;
         } else if (i == SPARSE_hbmChannels) {
-            readBin<uint8_t, aligned_allocator<uint8_t> >(l_sigFileNames[i], l_bytes,
-                                                          l_parXbuf[0]);
-            l_parXbufPtr[0] = l_parXbuf[0].data();
+            l_parXbufPtr[0] = l_sigFiles[i].data();
             l_parXbufBytes[0] = l_bytes;
         }
         else {
-            readBin<uint8_t, aligned_allocator<uint8_t> >(l_sigFileNames[i], l_bytes,
-                                                                l_rbParamBuf);
+            l_rbParamBufPtr = l_sigFiles[i].data();
             l_rbParamBufBytes = l_bytes;
         }
     }
     for (unsigned int i = 0; i < 2; ++i) {
         size_t l_bytes = getBinBytes(l_vecFileNames[i]);
         if (i == 0) {
-            readBin<uint8_t, aligned_allocator<uint8_t> >(l_vecFileNames[i], l_bytes, l_parXbuf[1]);
-            l_parXbufPtr[1] = l_parXbuf[1].data();
+            readBin<uint8_t, aligned_allocator<uint8_t> >(l_vecFileNames[i], l_bytes, l_xBuf);
+            l_parXbufPtr[1] = l_xBuf.data();
             l_parXbufBytes[1] = l_bytes;
         }
         else {
@@ -144,6 +145,8 @@ int main(int argc, char** argv) {
 
     int l_deviceId = 0;
     if (argc > l_idx) l_deviceId = atoi(argv[l_idx++]);
+    unsigned int l_numVecs = 8;
+    if (argc > l_idx) l_numVecs = atoi(argv[l_idx++]);
 
     std::vector<uint32_t> l_info(6);
     readBin<uint32_t>(l_sigFilePath + "/info.dat", 6 * sizeof(uint32_t), l_info.data());
@@ -161,31 +164,95 @@ int main(int argc, char** argv) {
     l_card.load_xclbin(l_xclbinFile);
     std::cout << "INFO: loading xclbin successfully!" << std::endl;
 
-    xilinx_apps::sparse::SpmvHost<SPARSE_hbmChannels> l_spmvHost;
+    xilinx_apps::sparse::SpmvHost<SPARSE_hbmChannels, SPARSE_hbmMemBits> l_spmvHost;
     l_spmvHost.init(&l_card);
     l_spmvHost.createKernels();
 
-    l_spmvHost.createLoadNnzBufs(l_nnzBufBytes, l_nnzBufPtr);
-    l_spmvHost.createLoadParXbufs(l_parXbufBytes, l_parXbufPtr);
-    l_spmvHost.createLoadRbParamBufs(l_rbParamBufBytes, l_rbParamBuf.data());
+    try {
+        l_spmvHost.createLoadNnzBufs(l_nnzBufBytes, l_nnzBufPtr);
+        l_spmvHost.createLoadParXbufs(l_parXbufBytes, l_parXbufPtr);
+    } catch (const xf::sparse::SpmException& l_err) {
+        std::cout << "ERROR: " << l_err.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+    l_spmvHost.createLoadRbParamBufs(l_rbParamBufBytes, l_rbParamBufPtr);
     l_spmvHost.createStoreYbufs(l_yBufBytes, l_yBuf.data());
     l_spmvHost.setStoreYrows(l_yRows);
     l_spmvHost.sendBOs();
+    TimePointType l_timer[2];
+    double l_singleMs = 0, l_batchMs = 0;
+    l_timer[0] = std::chrono::high_resolution_clock::now();
     l_spmvHost.run();
     l_spmvHost.getY();
     l_spmvHost.finish();
+    showTimeData("INFO: single vector run time: ", l_timer[0], l_timer[1], &l_singleMs);
 
     writeBin<uint8_t>(l_vecFileNames[2], l_yRows * sizeof(SPARSE_dataType),
                       reinterpret_cast<uint8_t*>(&(l_yBuf[0])));
     int l_errs = 0;
     compare<SPARSE_dataType>(l_yRows, reinterpret_cast<SPARSE_dataType*>(l_yBuf.data()),
                              reinterpret_cast<SPARSE_dataType*>(l_refBuf.data()), l_errs, true);
+
+    // batched run over the resident signature, vector i is x scaled by 2^(i%4) so that y scales exactly
+    std::vector<std::vector<SPARSE_dataType> > l_xs(l_numVecs), l_ys(l_numVecs);
+    std::vector<const void*> l_xPtrs(l_numVecs);
+    std::vector<void*> l_yPtrs(l_numVecs);
+    const SPARSE_dataType* l_x = reinterpret_cast<const SPARSE_dataType*>(l_xBuf.data());
+    for (unsigned int i = 0; i < l_numVecs; ++i) {
+        l_xs[i].resize(l_parXbufBytes[1] / sizeof(SPARSE_dataType));
+        for (unsigned int j = 0; j < l_xs[i].size(); ++j) {
+            l_xs[i][j] = l_x[j] * (1 << (i % 4));
+        }
+        l_ys[i].resize(l_yRows);
+        l_xPtrs[i] = l_xs[i].data();
+        l_yPtrs[i] = l_ys[i].data();
+    }
+    if (l_numVecs > 0) {
+        l_spmvHost.createBatchBufs(l_parXbufBytes[1], l_yBufBytes);
+        l_timer[0] = std::chrono::high_resolution_clock::now();
+        l_spmvHost.runBatch(l_numVecs, l_xPtrs.data(), l_yPtrs.data());
+        showTimeData("INFO: batched run time: ", l_timer[0], l_timer[1], &l_batchMs);
+        std::cout << "INFO: per vector time [ms], single run " << l_singleMs << ", batch of " << l_numVecs << " "
+                  << l_batchMs / l_numVecs << std::endl;
+    }
+    // streamed run, the same vectors queued one by one, the results are checked together with the batched ones
+    std::vector<std::vector<SPARSE_dataType> > l_asyncYs(l_numVecs, std::vector<SPARSE_dataType>(l_yRows));
+    if (l_numVecs > 0) {
+        double l_asyncMs = 0;
+        std::vector<std::future<void> > l_done;
+        unsigned int l_callbacks = 0;
+        l_spmvHost.startAsync();
+        l_timer[0] = std::chrono::high_resolution_clock::now();
+        for (unsigned int i = 0; i < l_numVecs; ++i) {
+            l_done.push_back(l_spmvHost.runAsync(l_xPtrs[i], l_asyncYs[i].data(), [&] { ++l_callbacks; }));
+        }
+        for (unsigned int i = 0; i < l_numVecs; ++i) {
+            l_done[i].get();
+        }
+        showTimeData("INFO: streamed run time: ", l_timer[0], l_timer[1], &l_asyncMs);
+        l_spmvHost.stopAsync();
+        std::cout << "INFO: per vector time [ms], streamed " << l_asyncMs / l_numVecs << std::endl;
+        if (l_callbacks != l_numVecs) {
+            std::cout << "ERROR: " << l_callbacks << " completion callbacks for " << l_numVecs << " vectors."
+                      << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::vector<SPARSE_dataType> l_ref(l_yRows);
+    for (unsigned int i = 0; i < l_numVecs; ++i) {
+        const SPARSE_dataType* l_y = reinterpret_cast<const SPARSE_dataType*>(l_refBuf.data());
+        for (unsigned int j = 0; j < l_yRows; ++j) {
+            l_ref[j] = l_y[j] * (1 << (i % 4));
+        }
+        compare<SPARSE_dataType>(l_yRows, l_ys[i].data(), l_ref.data(), l_errs, false);
+        compare<SPARSE_dataType>(l_yRows, l_asyncYs[i].data(), l_ref.data(), l_errs, false);
+    }
     if (l_errs == 0) {
         std::cout << "INFO: Test pass!" << std::endl;
         return EXIT_SUCCESS;
     } else {
-        std::cout << "ERROR: Test failed! Out of total " << l_yRows << " entries, there are " << l_errs << " mismatches."
-             << std::endl;
+        std::cout << "ERROR: Test failed! Out of total " << l_yRows * (2 * l_numVecs + 1) << " entries, there are "
+                  << l_errs << " mismatches." << std::endl;
         return EXIT_FAILURE;
     }
 }
@@ -36,7 +36,7 @@ import math
 from matrix_params import *
 from signature import *
 
-def partition_matrix(mtxName, mtxFullName, maxRows, maxCols, channels, parEntries, accLatency, memBits, mtxSigPath):
+def partition_matrix(mtxName, mtxFullName, maxRows, maxCols, channels, parEntries, accLatency, memBits, mtxSigPath, valType=VAL_FP64):
     l_nnzFileNames = []
     for i in range(channels):
         l_nnzFileNames.append(mtxSigPath+'/nnzVal_' + str(i) + '.dat')
@@ -45,29 +45,34 @@ def partition_matrix(mtxName, mtxFullName, maxRows, maxCols, channels, parEntrie
     l_rbParamFileName = mtxSigPath+'/rbParam.dat'
     l_infoFileName = mtxSigPath+'/info.dat'
     l_sig = signature(parEntries, accLatency, channels, maxRows, maxCols, memBits)
+    l_sig.set_valType(valType)
     l_sig.process(mtxFullName, mtxName)
     l_sig.store_rbParam(l_rbParamFileName)
     l_sig.store_parParam(l_parParamFileName)
     l_sig.store_nnz(l_nnzFileNames)
     l_sig.store_info(l_infoFileName)
+    l_sig.store_file(mtxSigPath+'/sig.bin')
+
+def load_signature(p_sig, mtxSigPath):
+    l_sigFileName = mtxSigPath+'/sig.bin'
+    if os.path.exists(l_sigFileName):
+        p_sig.load_file(l_sigFileName)
+        return
+    l_nnzFileNames = []
+    for i in range(p_sig.channels):
+        l_nnzFileNames.append(mtxSigPath+'/nnzVal_' + str(i) + '.dat')
+    p_sig.load_rbParam(mtxSigPath+'/rbParam.dat')
+    p_sig.load_parParam(mtxSigPath+'/parParam.dat')
+    p_sig.load_nnz(l_nnzFileNames)
+    p_sig.load_info(mtxSigPath+'/info.dat')
     
 def check_signature(mtxName, maxRows, maxCols, channels, parEntries, accLatency, memBits, mtxSigPath):
     l_pass = True
     for l_dir in os.listdir(mtxSigPath):
         l_mtxSigPath = os.path.join(mtxSigPath, l_dir)
         if os.path.isdir(l_mtxSigPath):
-            l_nnzFileNames = []
-            for i in range(channels):
-                l_nnzFileNames.append(l_mtxSigPath+'/nnzVal_' + str(i) + '.dat')
-
-            l_parParamFileName = l_mtxSigPath+'/parParam.dat'
-            l_rbParamFileName = l_mtxSigPath+'/rbParam.dat'
-            l_infoFileName = l_mtxSigPath+'/info.dat'
             l_sig = signature(parEntries, accLatency, channels, maxRows, maxCols, memBits)
-            l_sig.load_rbParam(l_rbParamFileName)
-            l_sig.load_parParam(l_parParamFileName)
-            l_sig.load_nnz(l_nnzFileNames)
-            l_sig.load_info(l_infoFileName)
+            load_signature(l_sig, l_mtxSigPath)
             if l_sig.check(l_mtxSigPath):
                 print("INFO: {} signature in {} verification pass!".format(mtxName, l_mtxSigPath))
             else:
@@ -75,7 +80,7 @@ def check_signature(mtxName, maxRows, maxCols, channels, parEntries, accLatency,
                 l_pass = False
     return l_pass
     
-def process_matrices(isPartition, isClean, isCheck, mtxList, maxRows, maxCols, channels, parEntries, accLatency, memBits, sigPath):
+def process_matrices(isPartition, isClean, isCheck, mtxList, maxRows, maxCols, channels, parEntries, accLatency, memBits, sigPath, valType=VAL_FP64):
     download_list = open(mtxList, 'r')
     download_names = download_list.readlines()
     if not os.path.exists(sigPath):
@@ -97,7 +102,7 @@ def process_matrices(isPartition, isClean, isCheck, mtxList, maxRows, maxCols, c
             subprocess.run(["wget", mtxHttp, "-P", "./mtx_files"])
             subprocess.run(["tar", "-xzf", './mtx_files/'+mtxFileName, "-C", "./mtx_files"])
         if isPartition:
-            partition_matrix(mtxName, mtxFullName, maxRows, maxCols, channels, parEntries, accLatency, memBits, mtxSigPath)
+            partition_matrix(mtxName, mtxFullName, maxRows, maxCols, channels, parEntries, accLatency, memBits, mtxSigPath, valType)
         if isCheck:
             l_equal = l_equal and check_signature(mtxName, maxRows, maxCols, channels, parEntries, accLatency, memBits, mtxSigPath)
         if isClean:
@@ -112,37 +117,32 @@ def decode_mtx_sig(mtxSigPath, maxRows, maxCols, channels, parEntries, accLatenc
         print("ERROR: {} directory doesn't exist.".format(mtxPath))
         return
     subprocess.run(["mkdir", "-p", txtPath])
-    l_nnzFileNames, l_nnzTxtFileNames = [],[]
+    l_nnzTxtFileNames = []
     for i in range(channels):
-        l_nnzFileNames.append(mtxSigPath+'/nnzVal_' + str(i) + '.dat')
         l_nnzTxtFileNames.append(txtPath+'/nnzVal_' + str(i) + '.txt')
 
-    l_parParamFileName = mtxSigPath+'/parParam.dat'
     l_parParamTxtFileName = txtPath+'/parParam.txt'
-    l_rbParamFileName = mtxSigPath+'/rbParam.dat'
     l_rbParamTxtFileName = txtPath+'/rbParam.txt'
-    l_infoFileName = mtxSigPath+'/info.dat'
     l_infoTxtFileName = txtPath+'/info.txt'
     l_sig = signature(parEntries, accLatency, channels, maxRows, maxCols, memBits)
-    l_sig.load_rbParam(l_rbParamFileName)
+    load_signature(l_sig, mtxSigPath)
     l_sig.print_rbParam(l_rbParamTxtFileName)
-    l_sig.load_parParam(l_parParamFileName)
     l_sig.print_parParam(l_parParamTxtFileName)
-    l_sig.load_nnz(l_nnzFileNames)
     l_sig.print_nnz(l_nnzTxtFileNames)
-    l_sig.load_info(l_infoFileName)
     l_sig.print_info(l_infoTxtFileName)
 
 def main(args):
     if (args.usage):
         print('Usage example:')
         print('python gen_signature.py --partition [--clean] --mtx_list ./test_matrices.txt --sig_path ./sig_dat --runs num_of_runs')
+        print('python gen_signature.py --partition --val_type fp32 --mtx_list ./test_matrices.txt --sig_path ./sig_dat')
         print('python gen_signature.py --check --mtx_list ./test_matrices.txt --sig_path ./sig_dat')
         print('python gen_signature.py --decode --mtx_path ./sig_dat/mtx_name  --txt_path ./txt_out/mtx_name')
     elif (args.decode):
         decode_mtx_sig(args.mtx_path, args.max_rows, args.max_cols, args.channels, args.par_entries,args.acc_latency, args.mem_bits, args.txt_path)
     else:
-        process_matrices(args.partition, args.clean, args.check, args.mtx_list, args.max_rows, args.max_cols, args.channels, args.par_entries, args.acc_latency, args.mem_bits, args.sig_path)
+        l_valType = {'fp64': VAL_FP64, 'fp32': VAL_FP32, 'bf16': VAL_BF16}[args.val_type]
+        process_matrices(args.partition, args.clean, args.check, args.mtx_list, args.max_rows, args.max_cols, args.channels, args.par_entries, args.acc_latency, args.mem_bits, args.sig_path, l_valType)
 
 if __name__ == '__main__':
     parser = argparse.ArgumentParser(description='partition sparse matrix, verify partitions and decode partiton info')
@@ -157,6 +157,7 @@ if __name__ == '__main__':
     parser.add_argument('--par_entries',type=int,default=4,help='number of NNZ entries retrieved from one HBM channel')
     parser.add_argument('--acc_latency',type=int,default=8,help='number of cycles used for double precision accumulation')
     parser.add_argument('--mem_bits',type=int,default=256,help='number of bits in each HBM channel access')
+    parser.add_argument('--val_type',type=str,default='fp64',choices=['fp64','fp32','bf16'],help='storage type of the NNZ values, accumulation stays in double precision, default value fp64; the spmv kernels only read fp64, other types are for --check and --decode')
     parser.add_argument('--sig_path',type=str,default='./sig_dat',help='directory for storing partition results, default value ./sig_dat')
     parser.add_argument('--runs',type=int,default='1',help='number of partition runs for each matrix, each partittion run uses different data set, default value 1')
     parser.add_argument('--decode',action='store_true',help='print signature files into text files')
@@ -31,6 +31,43 @@ import scipy.io as sio
 import scipy.sparse as sp
 import math
 
+# value types of the nnz blocks, see SpmValType in include/sw/fp64/matrix_params.hpp
+VAL_FP64, VAL_FP32, VAL_BF16 = 0, 1, 2
+
+def val_bytes(p_valType):
+    return {VAL_FP64: 8, VAL_FP32: 4, VAL_BF16: 2}[p_valType]
+
+def encode_vals(p_valType, p_vals):
+    l_vals = np.asarray(p_vals, dtype=np.float64)
+    if p_valType == VAL_FP64:
+        return l_vals.tobytes()
+    l_fp32 = l_vals.astype(np.float32)
+    if p_valType == VAL_FP32:
+        return l_fp32.tobytes()
+    # bf16 is the upper half of an fp32, rounded to nearest even, NaNs are kept quiet
+    l_bits = l_fp32.view(np.uint32).astype(np.uint64)
+    l_nan = (l_bits & 0x7fffffff) > 0x7f800000
+    l_bits = np.where(l_nan, l_bits | 0x00400000, l_bits + 0x7fff + ((l_bits >> 16) & 1))
+    return ((l_bits >> 16) & 0xffff).astype(np.uint16).tobytes()
+
+# p_count indices of the index block at p_offset, p_deltaBits == 0 for plain 16-bit indices, otherwise signed deltas
+# packed LSB first and accumulated from p_prevIdx; see decodeIdx in L1/sparse/include/hw/xf_sparse/fp64/dataMovers.hpp
+def decode_idx(p_buf, p_offset, p_count, p_deltaBits, p_prevIdx):
+    if p_deltaBits == 0:
+        return np.frombuffer(p_buf, dtype=np.uint16, count=p_count, offset=p_offset).astype(np.int64)
+    l_bits = np.unpackbits(np.frombuffer(p_buf, dtype=np.uint8, count=p_count*p_deltaBits//8, offset=p_offset), bitorder='little')
+    l_fields = l_bits.reshape(p_count, p_deltaBits).astype(np.int64).dot(1 << np.arange(p_deltaBits))
+    l_deltas = np.where(l_fields >= (1 << (p_deltaBits-1)), l_fields - (1 << p_deltaBits), l_fields)
+    return p_prevIdx + np.cumsum(l_deltas)
+
+def decode_vals(p_valType, p_buf, p_count, p_offset):
+    if p_valType == VAL_FP64:
+        return np.frombuffer(p_buf, dtype=np.float64, count=p_count, offset=p_offset)
+    if p_valType == VAL_FP32:
+        return np.frombuffer(p_buf, dtype=np.float32, count=p_count, offset=p_offset).astype(np.float64)
+    l_bits = np.frombuffer(p_buf, dtype=np.uint16, count=p_count, offset=p_offset).astype(np.uint32) << 16
+    return l_bits.view(np.float32).astype(np.float64)
+
 class row_block_param:
     def __init__(self, memBits, channels):
         self.channels = channels
@@ -124,21 +161,27 @@ class row_block_param:
         l_offset += self.memBytes * 4
         self.buf[l_offset:l_offset+self.channels*4] = chInfo32Arr.tobytes()
 
-    def write_file(self, fileName):
-        fo = open(fileName, "wb")
+    def update_header(self):
         int32Arr = np.zeros(self.memBytes//4, dtype=np.uint32)
         int32Arr[0] = self.totalRows
         int32Arr[1] = self.totalRbs
         self.buf[:self.memBytes] = int32Arr.tobytes()
+
+    def set_buf(self, p_buf):
+        self.buf = p_buf
+        int32Arr = np.frombuffer(self.buf, dtype=np.uint32, count=self.memBytes // 4, offset=0)
+        self.totalRows = int32Arr[0]
+        self.totalRbs = int32Arr[1]
+
+    def write_file(self, fileName):
+        fo = open(fileName, "wb")
+        self.update_header()
         fo.write(self.buf)
         fo.close()
 
     def read_file(self, fileName):
         fi = open(fileName, "rb")
-        self.buf = fi.read()
-        int32Arr = np.frombuffer(self.buf, dtype=np.uint32, count=self.memBytes // 4, offset=0)
-        self.totalRows = int32Arr[0]
-        self.totalRbs = int32Arr[1]
+        self.set_buf(fi.read())
         fi.close()
 
     def print_file(self, fileName):
@@ -234,19 +277,25 @@ class par_param:
         self.buf[l_offset: l_offset+self.memBytes] = sef.int32Arr.tobytes()
 
 
-    def write_file(self, filename):
+    def update_header(self):
         int32Arr = np.zeros(self.memBytes//4, dtype=np.uint32)
         int32Arr[0] = self.totalPars
         self.buf[:self.memBytes] = int32Arr.tobytes()
+
+    def set_buf(self, p_buf):
+        self.buf = p_buf
+        int32Arr = np.frombuffer(self.buf, dtype=np.uint32, count=self.memBytes//4, offset=0)
+        self.totalPars = int32Arr[0]
+
+    def write_file(self, filename):
+        self.update_header()
         fo = open(filename, "wb")
         fo.write(self.buf)
         fo.close() 
 
     def read_file(self, filename):
         fi = open(filename, "rb")
-        self.buf = fi.read()
-        int32Arr = np.frombuffer(self.buf, dtype=np.uint32, count=self.memBytes//4, offset=0)
-        self.totalPars = int32Arr[0]
+        self.set_buf(fi.read())
         fi.close()
 
     def print_file(self, filename):
@@ -277,6 +326,7 @@ class nnz_store:
         self.totalRowIdxBks = [0]*channels
         self.totalColIdxBks = [0]*channels
         self.totalNnzBks = [0]*channels
+        self.valType = VAL_FP64
         self.buf = [] 
         for i in range(channels):
             self.buf.append(bytearray())
@@ -291,56 +341,83 @@ class nnz_store:
             int16Arr[i] = p_idxArr[i]
         self.buf[p_chId].extend(int16Arr.tobytes())
 
-    def add_nnzArr(self, p_chId,  p_nnzArr):
-        float64Arr = np.zeros(self.memBytes//8, dtype=np.float64)
-        for i in range(self.memBytes // 8):
-            float64Arr[i] = p_nnzArr[i]
-        self.buf[p_chId].extend(float64Arr.tobytes())
-
-    def get_chPar(self, p_chId, p_offset, p_nnzIdx, p_nnzs, p_sRowId, p_sColId):
-        l_memIdxWidth = self.memBytes//2
+    def set_valType(self, p_valType):
+        l_groupBytes = self.parEntries * val_bytes(p_valType)
+        assert self.memBytes % l_groupBytes == 0, "value type doesn't fit the memory block"
+        assert (self.memBytes//2) % (self.memBytes//l_groupBytes) == 0, "value type doesn't fit the memory block"
+        self.valType = p_valType
+
+    # groups of parEntries values held by one value block
+    def get_valGroups(self):
+        return self.memBytes // (self.parEntries * val_bytes(self.valType))
+
+    # p_nnzArr holds the values of group p_groupId of a channel partition, a new block is started for its first group
+    def add_nnzArr(self, p_chId,  p_nnzArr, p_groupId=0):
+        if p_groupId % self.get_valGroups() == 0:
+            self.buf[p_chId].extend(bytes(self.memBytes))
+        l_offset = len(self.buf[p_chId]) - self.memBytes + (p_groupId % self.get_valGroups())*self.parEntries*val_bytes(self.valType)
+        self.buf[p_chId][l_offset:l_offset+self.parEntries*val_bytes(self.valType)] = encode_vals(self.valType, p_nnzArr[0:self.parEntries])
+
+    # p_rowBits and p_colBits are the index widths of the channel partition, see par_param.get_chInfo16(parId, 2)
+    def get_chPar(self, p_chId, p_offset, p_nnzIdx, p_nnzs, p_sRowId, p_sColId, p_rowBits=0, p_colBits=0):
         l_rowIdxGap = self.parEntries * self.accLatency
-        l_rowIdxMod = l_memIdxWidth * l_rowIdxGap
-        l_colIdxMod = l_memIdxWidth * self.parEntries
+        l_rowIdxWidth = self.memBytes*8 // (p_rowBits if p_rowBits else 16)
+        l_colIdxWidth = self.memBytes*8 // (p_colBits if p_colBits else 16)
+        l_rowIdxMod = l_rowIdxWidth * l_rowIdxGap
+        l_colIdxMod = l_colIdxWidth * self.parEntries
+        l_valGroups = self.get_valGroups()
         l_row,l_col,l_data=[],[],[]
         l_offset,l_nnzIdx,l_nnzs = p_offset,p_nnzIdx,p_nnzs
+        l_prevRowIdx,l_prevColIdx = 0,0
         while l_nnzs > 0 :
             if l_nnzIdx % l_rowIdxMod == 0:
-                l_rowIdx = np.frombuffer(self.buf[p_chId], dtype=np.uint16, count=l_memIdxWidth, offset=l_offset)
-                for i in range(l_memIdxWidth):
+                l_rowIdx = decode_idx(self.buf[p_chId], l_offset, l_rowIdxWidth, p_rowBits, l_prevRowIdx)
+                l_prevRowIdx = l_rowIdx[-1]
+                for i in range(l_rowIdxWidth):
                     l_row.extend([l_rowIdx[i]+p_sRowId]*l_rowIdxGap)
                 l_offset += self.memBytes
             if l_nnzIdx % l_colIdxMod == 0:
-                l_colIdx = np.frombuffer(self.buf[p_chId], dtype=np.uint16, count=l_memIdxWidth, offset=l_offset)
-                for i in range(l_memIdxWidth):
+                l_colIdx = decode_idx(self.buf[p_chId], l_offset, l_colIdxWidth, p_colBits, l_prevColIdx)
+                l_prevColIdx = l_colIdx[-1]
+                for i in range(l_colIdxWidth):
                     for j in range(self.parEntries):
                         l_col.append((l_colIdx[i]+p_sColId)*self.parEntries+j)
                 l_offset += self.memBytes
-            l_data.extend(np.frombuffer(self.buf[p_chId], dtype=np.float64, count=self.parEntries, offset=l_offset))
-            l_offset += self.memBytes
+            l_group = (l_nnzIdx // self.parEntries) % l_valGroups
+            l_data.extend(decode_vals(self.valType, self.buf[p_chId], self.parEntries, l_offset + l_group*self.parEntries*val_bytes(self.valType)))
+            if l_group == l_valGroups-1 or l_nnzs == self.parEntries:
+                l_offset += self.memBytes
             l_nnzIdx += self.parEntries
             l_nnzs -= self.parEntries
         return [l_row,l_col,l_data, l_offset]
        
     
-    def write_file(self, filenames):
+    def update_header(self):
         for i in range(self.channels):
             assert self.totalBks[i] == (self.totalRowIdxBks[i]+self.totalColIdxBks[i]+self.totalNnzBks[i])
             int32Arr = np.zeros(self.memBytes//4, dtype=np.uint32)
-            int32Arr[0:4] = [self.totalBks[i], self.totalRowIdxBks[i], self.totalColIdxBks[i], self.totalNnzBks[i]]
+            int32Arr[0:5] = [self.totalBks[i], self.totalRowIdxBks[i], self.totalColIdxBks[i], self.totalNnzBks[i], self.valType]
             self.buf[i][:self.memBytes] = int32Arr.tobytes()
+
+    def set_buf(self, p_chId, p_buf):
+        i = p_chId
+        self.buf[i] = p_buf
+        int32Arr = np.frombuffer(self.buf[i], dtype=np.uint32, count=self.memBytes//4, offset=0)
+        [self.totalBks[i], self.totalRowIdxBks[i], self.totalColIdxBks[i], self.totalNnzBks[i]] = int32Arr[0:4]
+        self.set_valType(int(int32Arr[4]))
+        assert self.totalBks[i] == (self.totalRowIdxBks[i]+self.totalColIdxBks[i]+self.totalNnzBks[i])
+
+    def write_file(self, filenames):
+        self.update_header()
+        for i in range(self.channels):
             fo = open(filenames[i], "wb")
             fo.write(self.buf[i])
             fo.close()
 
     def read_file(self, filenames):
         for i in range(self.channels):
-            int32Arr = np.zeros(self.memBytes//4, dtype=np.uint32)
             fi = open(filenames[i], "rb")
-            self.buf[i] = fi.read()
-            int32Arr = np.frombuffer(self.buf[i], dtype=np.uint32, count=self.memBytes//4, offset=0)
-            [self.totalBks[i], self.totalRowIdxBks[i], self.totalColIdxBks[i], self.totalNnzBks[i]] = int32Arr[0:4]
-            assert self.totalBks[i] == (self.totalRowIdxBks[i]+self.totalColIdxBks[i]+self.totalNnzBks[i])
+            self.set_buf(i, fi.read())
             fi.close()
 
     def print_file(self, filenames):
@@ -348,7 +425,7 @@ class nnz_store:
         l_colIdxMod = self.memBytes//2
         for i in range(self.channels):
             fo = open(filenames[i], "w")
-            fo.write("Total Bks, RowIdxBks, ColIdxBks, NNzBks: {}, {}, {}, {}\n".format(self.totalBks[i], self.totalRowIdxBks[i], self.totalColIdxBks[i], self.totalNnzBks[i]))
+            fo.write("Total Bks, RowIdxBks, ColIdxBks, NNzBks, ValType: {}, {}, {}, {}, {}\n".format(self.totalBks[i], self.totalRowIdxBks[i], self.totalColIdxBks[i], self.totalNnzBks[i], self.valType))
             bk = 0
             l_offset = self.memBytes
             while bk < self.totalNnzBks[i]:
@@ -360,8 +437,8 @@ class nnz_store:
                     chInt16Arr = np.frombuffer(self.buf[i], dtype=np.uint16, count=self.memBytes//2, offset=l_offset)
                     fo.write("Col Idx for {} channels: {}\n".format(self.channels, chInt16Arr))
                     l_offset += self.memBytes
-                float64Arr = np.frombuffer(self.buf[i], dtype=np.float64, count=self.parEntries, offset=l_offset)
-                fo.write("NNZ val for BK {}: {}\n".format(bk, float64Arr))
+                l_valArr = decode_vals(self.valType, self.buf[i], self.parEntries*self.get_valGroups(), l_offset)
+                fo.write("NNZ val for BK {}: {}\n".format(bk, l_valArr))
                 l_offset += self.memBytes
                 bk += 1
             fo.close()
@@ -27,10 +27,22 @@
  # limitations under the License.
 
 import os 
+import struct
+import zlib
 import numpy as np
 from collections import Counter
 from matrix_params import * 
 
+# signature container file, see SigFileHeader in include/sw/fp64/gen_signature.hpp
+SIG_FILE_MAGIC = b'XSPMSIG\0'
+SIG_FILE_VERSION = 1
+SIG_FILE_ALIGN = 4096
+SIG_FILE_HEADER = struct.Struct('<8sII6I6QII')
+SIG_FILE_SECTION = struct.Struct('<QQII')
+
+def sig_file_roundup(p_bytes):
+    return (p_bytes + SIG_FILE_ALIGN - 1) // SIG_FILE_ALIGN * SIG_FILE_ALIGN
+
 class signature:
     def __init__(self, parEntries, accLatency, channels, maxRows, maxCols, memBits):
         self.parEntries,self.accLatency,self.channels = parEntries,accLatency,channels
@@ -41,6 +53,9 @@ class signature:
         self.m,self.n,self.nnz = 0,0,0
         self.mPad,self.nPad,self.nnzPad = 0,0,0
     
+    def set_valType(self, p_valType):
+        self.nnzStore.set_valType(p_valType)
+
     def add_spm(self, p_row, p_col, p_data, p_list):
         l_spm = sparse_matrix()
         l_spm.create_matrix(p_row, p_col, p_data)
@@ -270,6 +285,7 @@ class signature:
         l_rowIdxGap = self.parEntries * self.accLatency
         l_rowIdxMod = l_memIdxWidth * l_rowIdxGap
         l_colIdxMod = l_memIdxWidth * self.parEntries
+        l_valGroups = self.nnzStore.get_valGroups()
         l_sParId = 0
         for rbId in range(self.rbParam.totalRbs):
             l_pars = self.rbParam.get_rbInfo(rbId, 0)[3]
@@ -281,7 +297,7 @@ class signature:
                     l_chParSpm = p_chParSpms[c][l_parId]
                     self.nnzStore.totalRowIdxBks[c] += math.ceil(l_chParSpm.nnz/l_rowIdxMod)
                     self.nnzStore.totalColIdxBks[c] += math.ceil(l_chParSpm.nnz/l_colIdxMod)
-                    self.nnzStore.totalNnzBks[c] += l_chParSpm.nnz // self.parEntries
+                    self.nnzStore.totalNnzBks[c] += math.ceil(l_chParSpm.nnz // self.parEntries / l_valGroups)
                     l_sChRbRowId = self.rbParam.get_chInfo16(rbId, 0)[c] + l_sRbRowId
                     l_sChParColId = self.parParam.get_chInfo16(l_parId, 0)[c] + l_sParColId
                     l_rowIdx = [0]*l_memIdxWidth
@@ -300,7 +316,7 @@ class signature:
                             self.nnzStore.add_idxArr(c, l_colIdx)
                         for j in range(self.parEntries):
                             l_nnz[j] = l_chParSpm.data[i+j]
-                        self.nnzStore.add_nnzArr(c,l_nnz)
+                        self.nnzStore.add_nnzArr(c,l_nnz,i//self.parEntries)
             l_sParId += l_pars
 
         for c in range(self.channels):
@@ -355,6 +371,56 @@ class signature:
         self.mPad,self.nPad,self.nnzPad = int32Arr[3],int32Arr[4],int32Arr[5]
         fi.close()
 
+    def store_file(self, fileName):
+        self.rbParam.update_header()
+        self.parParam.update_header()
+        self.nnzStore.update_header()
+        l_bufs = [self.rbParam.buf, self.parParam.buf] + self.nnzStore.buf
+        l_headerBytes = sig_file_roundup(SIG_FILE_HEADER.size + len(l_bufs)*SIG_FILE_SECTION.size)
+        l_table = bytearray()
+        l_offset = l_headerBytes
+        for l_buf in l_bufs:
+            l_table.extend(SIG_FILE_SECTION.pack(l_offset, len(l_buf), zlib.crc32(l_buf), 0))
+            l_offset += sig_file_roundup(len(l_buf))
+        l_params = [SIG_FILE_MAGIC, SIG_FILE_VERSION, l_headerBytes,
+                    self.parEntries, self.accLatency, self.channels, self.maxRows, self.maxCols, self.memBits,
+                    self.m, self.n, self.nnz, self.mPad, self.nPad, self.nnzPad, len(l_bufs)]
+        l_header = SIG_FILE_HEADER.pack(*(l_params + [0])) + l_table
+        l_header = SIG_FILE_HEADER.pack(*(l_params + [zlib.crc32(l_header)])) + l_table
+        fo = open(fileName, 'wb')
+        fo.write(l_header.ljust(l_headerBytes, b'\0'))
+        for l_buf in l_bufs:
+            fo.write(l_buf)
+            fo.write(bytes(sig_file_roundup(len(l_buf)) - len(l_buf)))
+        fo.close()
+
+    def load_file(self, fileName, verify=True):
+        fi = open(fileName, 'rb')
+        l_data = fi.read()
+        fi.close()
+        assert len(l_data) >= SIG_FILE_HEADER.size and l_data[:8] == SIG_FILE_MAGIC, "{} is not a signature file".format(fileName)
+        l_header = SIG_FILE_HEADER.unpack_from(l_data, 0)
+        assert l_header[1] == SIG_FILE_VERSION, "signature file version {} is not supported".format(l_header[1])
+        l_sections, l_headerCrc = l_header[-2], l_header[-1]
+        l_tableEnd = SIG_FILE_HEADER.size + l_sections*SIG_FILE_SECTION.size
+        assert l_tableEnd <= len(l_data), "signature file header is damaged"
+        l_crc = zlib.crc32(l_data[:SIG_FILE_HEADER.size-4] + bytes(4) + l_data[SIG_FILE_HEADER.size:l_tableEnd])
+        assert l_crc == l_headerCrc, "signature file header is damaged"
+        l_params = [self.parEntries, self.accLatency, self.channels, self.maxRows, self.maxCols, self.memBits]
+        assert list(l_header[3:9]) == l_params and l_sections >= self.channels+2, "signature file was generated with different partition parameters"
+        self.m,self.n,self.nnz,self.mPad,self.nPad,self.nnzPad = l_header[9:15]
+        l_bufs = []
+        for i in range(self.channels+2):
+            [l_offset, l_bytes, l_secCrc] = SIG_FILE_SECTION.unpack_from(l_data, SIG_FILE_HEADER.size + i*SIG_FILE_SECTION.size)[0:3]
+            assert l_offset % SIG_FILE_ALIGN == 0 and l_offset + l_bytes <= len(l_data), "signature file section {} is out of range".format(i)
+            l_buf = l_data[l_offset:l_offset+l_bytes]
+            assert not verify or zlib.crc32(l_buf) == l_secCrc, "signature file section {} is damaged".format(i)
+            l_bufs.append(l_buf)
+        self.rbParam.set_buf(l_bufs[0])
+        self.parParam.set_buf(l_bufs[1])
+        for c in range(self.channels):
+            self.nnzStore.set_buf(c, l_bufs[c+2])
+
     def print_rbParam(self, fileName):
         self.rbParam.print_file(fileName)
 
@@ -392,7 +458,8 @@ class signature:
                     l_chColOff = self.parParam.get_chInfo16(l_parId,0)[c]
                     l_sChColId = l_sParColId + l_chColOff
                     l_chNnzs = self.parParam.get_chInfo32(l_parId,1)[c]
-                    [l_row,l_col,l_data,l_offset] = self.nnzStore.get_chPar(c, l_chOffset[c], 0, l_chNnzs, l_sChRowId, l_sChColId)
+                    l_idxBits = int(self.parParam.get_chInfo16(l_parId,2)[c])
+                    [l_row,l_col,l_data,l_offset] = self.nnzStore.get_chPar(c, l_chOffset[c], 0, l_chNnzs, l_sChRowId, l_sChColId, l_idxBits & 0xff, l_idxBits >> 8)
                     l_chOffset[c] = l_offset
                     l_chIdx[c] += l_chNnzs
                     for i in range(l_chNnzs):
@@ -413,5 +480,10 @@ class signature:
         l_dataFile = os.path.join(mtxSigPath, "data.bin")
         l_spm = sparse_matrix()
         l_spm.create_matrix_from_files(l_rowIdxFile, l_colIdxFile, l_dataFile)
+        if self.nnzStore.valType != VAL_FP64:
+            # compare against the values rounded to the stored type, entries rounded to 0 are dropped as padding
+            l_data = decode_vals(self.nnzStore.valType, encode_vals(self.nnzStore.valType, l_spm.data), l_spm.nnz, 0)
+            l_keep = l_data != 0
+            l_spm.create_matrix(l_spm.row[l_keep], l_spm.col[l_keep], l_data[l_keep])
         l_sigSpm = self.create_spm()
         return l_spm.is_equal(l_sigSpm)
@@ -127,36 +127,41 @@ int main(int argc, char** argv) {
         l_rbParamFileName = l_sigPath + "/" + l_mtxName + "/rbParam.dat";
         l_xFileName = l_vecPath + "/" + l_mtxName + "/inVec.dat";
 
-        std::vector<uint8_t, alignedAllocator<uint8_t> > l_nnzBuf[SPARSE_hbmChannels];
+        // signature files are mapped instead of being copied into host buffers
+        MappedBinFile l_nnzFiles[SPARSE_hbmChannels];
         void* l_nnzBufPtr[SPARSE_hbmChannels];
         size_t l_nnzBufBytes[SPARSE_hbmChannels];
 
-        std::vector<uint8_t, alignedAllocator<uint8_t> > l_parXbuf[2]; 
+        MappedBinFile l_parParamFile;
+        std::vector<uint8_t, alignedAllocator<uint8_t> > l_xBuf;
         void* l_parXbufPtr[2];
         size_t l_parXbufBytes[2];
         
-        std::vector<uint8_t, alignedAllocator<uint8_t> > l_rbParamBuf;
+        MappedBinFile l_rbParamFile;
         size_t l_rbParamBufBytes;
 
         for (unsigned int i = 0; i < SPARSE_hbmChannels; ++i) {
-            l_nnzBufBytes[i]  = getBinBytes(l_datFileName[i]);
-            l_nnzBuf[i].resize(l_nnzBufBytes[i]);
-            readBin<uint8_t>(l_datFileName[i], l_nnzBufBytes[i], l_nnzBuf[i].data());
-            l_nnzBufPtr[i] = l_nnzBuf[i].data();
+            if (!l_nnzFiles[i].open(l_datFileName[i])) {
+                return EXIT_FAILURE;
+            }
+            l_nnzBufBytes[i] = l_nnzFiles[i].size();
+            l_nnzBufPtr[i] = l_nnzFiles[i].data();
+        }
+        if (!l_parParamFile.open(l_parParamFileName)) {
+            return EXIT_FAILURE;
         }
-        l_parXbufBytes[0] = getBinBytes(l_parParamFileName);
-        l_parXbuf[0].resize(l_parXbufBytes[0]);
-        readBin<uint8_t>(l_parParamFileName, l_parXbufBytes[0], l_parXbuf[0].data());
-        l_parXbufPtr[0] = l_parXbuf[0].data();
+        l_parXbufBytes[0] = l_parParamFile.size();
+        l_parXbufPtr[0] = l_parParamFile.data();
 
         l_parXbufBytes[1] = getBinBytes(l_xFileName);
-        l_parXbuf[1].resize(l_parXbufBytes[1]);
-        readBin<uint8_t>(l_xFileName, l_parXbufBytes[1], l_parXbuf[1].data());
-        l_parXbufPtr[1] = l_parXbuf[1].data();
+        l_xBuf.resize(l_parXbufBytes[1]);
+        readBin<uint8_t>(l_xFileName, l_parXbufBytes[1], l_xBuf.data());
+        l_parXbufPtr[1] = l_xBuf.data();
 
-        l_rbParamBufBytes = getBinBytes(l_rbParamFileName);
-        l_rbParamBuf.resize(l_rbParamBufBytes);
-        readBin<uint8_t>(l_rbParamFileName, l_rbParamBufBytes, l_rbParamBuf.data());
+        if (!l_rbParamFile.open(l_rbParamFileName)) {
+            return EXIT_FAILURE;
+        }
+        l_rbParamBufBytes = l_rbParamFile.size();
         
         std::vector<uint32_t> l_info(6);
         readBin<uint32_t>(l_sigPath + "/" + l_mtxName + "/info.dat", 6 * sizeof(uint32_t), l_info.data());
@@ -180,7 +185,7 @@ int main(int argc, char** argv) {
         l_computeHost.createKernels();
         l_computeHost.createLoadNnzBufs(l_nnzBufBytes, l_nnzBufPtr);
         l_computeHost.createLoadParXbufs(l_parXbufBytes, l_parXbufPtr);
-        l_computeHost.createLoadRbParamBufs(l_rbParamBufBytes, l_rbParamBuf.data());
+        l_computeHost.createLoadRbParamBufs(l_rbParamBufBytes, l_rbParamFile.data());
         l_computeHost.setKrnTransYargs(0, l_paddedRows);
         l_computeHost.sendBOs();
         l_computeHost.run();
@@ -0,0 +1,189 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef CGBATCH_HPP
+#define CGBATCH_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pcg.h"
+#include "impl/cgException.hpp"
+
+namespace xilinx_apps {
+namespace pcg {
+
+/**
+ * @brief CooBatch packs independent COO systems into one block-diagonal system
+ *
+ * System i occupies rows and cols [getOffset(i), getOffset(i) + n_i) of the packed matrix, its entries follow those
+ * of system i - 1. The right-hand sides are scaled to unit norm when packed, so that the solver's stopping test
+ * |r|^2 <= tol^2 * |b|^2 on the packed system bounds the relative residual of every system, see getPackedTol. The
+ * batch only keeps pointers to the caller's arrays.
+ */
+template <typename t_DataType>
+class CooBatch {
+   public:
+    CooBatch(const uint32_t p_numSys,
+             const uint32_t* p_n,
+             const uint32_t* p_nnz,
+             const uint32_t* const* p_rowIdx,
+             const uint32_t* const* p_colIdx,
+             const t_DataType* const* p_data,
+             const int p_storeType)
+        : m_numSys(p_numSys),
+          m_n(p_n),
+          m_nnz(p_nnz),
+          m_rowIdx(p_rowIdx),
+          m_colIdx(p_colIdx),
+          m_data(p_data),
+          m_storeType(p_storeType) {
+        if (p_numSys == 0) {
+            throw CgInvalidValue("Wrong number of systems.");
+        }
+        if (p_n == nullptr || p_nnz == nullptr || p_data == nullptr) {
+            throw CgInvalidValue("Batch is nullptr.");
+        }
+        m_offsets.resize(p_numSys + 1, 0);
+        m_nnzOffsets.resize(p_numSys + 1, 0);
+        for (uint32_t i = 0; i < p_numSys; ++i) {
+            if (p_n[i] == 0 || p_nnz[i] < p_n[i]) {
+                throw CgInvalidValue("Wrong dimension or non-zero element size of system " + std::to_string(i) + ".");
+            }
+            m_offsets[i + 1] = m_offsets[i] + p_n[i];
+            m_nnzOffsets[i + 1] = m_nnzOffsets[i] + p_nnz[i];
+        }
+        if (m_offsets[p_numSys] > UINT32_MAX) {
+            throw CgInvalidValue("Batch is too large.");
+        }
+    }
+
+    uint32_t getNumSys() const { return m_numSys; }
+    uint32_t getDim() const { return m_offsets[m_numSys]; }
+    uint64_t getNnz() const { return m_nnzOffsets[m_numSys]; }
+    uint64_t getOffset(const uint32_t p_sys) const { return m_offsets[p_sys]; }
+    // dims and nnzs of the systems, two batches with the same shape and indices have the same sparsity pattern
+    std::vector<uint64_t> getShape() const {
+        std::vector<uint64_t> l_shape(m_offsets);
+        l_shape.insert(l_shape.end(), m_nnzOffsets.begin(), m_nnzOffsets.end());
+        return l_shape;
+    }
+
+    // C-indexed COO entries of the packed matrix; genVals fills the values in the same order
+    void genCoo(uint32_t* p_rowIdx, uint32_t* p_colIdx, t_DataType* p_data) const {
+        if (m_rowIdx == nullptr || m_colIdx == nullptr) {
+            throw CgInvalidValue("Batch is nullptr.");
+        }
+        for (uint32_t i = 0; i < m_numSys; ++i) {
+            if (m_rowIdx[i] == nullptr || m_colIdx[i] == nullptr) {
+                throw CgInvalidValue("Matrix of system " + std::to_string(i) + " is nullptr.");
+            }
+            const uint64_t l_base = m_nnzOffsets[i];
+            for (uint64_t k = 0; k < m_nnz[i]; ++k) {
+                uint32_t l_row = m_rowIdx[i][k] - m_storeType, l_col = m_colIdx[i][k] - m_storeType;
+                if (l_row >= m_n[i] || l_col >= m_n[i]) {
+                    throw CgInvalidValue("Index out of range in system " + std::to_string(i) + ".");
+                }
+                p_rowIdx[l_base + k] = m_offsets[i] + l_row;
+                p_colIdx[l_base + k] = m_offsets[i] + l_col;
+            }
+        }
+        genVals(p_data);
+    }
+    void genVals(t_DataType* p_data) const {
+        for (uint32_t i = 0; i < m_numSys; ++i) {
+            if (m_data[i] == nullptr) {
+                throw CgInvalidValue("Matrix of system " + std::to_string(i) + " is nullptr.");
+            }
+            std::copy(m_data[i], m_data[i] + m_nnz[i], p_data + m_nnzOffsets[i]);
+        }
+    }
+
+    // packs the diagonals and the unit-norm right-hand sides, p_norms receives |b_i|
+    void packVec(const t_DataType* const* p_b,
+                 const t_DataType* const* p_diagA,
+                 t_DataType* p_packedB,
+                 t_DataType* p_packedDiag,
+                 t_DataType* p_norms) const {
+        if (p_b == nullptr || p_diagA == nullptr) {
+            throw CgInvalidValue("Vector is nullptr.");
+        }
+        for (uint32_t i = 0; i < m_numSys; ++i) {
+            if (p_b[i] == nullptr || p_diagA[i] == nullptr) {
+                throw CgInvalidValue("Vector of system " + std::to_string(i) + " is nullptr.");
+            }
+            t_DataType l_dot = 0;
+            for (uint32_t k = 0; k < m_n[i]; ++k) {
+                l_dot += p_b[i][k] * p_b[i][k];
+            }
+            if (!(l_dot > 0)) {
+                throw CgInvalidValue("Right-hand side of system " + std::to_string(i) + " is zero.");
+            }
+            p_norms[i] = std::sqrt(l_dot);
+            for (uint32_t k = 0; k < m_n[i]; ++k) {
+                p_packedB[m_offsets[i] + k] = p_b[i][k] / p_norms[i];
+                p_packedDiag[m_offsets[i] + k] = p_diagA[i][k];
+            }
+        }
+    }
+    // packs the initial guesses in the scale of the unit-norm right-hand sides
+    void packX(const t_DataType* const* p_x, const t_DataType* p_norms, t_DataType* p_packedX) const {
+        if (p_x == nullptr) {
+            throw CgInvalidValue("Initial guess is nullptr.");
+        }
+        for (uint32_t i = 0; i < m_numSys; ++i) {
+            if (p_x[i] == nullptr) {
+                throw CgInvalidValue("Initial guess of system " + std::to_string(i) + " is nullptr.");
+            }
+            for (uint32_t k = 0; k < m_n[i]; ++k) {
+                p_packedX[m_offsets[i] + k] = p_x[i][k] / p_norms[i];
+            }
+        }
+    }
+    // the tolerance of the packed system, |r|^2 <= (p_tol^2 / N) * N then implies |r_i| <= p_tol for each system
+    t_DataType getPackedTol(const t_DataType p_tol) const { return p_tol / std::sqrt((t_DataType)m_numSys); }
+
+    // splits the packed solution and residual, p_res receives the relative residual of each system
+    void unpack(const t_DataType* p_packedX,
+                const t_DataType* p_packedR,
+                const t_DataType* p_norms,
+                t_DataType* const* p_x,
+                t_DataType* p_res) const {
+        for (uint32_t i = 0; i < m_numSys; ++i) {
+            t_DataType l_rr = 0;
+            for (uint32_t k = 0; k < m_n[i]; ++k) {
+                p_x[i][k] = p_packedX[m_offsets[i] + k] * p_norms[i];
+                l_rr += p_packedR[m_offsets[i] + k] * p_packedR[m_offsets[i] + k];
+            }
+            p_res[i] = std::sqrt(l_rr);
+        }
+    }
+
+   private:
+    uint32_t m_numSys;
+    const uint32_t* m_n;
+    const uint32_t* m_nnz;
+    const uint32_t* const* m_rowIdx;
+    const uint32_t* const* m_colIdx;
+    const t_DataType* const* m_data;
+    int m_storeType;
+    std::vector<uint64_t> m_offsets, m_nnzOffsets;
+};
+}
+}
+#endif
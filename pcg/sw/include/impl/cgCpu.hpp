@@ -0,0 +1,224 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef CGCPU_HPP
+#define CGCPU_HPP
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "spmvModel.hpp"
+#include "impl/cgInstr.hpp"
+#include "cgVector.hpp"
+#include "cgStencil.hpp"
+
+namespace xilinx_apps {
+namespace pcg {
+
+/**
+ * @brief xCgCpu runs the JPCG kernels on the host, it takes the place of xCgHost when no card is used
+ *
+ * The matrix is the same partitioned signature sent to the card, the SpmvModel of it decodes the signature into CSR
+ * once per matrix and y = A * x runs on p_threads threads. A stencil operator is applied matrix-free instead. The vector kernels work in place on the host vectors and
+ * process t_ParEntries entries per step like the card, so the lanes of the dot products vectorise. The instruction
+ * buffer is read and written the way the control kernel does with one task, so the caller decodes the results in
+ * the same way.
+ */
+template <typename t_DataType, unsigned int t_ParEntries, unsigned int t_InstrBytes>
+class xCgCpu {
+   public:
+    xCgCpu(){};
+    bool init(unsigned int p_threads = 0) {
+        m_threads = p_threads;
+        return true;
+    }
+
+    bool sendMatDat(const xf::sparse::MatPartition& p_matPar) {
+        xf::sparse::SpmvModel<t_DataType>(p_matPar).getCsr(m_rowPtr, m_colIdx, m_vals);
+        m_m = p_matPar.m_m;
+        m_n = p_matPar.m_n;
+        m_stencil = nullptr;
+        return true;
+    }
+    // p_op is kept by the caller until the next sendMatDat or sendStencil, the CSR of the last matrix is dropped
+    bool sendStencil(const StencilOp<t_DataType>* p_op) {
+        std::vector<uint64_t>().swap(m_rowPtr);
+        std::vector<uint32_t>().swap(m_colIdx);
+        std::vector<t_DataType>().swap(m_vals);
+        m_stencil = p_op;
+        m_m = (p_op == nullptr) ? 0 : p_op->getDim();
+        m_n = m_m;
+        return true;
+    }
+
+    bool sendVecDat(void* p_pk,
+                    unsigned int p_pkSize,
+                    void* p_Apk,
+                    unsigned int p_ApkSize,
+                    void* p_zk,
+                    unsigned int p_zkSize,
+                    void* p_rk,
+                    unsigned int p_rkSize,
+                    void* p_jacobi,
+                    unsigned int p_jacobiSize,
+                    void* p_xk,
+                    unsigned int p_xkSize) {
+        unsigned int l_size = p_pkSize;
+        for (unsigned int l_bytes : {p_ApkSize, p_zkSize, p_rkSize, p_jacobiSize, p_xkSize}) {
+            l_size = std::min(l_size, l_bytes);
+        }
+        m_vecSize = l_size / sizeof(t_DataType);
+        m_pk = (t_DataType*)p_pk;
+        m_Apk = (t_DataType*)p_Apk;
+        m_zk = (t_DataType*)p_zk;
+        m_rk = (t_DataType*)p_rk;
+        m_jacobi = (t_DataType*)p_jacobi;
+        m_xk = (t_DataType*)p_xk;
+        return true;
+    }
+
+    // the vectors are used in place, nothing to upload
+    bool updateVecDat(void*, unsigned int, void*, unsigned int, void*, unsigned int, void*, unsigned int) {
+        return m_pk != nullptr;
+    }
+
+    bool sendInstr(void* p_instr, unsigned int p_instrSize) {
+        m_instr = (uint8_t*)p_instr;
+        m_instrSize = p_instrSize;
+        return true;
+    }
+
+    bool run() {
+        if (m_instr == nullptr || m_pk == nullptr || m_instrSize < t_InstrBytes) {
+            return false;
+        }
+        xf::hpc::MemInstr<t_InstrBytes> l_memInstr;
+        xf::hpc::cg::CGSolverInstr<t_DataType> l_cgInstr;
+        l_cgInstr.load(m_instr, l_memInstr);
+        const uint32_t l_vecSize = l_cgInstr.getVecSize();
+        if ((l_vecSize > m_vecSize) || (l_vecSize % t_ParEntries != 0) || (l_vecSize < m_m) || (l_vecSize < m_n)) {
+            return false;
+        }
+        const uint32_t l_maxIter = l_cgInstr.getMaxIter();
+        const t_DataType l_tols = l_cgInstr.getTols();
+        t_DataType l_rz = l_cgInstr.getRZ();
+        uint32_t l_iter = 0;
+        for (uint64_t l_idx = 1; (l_idx + 1) * t_InstrBytes <= m_instrSize; ++l_idx) {
+            spmv(l_vecSize, m_pk, m_Apk);
+            t_DataType l_alpha = l_rz / dot(l_vecSize, m_pk, m_Apk);
+            // xk, rk and zk in one pass, the first entry of each chunk holds rz and the second rr
+            std::vector<t_DataType> l_sums = reduce(l_vecSize, 2, [&](uint32_t i, t_DataType* p_acc) {
+                m_xk[i] += l_alpha * m_pk[i];
+                m_rk[i] -= l_alpha * m_Apk[i];
+                m_zk[i] = m_jacobi[i] * m_rk[i];
+                p_acc[0] += m_rk[i] * m_zk[i];
+                p_acc[t_ParEntries] += m_rk[i] * m_rk[i];
+            });
+            t_DataType l_beta = l_sums[0] / l_rz;
+            l_rz = l_sums[0];
+            forEach(l_vecSize, [&](uint32_t i) { m_pk[i] = m_zk[i] + l_beta * m_pk[i]; });
+
+            l_cgInstr.setID(0);
+            l_cgInstr.setIter(l_iter);
+            l_cgInstr.setRes(l_sums[1]);
+            l_cgInstr.setRZ(l_rz);
+            l_cgInstr.setAlpha(l_alpha);
+            l_cgInstr.setBeta(l_beta);
+            l_cgInstr.setClock(0);
+            l_cgInstr.store(m_instr + l_idx * t_InstrBytes, l_memInstr);
+            // a breakdown (pAp or rz of zero) leaves NaN or inf behind, stop so the host sees it in the record
+            if (!std::isfinite(l_alpha) || !std::isfinite(l_sums[1]) || (l_sums[1] < l_tols) ||
+                (++l_iter >= l_maxIter)) {
+                break;
+            }
+        }
+        return true;
+    }
+    // the vectors are updated in place
+    bool getDat() { return true; }
+    void finish() {}
+
+   private:
+    static constexpr uint32_t t_ChunkSize = 1 << 14;
+
+    template <typename t_Func>
+    void forEach(uint32_t p_size, t_Func p_func) const {
+        xf::sparse::parallelFor(m_threads, (p_size + t_ChunkSize - 1) / t_ChunkSize, [&](uint32_t c) {
+            const uint32_t l_end = std::min<uint64_t>((uint64_t)(c + 1) * t_ChunkSize, p_size);
+            for (uint32_t i = c * t_ChunkSize; i < l_end; ++i) {
+                p_func(i);
+            }
+        });
+    }
+    // p_func(i, p_acc) adds entry i to t_ParEntries lanes per sum, the chunks are summed in a fixed order so that
+    // the results don't depend on the threads
+    template <typename t_Func>
+    std::vector<t_DataType> reduce(uint32_t p_size, unsigned int p_sums, t_Func p_func) const {
+        const uint32_t l_chunks = (p_size + t_ChunkSize - 1) / t_ChunkSize;
+        std::vector<t_DataType> l_acc((uint64_t)l_chunks * p_sums * t_ParEntries, 0);
+        xf::sparse::parallelFor(m_threads, l_chunks, [&](uint32_t c) {
+            t_DataType* l_chAcc = l_acc.data() + (uint64_t)c * p_sums * t_ParEntries;
+            const uint32_t l_end = std::min<uint64_t>((uint64_t)(c + 1) * t_ChunkSize, p_size);
+            for (uint32_t i = c * t_ChunkSize; i < l_end; i += t_ParEntries) {
+                for (unsigned int j = 0; j < t_ParEntries; ++j) {
+                    p_func(i + j, l_chAcc + j);
+                }
+            }
+        });
+        std::vector<t_DataType> l_sums(p_sums, 0);
+        for (uint32_t c = 0; c < l_chunks; ++c) {
+            for (unsigned int s = 0; s < p_sums; ++s) {
+                for (unsigned int j = 0; j < t_ParEntries; ++j) {
+                    l_sums[s] += l_acc[((uint64_t)c * p_sums + s) * t_ParEntries + j];
+                }
+            }
+        }
+        return l_sums;
+    }
+    void spmv(uint32_t p_size, const t_DataType* p_x, t_DataType* p_y) const {
+        if (m_stencil != nullptr) {
+            forEach(p_size, [&](uint32_t i) { p_y[i] = (i < m_m) ? m_stencil->applyRow(i, p_x) : 0; });
+            return;
+        }
+        forEach(p_size, [&](uint32_t i) {
+            t_DataType l_sum = 0;
+            if (i < m_m) {
+                for (uint64_t k = m_rowPtr[i]; k < m_rowPtr[i + 1]; ++k) {
+                    l_sum += m_vals[k] * p_x[m_colIdx[k]];
+                }
+            }
+            p_y[i] = l_sum;
+        });
+    }
+    t_DataType dot(uint32_t p_size, const t_DataType* p_x, const t_DataType* p_y) const {
+        return reduce(p_size, 1, [&](uint32_t i, t_DataType* p_acc) { p_acc[0] += p_x[i] * p_y[i]; })[0];
+    }
+
+    unsigned int m_threads = 0;
+    std::vector<uint64_t> m_rowPtr;
+    std::vector<uint32_t> m_colIdx;
+    std::vector<t_DataType> m_vals;
+    const StencilOp<t_DataType>* m_stencil = nullptr;
+    uint64_t m_m = 0, m_n = 0;
+    uint32_t m_vecSize = 0;
+    t_DataType *m_pk = nullptr, *m_Apk = nullptr, *m_zk = nullptr, *m_rk = nullptr, *m_jacobi = nullptr,
+               *m_xk = nullptr;
+    uint8_t* m_instr = nullptr;
+    uint64_t m_instrSize = 0;
+};
+}
+}
+#endif
@@ -138,6 +138,17 @@ class xCgHost {
                     void* p_xk,
                     unsigned int p_xkSize);
 
+    // uploads the vectors the kernels read before they write them, to the buffers of the last sendVecDat; a null
+    // p_jacobi keeps the jacobi vector on the card
+    bool updateVecDat(void* p_pk,
+                      unsigned int p_pkSize,
+                      void* p_rk,
+                      unsigned int p_rkSize,
+                      void* p_xk,
+                      unsigned int p_xkSize,
+                      void* p_jacobi,
+                      unsigned int p_jacobiSize);
+
     bool sendInstr(void* p_instr, unsigned int p_instrSize);
     bool run();
     bool getDat();
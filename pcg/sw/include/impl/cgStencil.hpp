@@ -0,0 +1,237 @@
+/*
+ * Copyright 2019-2021 Xilinx, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+*/
+
+#ifndef CGSTENCIL_HPP
+#define CGSTENCIL_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "pcg.h"
+#include "impl/cgException.hpp"
+
+namespace xilinx_apps {
+namespace pcg {
+
+/**
+ * @brief StencilOp describes a symmetric 7-point or 27-point stencil on a regular nx x ny x nz grid
+ *
+ * Cell (x, y, z) is row x + nx * (y + ny * z) of the operator, neighbours outside the grid are dropped. The
+ * coefficients of a cell are ordered as center, -x, +x, -y, +y, -z, +z for 7 points, and by (dz, dy, dx) in
+ * {-1, 0, 1}^3, x fastest, for 27 points. They are either shared by all cells or given for each cell. The operator
+ * only keeps a pointer to the coefficients.
+ */
+template <typename t_DataType>
+class StencilOp {
+   public:
+    StencilOp(const uint32_t p_points,
+              const uint32_t p_nx,
+              const uint32_t p_ny,
+              const uint32_t p_nz,
+              const t_DataType* p_coefs,
+              const bool p_perCell)
+        : m_points(p_points), m_nx(p_nx), m_ny(p_ny), m_nz(p_nz), m_coefs(p_coefs), m_perCell(p_perCell) {
+        if (p_points == 7) {
+            const int l_offs[7][3] = {{0, 0, 0}, {-1, 0, 0}, {1, 0, 0}, {0, -1, 0}, {0, 1, 0}, {0, 0, -1}, {0, 0, 1}};
+            for (unsigned int k = 0; k < 7; ++k) {
+                m_offs.push_back({{l_offs[k][0], l_offs[k][1], l_offs[k][2]}});
+            }
+            m_center = 0;
+        } else if (p_points == 27) {
+            for (int dz = -1; dz <= 1; ++dz) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        m_offs.push_back({{dx, dy, dz}});
+                    }
+                }
+            }
+            m_center = 13;
+        } else {
+            throw CgInvalidValue("Only 7-point and 27-point stencils are supported.");
+        }
+        if (p_nx == 0 || p_ny == 0 || p_nz == 0) {
+            throw CgInvalidValue("Wrong stencil grid size.");
+        }
+        if (p_coefs == nullptr) {
+            throw CgInvalidValue("Stencil coefficients are nullptr.");
+        }
+        for (unsigned int k = 0; k < m_points; ++k) {
+            for (unsigned int j = 0; j < m_points; ++j) {
+                if (m_offs[j][0] == -m_offs[k][0] && m_offs[j][1] == -m_offs[k][1] && m_offs[j][2] == -m_offs[k][2]) {
+                    m_mirror.push_back(j);
+                }
+            }
+        }
+        checkSym();
+    }
+
+    uint32_t getPoints() const { return m_points; }
+    uint64_t getDim() const { return (uint64_t)m_nx * m_ny * m_nz; }
+    // grid and points, two operators with the same shape have the same sparsity pattern
+    std::array<uint32_t, 4> getShape() const { return {{m_nx, m_ny, m_nz, m_points}}; }
+    // entries within the grid, zero coefficients included so that the pattern doesn't depend on the values
+    uint64_t getNnz() const {
+        uint64_t l_nnz = 0;
+        for (unsigned int k = 0; k < m_points; ++k) {
+            l_nnz += (uint64_t)(m_nx - std::abs(m_offs[k][0])) * (m_ny - std::abs(m_offs[k][1])) *
+                     (m_nz - std::abs(m_offs[k][2]));
+        }
+        return l_nnz;
+    }
+    const t_DataType* getCoefs() const { return m_coefs; }
+    bool isPerCell() const { return m_perCell; }
+    uint64_t getNumCoefs() const { return m_perCell ? getDim() * m_points : m_points; }
+    t_DataType getCoef(const uint64_t p_cell, const unsigned int p_point) const {
+        return m_perCell ? m_coefs[p_cell * m_points + p_point] : m_coefs[p_point];
+    }
+    void getDiag(t_DataType* p_diag) const {
+        for (uint64_t i = 0; i < getDim(); ++i) {
+            p_diag[i] = getCoef(i, m_center);
+        }
+    }
+
+    // row p_row of A * p_x, the rows don't depend on each other so that the caller can split them across threads
+    t_DataType applyRow(const uint64_t p_row, const t_DataType* p_x) const {
+        const int64_t l_x = p_row % m_nx, l_y = (p_row / m_nx) % m_ny, l_z = p_row / ((uint64_t)m_nx * m_ny);
+        t_DataType l_sum = 0;
+        for (unsigned int k = 0; k < m_points; ++k) {
+            int64_t l_cx = l_x + m_offs[k][0], l_cy = l_y + m_offs[k][1], l_cz = l_z + m_offs[k][2];
+            if (l_cx >= 0 && l_cx < m_nx && l_cy >= 0 && l_cy < m_ny && l_cz >= 0 && l_cz < m_nz) {
+                l_sum += getCoef(p_row, k) * p_x[l_cx + (uint64_t)m_nx * (l_cy + (uint64_t)m_ny * l_cz)];
+            }
+        }
+        return l_sum;
+    }
+    // matrix-free p_y = A * p_x
+    void apply(const t_DataType* p_x, t_DataType* p_y) const {
+        for (uint64_t i = 0; i < getDim(); ++i) {
+            p_y[i] = applyRow(i, p_x);
+        }
+    }
+    // COO entries of the operator, row by row; genVals fills the values in the same order
+    void genCoo(uint32_t* p_rowIdx, uint32_t* p_colIdx, t_DataType* p_data) const {
+        uint64_t l_idx = 0;
+        forEachEntry([&](uint64_t p_row, uint64_t p_col, unsigned int p_point) {
+            p_rowIdx[l_idx] = p_row;
+            p_colIdx[l_idx] = p_col;
+            p_data[l_idx++] = getCoef(p_row, p_point);
+        });
+    }
+    void genVals(t_DataType* p_data) const {
+        uint64_t l_idx = 0;
+        forEachEntry(
+            [&](uint64_t p_row, uint64_t, unsigned int p_point) { p_data[l_idx++] = getCoef(p_row, p_point); });
+    }
+
+   private:
+    // calls p_func(row, col, point) for the entries within the grid, row by row
+    template <typename t_Func>
+    void forEachEntry(t_Func p_func) const {
+        uint64_t l_row = 0;
+        for (uint32_t z = 0; z < m_nz; ++z) {
+            for (uint32_t y = 0; y < m_ny; ++y) {
+                for (uint32_t x = 0; x < m_nx; ++x) {
+                    for (unsigned int k = 0; k < m_points; ++k) {
+                        int64_t l_x = (int64_t)x + m_offs[k][0], l_y = (int64_t)y + m_offs[k][1],
+                                l_z = (int64_t)z + m_offs[k][2];
+                        if (l_x >= 0 && l_x < m_nx && l_y >= 0 && l_y < m_ny && l_z >= 0 && l_z < m_nz) {
+                            p_func(l_row, l_x + (uint64_t)m_nx * (l_y + (uint64_t)m_ny * l_z), k);
+                        }
+                    }
+                    l_row++;
+                }
+            }
+        }
+    }
+    // JPCG needs a symmetric operator with a positive diagonal
+    void checkSym() const {
+        for (uint64_t i = 0; i < (m_perCell ? getDim() : 1); ++i) {
+            if (!(getCoef(i, m_center) > 0)) {
+                throw CgInvalidValue("Stencil center coefficient of cell " + std::to_string(i) + " isn't positive.");
+            }
+        }
+        forEachEntry([&](uint64_t p_row, uint64_t p_col, unsigned int p_point) {
+            if (getCoef(p_row, p_point) != getCoef(p_col, m_mirror[p_point])) {
+                throw CgInvalidValue("Stencil isn't symmetric at cell " + std::to_string(p_row) + ".");
+            }
+        });
+    }
+
+    uint32_t m_points, m_nx, m_ny, m_nz;
+    const t_DataType* m_coefs;
+    bool m_perCell;
+    unsigned int m_center;
+    std::vector<std::array<int, 3> > m_offs;
+    std::vector<unsigned int> m_mirror;
+};
+
+/**
+ * @brief refJPCG is the host reference of the JPCG solver, it only applies p_op, which needs a member
+ * apply(p_x, p_y) computing p_y = A * p_x
+ *
+ * The iterations follow the kernels, starting from x = 0 and stopping when |r| <= p_tol * |b|.
+ * @return the number of iterations, p_res receives the relative residual
+ */
+template <typename t_DataType, typename t_Op>
+uint32_t refJPCG(const t_Op& p_op,
+                 const uint64_t p_dim,
+                 const t_DataType* p_diagA,
+                 const t_DataType* p_b,
+                 t_DataType* p_x,
+                 const uint32_t p_maxIter,
+                 const t_DataType p_tol,
+                 t_DataType& p_res) {
+    std::vector<t_DataType> l_r(p_b, p_b + p_dim), l_z(p_dim), l_p(p_dim), l_Ap(p_dim);
+    t_DataType l_dot = 0, l_rz = 0, l_rr = 0;
+    for (uint64_t i = 0; i < p_dim; ++i) {
+        p_x[i] = 0;
+        l_z[i] = l_r[i] / p_diagA[i];
+        l_p[i] = l_z[i];
+        l_dot += p_b[i] * p_b[i];
+        l_rz += l_r[i] * l_z[i];
+    }
+    l_rr = l_dot;
+    uint32_t l_iter = 0;
+    while (l_iter < p_maxIter && l_rr > l_dot * p_tol * p_tol) {
+        p_op.apply(l_p.data(), l_Ap.data());
+        t_DataType l_pAp = 0;
+        for (uint64_t i = 0; i < p_dim; ++i) {
+            l_pAp += l_p[i] * l_Ap[i];
+        }
+        t_DataType l_alpha = l_rz / l_pAp, l_rzNew = 0;
+        l_rr = 0;
+        for (uint64_t i = 0; i < p_dim; ++i) {
+            p_x[i] += l_alpha * l_p[i];
+            l_r[i] -= l_alpha * l_Ap[i];
+            l_z[i] = l_r[i] / p_diagA[i];
+            l_rzNew += l_r[i] * l_z[i];
+            l_rr += l_r[i] * l_r[i];
+        }
+        t_DataType l_beta = l_rzNew / l_rz;
+        l_rz = l_rzNew;
+        for (uint64_t i = 0; i < p_dim; ++i) {
+            l_p[i] = l_z[i] + l_beta * l_p[i];
+        }
+        l_iter++;
+    }
+    p_res = std::sqrt(l_rr / l_dot);
+    return l_iter;
+}
+}
+}
+#endif
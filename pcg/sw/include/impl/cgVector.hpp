@@ -17,6 +17,7 @@
 #ifndef CGVECTOR_HPP
 #define CGVECTOR_HPP
 
+#include <algorithm>
 #include <vector>
 #include "impl/cgInstr.hpp"
 #include "impl/cgException.hpp"
@@ -51,7 +52,7 @@ struct CgInstr {
 template <typename t_DataType, unsigned int t_ParEntries>
 class GenCgVector {
    public:
-    GenCgVector() : m_dim(0), m_dot(0), m_rz(0){};
+    GenCgVector() : m_dim(0), m_dot(0), m_rz(0), m_rr(0){};
     void loadVec(const unsigned int p_dim, const t_DataType* p_b, const t_DataType* p_diagA) {
         if (p_b == nullptr || p_diagA == nullptr) {
             throw CgInvalidValue("Vector is nullptr.");
@@ -77,19 +78,18 @@ class GenCgVector {
         m_rk.assign(m_dimAligned, 0);
         m_xk.assign(m_dimAligned, 0);
         m_zk.assign(m_dimAligned, 0);
+        m_jacobiChanged = true;
     }
     void updateVec(const unsigned int p_dim, const t_DataType* p_b, const t_DataType* p_diagA) {
         if (p_b == nullptr || p_diagA == nullptr) {
             throw CgInvalidValue("Vector is nullptr.");
         }
-        std::copy(p_diagA, p_diagA + p_dim, m_diagA.begin());
+        // the other vectors are recomputed by init, jacobi only when the diagonal changed
+        if (!std::equal(p_diagA, p_diagA + p_dim, m_diagA.begin())) {
+            std::copy(p_diagA, p_diagA + p_dim, m_diagA.begin());
+            m_jacobiChanged = true;
+        }
         std::copy(p_b, p_b + p_dim, m_b.begin());
-        std::fill(m_Apk.begin(), m_Apk.end(), 0);
-        std::fill(m_jacobi.begin(), m_jacobi.end(), 1);
-        std::fill(m_pk.begin(), m_pk.end(), 0);
-        std::fill(m_rk.begin(), m_rk.end(), 0);
-        std::fill(m_xk.begin(), m_xk.end(), 0);
-        std::fill(m_zk.begin(), m_zk.end(), 0);
     }
     CgInputVec getInputVec() {
         CgInputVec l_res;
@@ -98,17 +98,26 @@ class GenCgVector {
         l_res.h_diag = (void*)(m_diagA.data());
         return l_res;
     }
-    void init() {
+    // starts from x0 = 0, or from p_x0 with r0 = b - p_Ax0
+    void init(const t_DataType* p_x0 = nullptr, const t_DataType* p_Ax0 = nullptr) {
         m_dot = 0;
         m_rz = 0;
+        m_rr = 0;
         m_xk.assign(m_dimAligned, 0);
-        m_Apk.assign(m_dimAligned, 0);
+        if (p_x0 != nullptr) {
+            std::copy(p_x0, p_x0 + m_dim, m_xk.begin());
+        }
+        if (m_jacobiChanged) {
+            for (unsigned int i = 0; i < m_dimAligned; ++i) {
+                m_jacobi[i] = 1.0 / m_diagA[i];
+            }
+        }
         for (unsigned int i = 0; i < m_dimAligned; ++i) {
-            m_rk[i] = m_b[i];
-            m_jacobi[i] = 1.0 / m_diagA[i];
+            m_rk[i] = (p_x0 != nullptr && i < m_dim) ? m_b[i] - p_Ax0[i] : m_b[i];
             m_zk[i] = m_jacobi[i] * m_rk[i];
             m_dot += m_b[i] * m_b[i];
             m_rz += m_rk[i] * m_zk[i];
+            m_rr += m_rk[i] * m_rk[i];
             m_pk[i] = m_zk[i];
         }
     }
@@ -123,15 +132,20 @@ class GenCgVector {
         l_vec.h_zk = (void*)(m_zk.data());
         return l_vec;
     }
+    // jacobi differs from the one last sent to the kernels
+    bool isJacobiChanged() const { return m_jacobiChanged; }
+    void setJacobiSent() { m_jacobiChanged = false; }
     t_DataType getDot() { return m_dot; }
     t_DataType getRz() { return m_rz; }
+    t_DataType getRr() { return m_rr; }
     void* getXk() { return (void*)(m_xk.data()); }
     unsigned int getDimAligned() { return m_dimAligned; }
     unsigned int getDim() { return m_dim; }
 
    private:
     unsigned int m_dim, m_dimAligned;
-    t_DataType m_dot, m_rz;
+    t_DataType m_dot, m_rz, m_rr;
+    bool m_jacobiChanged = true;
     std::vector<t_DataType, alignedAllocator<t_DataType> > m_diagA;
     std::vector<t_DataType, alignedAllocator<t_DataType> > m_b;
     std::vector<t_DataType, alignedAllocator<t_DataType> > m_Apk;
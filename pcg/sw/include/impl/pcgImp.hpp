@@ -17,9 +17,13 @@
 #ifndef PCG_IMP_HPP
 #define PCG_IMP_HPP
 
+#include <memory>
 #include "gen_signature.hpp"
 #include "cgVector.hpp"
 #include "cgHost.hpp"
+#include "cgCpu.hpp"
+#include "cgStencil.hpp"
+#include "cgBatch.hpp"
 #include "pcg.h"
 #include "cgException.hpp"
 
@@ -44,10 +48,19 @@ template <typename t_DataType,
 class PCGImpl {
    public:
     PCGImpl(){};
-    PCGImpl(std::string p_xclbinName) { m_host.init(p_xclbinName); }
-    void init(std::string p_xclbinName) { m_host.init(p_xclbinName); }
+    PCGImpl(std::string p_xclbinName) { init(p_xclbinName); }
+    // "cpu" runs the kernels on the host instead of a card
+    void init(std::string p_xclbinName) {
+        m_useCpu = (p_xclbinName == "cpu");
+        if (m_useCpu) {
+            m_cpu.init();
+        } else {
+            m_host.init(p_xclbinName);
+        }
+    }
+    bool isCpu() const { return m_useCpu; }
     void setCooMat(const uint32_t p_dim,
-                   const uint32_t p_nnz,
+                   const uint64_t p_nnz,
                    const uint32_t* p_rowIdx,
                    const uint32_t* p_colIdx,
                    const t_DataType* p_data,
@@ -61,16 +74,24 @@ class PCGImpl {
         if (p_rowIdx == nullptr || p_colIdx == nullptr || p_data == nullptr) {
             throw CgInvalidValue("Matrix is nullptr.");
         }
-        m_matPar = m_spmPar.partitionCooMat(p_dim, p_dim, p_nnz, p_rowIdx, p_colIdx, p_data, p_storeType);
-        bool l_send = m_host.sendMatDat(m_matPar.m_nnzValPtr, m_matPar.m_nnzValSize, m_matPar.m_rbParamPtr,
-                                        m_matPar.m_rbParamSize, m_matPar.m_parParamPtr, m_matPar.m_parParamSize);
+        clearStencil();
+        m_batchShape.clear();
+        if (m_sigCacheDir.empty()) {
+            m_matPar = m_spmPar.partitionCooMat(p_dim, p_dim, p_nnz, p_rowIdx, p_colIdx, p_data, p_storeType);
+            m_cacheWarning.clear();
+        } else {
+            m_matPar = m_spmPar.partitionCooMatCached(p_dim, p_dim, p_nnz, p_rowIdx, p_colIdx, p_data, p_storeType,
+                                                      m_sigCacheDir);
+            m_cacheWarning = m_spmPar.getCacheWarning();
+        }
+        bool l_send = sendMatDat();
         if (l_send == false) {
             throw CgAllocFailed("Send matirx data failed.");
         }
     }
     template <typename t_IdxType>
     void setCscSymMat(const uint32_t p_dim,
-                      const uint32_t p_nnz,
+                      const uint64_t p_nnz,
                       const t_IdxType* p_rowIdx,
                       const t_IdxType* p_colPtr,
                       const t_DataType* p_data,
@@ -84,15 +105,23 @@ class PCGImpl {
         if (p_rowIdx == nullptr || p_colPtr == nullptr || p_data == nullptr) {
             throw CgInvalidValue("Matrix is nullptr.");
         }
-        uint32_t l_nnz = p_nnz * 2 - p_dim;
-        m_matPar = m_spmPar.partitionCscSymMat(p_dim, l_nnz, p_rowIdx, p_colPtr, p_data, p_storeType);
-        bool l_send = m_host.sendMatDat(m_matPar.m_nnzValPtr, m_matPar.m_nnzValSize, m_matPar.m_rbParamPtr,
-                                        m_matPar.m_rbParamSize, m_matPar.m_parParamPtr, m_matPar.m_parParamSize);
+        uint64_t l_nnz = p_nnz * 2 - p_dim;
+        clearStencil();
+        m_batchShape.clear();
+        if (m_sigCacheDir.empty()) {
+            m_matPar = m_spmPar.partitionCscSymMat(p_dim, l_nnz, p_rowIdx, p_colPtr, p_data, p_storeType);
+            m_cacheWarning.clear();
+        } else {
+            m_matPar = m_spmPar.partitionCscSymMatCached(p_dim, l_nnz, p_rowIdx, p_colPtr, p_data, p_storeType,
+                                                         m_sigCacheDir);
+            m_cacheWarning = m_spmPar.getCacheWarning();
+        }
+        bool l_send = sendMatDat();
         if (l_send == false) {
             throw CgAllocFailed("Send matirx data failed.");
         }
     }
-    int updateMat(const uint32_t p_dim, const uint32_t p_nnz, const t_DataType* p_data) {
+    int updateMat(const uint32_t p_dim, const uint64_t p_nnz, const t_DataType* p_data) {
         if (p_dim == 0) {
             throw CgInvalidValue("Wrong dimension size.");
         }
@@ -102,10 +131,12 @@ class PCGImpl {
         if (p_data == nullptr) {
             throw CgInvalidValue("Matrix is nullptr.");
         }
+        if (m_stencilOp != nullptr) {
+            throw CgInvalidValue("The last matrix is a stencil, it has no non-zero layout to keep.");
+        }
         if (m_spmPar.checkUpdateDim(p_dim, p_dim, p_nnz) == 0) {
             m_matPar = m_spmPar.updateMat(p_data);
-            bool l_send = m_host.sendMatDat(m_matPar.m_nnzValPtr, m_matPar.m_nnzValSize, m_matPar.m_rbParamPtr,
-                                            m_matPar.m_rbParamSize, m_matPar.m_parParamPtr, m_matPar.m_parParamSize);
+            bool l_send = sendMatDat();
             if (l_send == false) {
                 throw CgAllocFailed("Send matirx data failed.");
             }
@@ -116,7 +147,7 @@ class PCGImpl {
     }
     template <typename t_IdxType>
     int updateCscSymMat(const uint32_t p_dim,
-                        const uint32_t p_nnz,
+                        const uint64_t p_nnz,
                         const t_IdxType* p_rowIdx,
                         const t_IdxType* p_colPtr,
                         const t_DataType* p_data,
@@ -130,11 +161,13 @@ class PCGImpl {
         if (p_data == nullptr) {
             throw CgInvalidValue("Matrix is nullptr.");
         }
-        uint32_t l_nnz = p_nnz * 2 - p_dim;
+        if (m_stencilOp != nullptr) {
+            throw CgInvalidValue("The last matrix is a stencil, it has no non-zero layout to keep.");
+        }
+        uint64_t l_nnz = p_nnz * 2 - p_dim;
         if (m_spmPar.checkUpdateDim(p_dim, p_dim, l_nnz) == 0) {
             m_matPar = m_spmPar.updateCscSymMat(p_dim, l_nnz, p_rowIdx, p_colPtr, p_data, p_storeType);
-            bool l_send = m_host.sendMatDat(m_matPar.m_nnzValPtr, m_matPar.m_nnzValSize, m_matPar.m_rbParamPtr,
-                                            m_matPar.m_rbParamSize, m_matPar.m_parParamPtr, m_matPar.m_parParamSize);
+            bool l_send = sendMatDat();
             if (l_send == false) {
                 throw CgAllocFailed("Send matirx data failed.");
             }
@@ -144,19 +177,210 @@ class PCGImpl {
         }
     }
 
-    void setVec(const uint32_t p_dim, const t_DataType* p_b, const t_DataType* p_diagA) {
-        if (p_dim != m_genCgVec.getDim()) {
+    // on a card the stencil is expanded into the signature on the host, as the kernels only stream stored entries;
+    // the COO buffers are dropped once the matrix is partitioned. The cpu backend applies the operator matrix-free.
+    void setStencilMat(const StencilOp<t_DataType>& p_op) {
+        uint64_t l_nnz = p_op.getNnz();
+        if (p_op.getDim() > UINT32_MAX) {
+            throw CgInvalidValue("Stencil grid is too large.");
+        }
+        if (m_useCpu) {
+            clearStencil();
+            m_batchShape.clear();
+            m_cacheWarning.clear();
+            sendStencil(p_op);
+            m_matPar = xf::sparse::MatPartition();
+            m_matPar.m_m = m_matPar.m_mPad = p_op.getDim();
+            m_matPar.m_n = m_matPar.m_nPad = p_op.getDim();
+            m_matPar.m_nnz = m_matPar.m_nnzPad = l_nnz;
+        } else {
+            std::vector<uint32_t> l_rowIdx(l_nnz), l_colIdx(l_nnz);
+            std::vector<t_DataType> l_data(l_nnz);
+            p_op.genCoo(l_rowIdx.data(), l_colIdx.data(), l_data.data());
+            setCooMat(p_op.getDim(), l_nnz, l_rowIdx.data(), l_colIdx.data(), l_data.data(), 0);
+        }
+        m_stencilShape = p_op.getShape();
+        m_stencilDiag.resize(p_op.getDim());
+        p_op.getDiag(m_stencilDiag.data());
+    }
+    // new coefficients for the stencil of the last setStencilMat, only the values are refreshed
+    void updateStencilMat(const StencilOp<t_DataType>& p_op) {
+        checkStencilShape(p_op.getShape());
+        if (m_stencilOp != nullptr) {
+            sendStencil(p_op);
+        } else {
+            std::vector<t_DataType> l_data(p_op.getNnz());
+            p_op.genVals(l_data.data());
+            if (updateMat(p_op.getDim(), l_data.size(), l_data.data()) != 0) {
+                throw CgInternalError("Stencil matrix doesn't match its signature.");
+            }
+        }
+        p_op.getDiag(m_stencilDiag.data());
+    }
+    // a call that keeps the last stencil matrix has to give the same grid and points
+    void checkStencilShape(const std::array<uint32_t, 4>& p_shape) const {
+        if (m_stencilDiag.empty()) {
+            throw CgInvalidValue("No stencil matrix has been set.");
+        }
+        if (p_shape != m_stencilShape) {
+            throw CgInvalidValue("Stencil grid or points differ from the last stencil matrix.");
+        }
+    }
+    // the diagonal of the last stencil matrix, for setVec
+    const t_DataType* getStencilDiag() const {
+        if (m_stencilDiag.empty()) {
+            throw CgInvalidValue("No stencil matrix has been set.");
+        }
+        return m_stencilDiag.data();
+    }
+
+    // the systems of a batch are packed into one block-diagonal matrix, so that they share the partitioned matrix
+    // and a single kernel launch
+    void setBatchMat(const CooBatch<t_DataType>& p_batch) {
+        uint64_t l_nnz = p_batch.getNnz();
+        std::vector<uint32_t> l_rowIdx(l_nnz), l_colIdx(l_nnz);
+        std::vector<t_DataType> l_data(l_nnz);
+        p_batch.genCoo(l_rowIdx.data(), l_colIdx.data(), l_data.data());
+        setCooMat(p_batch.getDim(), l_nnz, l_rowIdx.data(), l_colIdx.data(), l_data.data(), 0);
+        m_batchShape = p_batch.getShape();
+    }
+    // new values for the systems of the last setBatchMat, only the values are refreshed
+    void updateBatchMat(const CooBatch<t_DataType>& p_batch) {
+        if (p_batch.getShape() != m_batchShape) {
+            throw CgInvalidValue("Batch dimensions or non-zero element sizes differ from the last batch.");
+        }
+        std::vector<t_DataType> l_data(p_batch.getNnz());
+        p_batch.genVals(l_data.data());
+        if (updateMat(p_batch.getDim(), l_data.size(), l_data.data()) != 0) {
+            throw CgInternalError("Batch matrix doesn't match its signature.");
+        }
+    }
+    void setBatchVec(const CooBatch<t_DataType>& p_batch,
+                     const t_DataType* const* p_b,
+                     const t_DataType* const* p_diagA,
+                     const t_DataType* const* p_x0 = nullptr) {
+        if (p_batch.getShape() != m_batchShape) {
+            throw CgInvalidValue("Batch doesn't match the last batch matrix.");
+        }
+        m_batchB.resize(p_batch.getDim());
+        m_batchDiagA.resize(p_batch.getDim());
+        m_batchNorms.resize(p_batch.getNumSys());
+        p_batch.packVec(p_b, p_diagA, m_batchB.data(), m_batchDiagA.data(), m_batchNorms.data());
+        if (p_x0 == nullptr) {
+            setVec(p_batch.getDim(), m_batchB.data(), m_batchDiagA.data());
+        } else {
+            std::vector<t_DataType> l_x0(p_batch.getDim());
+            p_batch.packX(p_x0, m_batchNorms.data(), l_x0.data());
+            setVec(p_batch.getDim(), m_batchB.data(), m_batchDiagA.data(), l_x0.data());
+        }
+    }
+    // solves the systems of the last setBatchVec, p_res receives the relative residual of each system
+    Results<t_DataType> runBatch(const CooBatch<t_DataType>& p_batch,
+                                 unsigned int p_maxIter,
+                                 t_DataType p_tol,
+                                 t_DataType* const* p_x,
+                                 t_DataType* p_res) {
+        if (p_x == nullptr || p_res == nullptr) {
+            throw CgInvalidValue("Solution is nullptr.");
+        }
+        for (uint32_t i = 0; i < p_batch.getNumSys(); ++i) {
+            if (p_x[i] == nullptr) {
+                throw CgInvalidValue("Solution of system " + std::to_string(i) + " is nullptr.");
+            }
+        }
+        Results<t_DataType> l_res = run(p_maxIter, p_batch.getPackedTol(p_tol));
+        const uint32_t l_dim = p_batch.getDim();
+        std::vector<t_DataType> l_x(l_dim), l_r(l_dim);
+        copyX(l_dim, l_res, l_x.data());
+        m_spmPar.unpermuteVec(false, l_dim, (const t_DataType*)m_genCgVec.getVec().h_rk, l_r.data());
+        p_batch.unpack(l_x.data(), l_r.data(), m_batchNorms.data(), p_x, p_res);
+        return l_res;
+    }
+
+    // an empty p_dir disables the signature cache used by setCooMat and setCscSymMat
+    void setSigCacheDir(std::string p_dir) {
+        struct stat l_stat;
+        if (!p_dir.empty() && ((stat(p_dir.c_str(), &l_stat) != 0) || !S_ISDIR(l_stat.st_mode))) {
+            throw CgInvalidValue("Signature cache directory " + p_dir + " doesn't exist.");
+        }
+        m_sigCacheDir = p_dir;
+    }
+    // a signature cache file of the last setCooMat or setCscSymMat that was ignored or not written, empty otherwise
+    const std::string& getCacheWarning() const { return m_cacheWarning; }
+
+    // a symmetric reordering applied by the next setCooMat or setCscSymMat, it is transparent to the caller as
+    // setVec and copyX move the vectors in and out of the reordered numbering
+    void setReorder(xf::sparse::SpmReorder p_reorder) {
+        if ((p_reorder != xf::sparse::REORDER_NONE) && (p_reorder != xf::sparse::REORDER_RCM)) {
+            throw CgInvalidValue("Only symmetric reordering is supported by the solver.");
+        }
+        m_spmPar.setReorder(p_reorder);
+    }
+
+    // a non-null p_x0 is the initial guess, r0 = b - A * x0 takes one spmv of the partitioned matrix on the host
+    void setVec(const uint32_t p_dim,
+                const t_DataType* p_b,
+                const t_DataType* p_diagA,
+                const t_DataType* p_x0 = nullptr) {
+        if (m_stencilOp == nullptr && !m_spmPar.getRowPerm().empty()) {
+            m_bPerm.resize(p_dim);
+            m_diagAPerm.resize(p_dim);
+            m_spmPar.permuteVec(true, p_dim, p_b, m_bPerm.data());
+            m_spmPar.permuteVec(true, p_dim, p_diagA, m_diagAPerm.data());
+            p_b = m_bPerm.data();
+            p_diagA = m_diagAPerm.data();
+        }
+        if (p_x0 != nullptr && p_dim != m_matPar.m_n) {
+            throw CgInvalidValue("Initial guess doesn't match the matrix.");
+        }
+        // the kernels keep the buffers of the last vectors of the same size, only the changed ones are uploaded
+        bool l_newVec = (p_dim != m_genCgVec.getDim());
+        if (l_newVec) {
             m_genCgVec.loadVec(p_dim, p_b, p_diagA);
         } else {
             m_genCgVec.updateVec(p_dim, p_b, p_diagA);
         }
-        m_genCgVec.init();
-        this->sendVec();
+        if (p_x0 == nullptr) {
+            m_genCgVec.init();
+        } else {
+            std::vector<t_DataType> l_x0(p_x0, p_x0 + p_dim), l_Ax0(p_dim);
+            if (m_stencilOp != nullptr) {
+                m_stencilOp->apply(l_x0.data(), l_Ax0.data());
+            } else {
+                m_spmPar.permuteVec(false, p_dim, p_x0, l_x0.data());
+                xf::sparse::SpmvModel<t_DataType>(m_matPar).run(l_x0.data(), l_Ax0.data());
+            }
+            m_genCgVec.init(l_x0.data(), l_Ax0.data());
+        }
+        this->sendVec(l_newVec);
     }
 
     Results<t_DataType> run(unsigned int p_maxIter, t_DataType p_tol) {
+        // b = 0 has the exact solution x = 0 with r = 0, whatever the initial guess; |r| / |b| would be 0 / 0
+        if (m_genCgVec.getDot() == 0) {
+            CgVector l_vec = m_genCgVec.getVec();
+            std::fill((t_DataType*)l_vec.h_xk, (t_DataType*)l_vec.h_xk + l_vec.vecBytes / sizeof(t_DataType), 0);
+            std::fill((t_DataType*)l_vec.h_rk, (t_DataType*)l_vec.h_rk + l_vec.vecBytes / sizeof(t_DataType), 0);
+            Results<t_DataType> l_res;
+            l_res.m_x = l_vec.h_xk;
+            l_res.m_nIters = 0;
+            l_res.m_residual = 0;
+            m_history.clear();
+            m_firstCall = false;
+            return l_res;
+        }
+        // an initial guess that meets the tolerance gives r0 = 0, the first alpha of the kernels would be 0 / 0
+        if (m_genCgVec.getRr() <= p_tol * p_tol * m_genCgVec.getDot()) {
+            Results<t_DataType> l_res;
+            l_res.m_x = m_genCgVec.getVec().h_xk;
+            l_res.m_nIters = 0;
+            l_res.m_residual = m_genCgVec.getRr();
+            m_history.clear();
+            m_firstCall = false;
+            return l_res;
+        }
         this->setInstr(p_maxIter + 1, p_tol);
-        bool l_run = m_host.run();
+        bool l_run = m_useCpu ? m_cpu.run() : m_host.run();
         if (l_run == false) {
             throw CgInternalError("Run kernel failed.");
         }
@@ -169,6 +393,9 @@ class PCGImpl {
         l_res.m_residual = 0;
 
         CgInstr l_instr = m_genInstr.getInstrPtr();
+        const t_DataType l_dot = m_genCgVec.getDot();
+        uint64_t l_clock = 0;
+        m_history.clear();
         for (unsigned int i = 0; i <= p_maxIter; i++) {
             l_res.m_nIters = i;
             l_cgInstr.load((uint8_t*)(l_instr.h_instr) + (i + 1) * t_InstrBytes, l_memInstr);
@@ -177,13 +404,31 @@ class PCGImpl {
                 break;
             }
             l_res.m_residual = l_cgInstr.getRes();
+            // the clock of a record counts the cycles from the start of the kernels
+            XJPCG_Iteration_t l_iter;
+            l_iter.m_residual = std::sqrt(l_cgInstr.getRes() / l_dot);
+            l_iter.m_alpha = l_cgInstr.getAlpha();
+            l_iter.m_beta = l_cgInstr.getBeta();
+            l_iter.m_rz = l_cgInstr.getRZ();
+            l_iter.m_cycles = l_cgInstr.getClock() - std::min(l_clock, l_cgInstr.getClock());
+            l_clock = l_cgInstr.getClock();
+            m_history.push_back(l_iter);
         }
         m_firstCall = false;
         return l_res;
     }
 
-    std::vector<uint32_t> getMatInfo() {
-        std::vector<uint32_t> l_info(6);
+    // copy the solution of run() to p_x in the caller's numbering
+    void copyX(const uint32_t p_dim, const Results<t_DataType>& p_res, t_DataType* p_x) const {
+        if (m_stencilOp != nullptr) {
+            std::copy((const t_DataType*)p_res.m_x, (const t_DataType*)p_res.m_x + p_dim, p_x);
+        } else {
+            m_spmPar.unpermuteVec(false, p_dim, (const t_DataType*)p_res.m_x, p_x);
+        }
+    }
+
+    std::vector<uint64_t> getMatInfo() {
+        std::vector<uint64_t> l_info(6);
         l_info[0] = m_matPar.m_m;
         l_info[1] = m_matPar.m_n;
         l_info[2] = m_matPar.m_nnz;
@@ -194,23 +439,48 @@ class PCGImpl {
     }
     xf::sparse::MatPartition getMatPar() { return m_matPar; }
     t_DataType getDot() { return m_genCgVec.getDot(); }
+    // |r| / |b| of a run() result, 0 for b = 0 as run() returns the exact x = 0
+    t_DataType getRelRes(const Results<t_DataType>& p_res) {
+        const t_DataType l_dot = m_genCgVec.getDot();
+        return (l_dot == 0) ? 0 : std::sqrt(p_res.m_residual / l_dot);
+    }
     t_DataType getRz() { return m_genCgVec.getRz(); }
     CgVector getVec() { return m_genCgVec.getVec(); }
 
     CgVector getRes() {
-        m_host.getDat();
-        m_host.finish();
+        if (m_useCpu) {
+            m_cpu.getDat();
+            m_cpu.finish();
+        } else {
+            m_host.getDat();
+            m_host.finish();
+        }
         return m_genCgVec.getVec();
     }
 
-    void sendVec() {
+    // p_full sends all vectors and binds them to the kernels, otherwise only p0, r0, x0 and a changed jacobi are sent
+    void sendVec(bool p_full = true) {
         CgVector l_cgVec = m_genCgVec.getVec();
-        bool l_send = m_host.sendVecDat(l_cgVec.h_pk, l_cgVec.vecBytes, l_cgVec.h_Apk, l_cgVec.vecBytes, l_cgVec.h_zk,
-                                        l_cgVec.vecBytes, l_cgVec.h_rk, l_cgVec.vecBytes, l_cgVec.h_jacobi,
-                                        l_cgVec.vecBytes, l_cgVec.h_xk, l_cgVec.vecBytes);
+        bool l_send = false;
+        if (p_full) {
+            l_send = m_useCpu
+                              ? m_cpu.sendVecDat(l_cgVec.h_pk, l_cgVec.vecBytes, l_cgVec.h_Apk, l_cgVec.vecBytes,
+                                                 l_cgVec.h_zk, l_cgVec.vecBytes, l_cgVec.h_rk, l_cgVec.vecBytes,
+                                                 l_cgVec.h_jacobi, l_cgVec.vecBytes, l_cgVec.h_xk, l_cgVec.vecBytes)
+                              : m_host.sendVecDat(l_cgVec.h_pk, l_cgVec.vecBytes, l_cgVec.h_Apk, l_cgVec.vecBytes,
+                                                  l_cgVec.h_zk, l_cgVec.vecBytes, l_cgVec.h_rk, l_cgVec.vecBytes,
+                                                  l_cgVec.h_jacobi, l_cgVec.vecBytes, l_cgVec.h_xk, l_cgVec.vecBytes);
+        } else {
+            void* l_jacobi = m_genCgVec.isJacobiChanged() ? l_cgVec.h_jacobi : nullptr;
+            l_send = m_useCpu ? m_cpu.updateVecDat(l_cgVec.h_pk, l_cgVec.vecBytes, l_cgVec.h_rk, l_cgVec.vecBytes,
+                                                   l_cgVec.h_xk, l_cgVec.vecBytes, l_jacobi, l_cgVec.vecBytes)
+                              : m_host.updateVecDat(l_cgVec.h_pk, l_cgVec.vecBytes, l_cgVec.h_rk, l_cgVec.vecBytes,
+                                                    l_cgVec.h_xk, l_cgVec.vecBytes, l_jacobi, l_cgVec.vecBytes);
+        }
         if (l_send == false) {
             throw CgAllocFailed("Send vector data failed.");
         }
+        m_genCgVec.setJacobiSent();
     }
     void setInstr(unsigned int p_maxIter, t_DataType p_tol) {
         t_DataType l_dot = m_genCgVec.getDot();
@@ -218,7 +488,8 @@ class PCGImpl {
         m_genInstr.setInstr(p_maxIter, m_genCgVec.getDimAligned(), l_dot, p_tol, l_rz);
         m_genInstr.updateInstr();
         CgInstr l_cgInstr = m_genInstr.getInstrPtr();
-        bool l_send = m_host.sendInstr(l_cgInstr.h_instr, l_cgInstr.h_instrBytes);
+        bool l_send = m_useCpu ? m_cpu.sendInstr(l_cgInstr.h_instr, l_cgInstr.h_instrBytes)
+                               : m_host.sendInstr(l_cgInstr.h_instr, l_cgInstr.h_instrBytes);
         if (l_send == false) {
             throw CgAllocFailed("Send Instruction data failed.");
         }
@@ -226,6 +497,8 @@ class PCGImpl {
 
     XJPCG_Metric_t* getMetrics() { return &m_Metrics; }
     const XJPCG_Metric_t* getMetrics() const { return &m_Metrics; }
+    // one entry per iteration of the last run
+    const std::vector<XJPCG_Iteration_t>& getHistory() const { return m_history; }
 
     XJPCG_Status_t setStatusMessage(XJPCG_Status_t p_stat, const std::string p_str) const {
         m_lastStatus = p_stat;
@@ -239,6 +512,31 @@ class PCGImpl {
     bool isFirstCall() const { return m_firstCall; }
 
    private:
+    // the operator keeps a pointer to the coefficients, so the cpu backend gets one over a copy of them
+    void sendStencil(const StencilOp<t_DataType>& p_op) {
+        m_stencilCoefs.assign(p_op.getCoefs(), p_op.getCoefs() + p_op.getNumCoefs());
+        std::array<uint32_t, 4> l_shape = p_op.getShape();
+        m_stencilOp.reset(new StencilOp<t_DataType>(l_shape[3], l_shape[0], l_shape[1], l_shape[2],
+                                                    m_stencilCoefs.data(), p_op.isPerCell()));
+        m_cpu.sendStencil(m_stencilOp.get());
+    }
+    void clearStencil() {
+        if (m_stencilOp != nullptr) {
+            m_cpu.sendStencil(nullptr);
+            m_stencilOp.reset();
+            m_stencilCoefs.clear();
+        }
+        m_stencilShape.fill(0);
+        m_stencilDiag.clear();
+    }
+    bool sendMatDat() {
+        if (m_useCpu) {
+            return m_cpu.sendMatDat(m_matPar);
+        }
+        return m_host.sendMatDat(m_matPar.m_nnzValPtr, m_matPar.m_nnzValSize, m_matPar.m_rbParamPtr,
+                                 m_matPar.m_rbParamSize, m_matPar.m_parParamPtr, m_matPar.m_parParamSize);
+    }
+
     mutable XJPCG_Status_t m_lastStatus;
     mutable std::string m_lastMessage;
     bool m_firstCall = true;
@@ -248,8 +546,21 @@ class PCGImpl {
     GenCgVector<t_DataType, t_ParEntries> m_genCgVec;
     GenCgInstr<t_DataType, t_InstrBytes> m_genInstr;
     xCgHost m_host;
+    xCgCpu<t_DataType, t_ParEntries, t_InstrBytes> m_cpu;
+    bool m_useCpu = false;
     xf::sparse::MatPartition m_matPar;
+    std::string m_sigCacheDir;
+    std::string m_cacheWarning;
+    std::vector<t_DataType> m_bPerm, m_diagAPerm;
+    std::array<uint32_t, 4> m_stencilShape{{0, 0, 0, 0}};
+    std::vector<t_DataType> m_stencilDiag;
+    // set on the cpu backend only, the matrix-free operator of the last stencil matrix
+    std::unique_ptr<StencilOp<t_DataType> > m_stencilOp;
+    std::vector<t_DataType> m_stencilCoefs;
+    std::vector<uint64_t> m_batchShape;
+    std::vector<t_DataType> m_batchB, m_batchDiagA, m_batchNorms;
     XJPCG_Metric_t m_Metrics;
+    std::vector<XJPCG_Iteration_t> m_history;
 };
 }
 }
@@ -66,6 +66,17 @@ typedef struct {
     double m_solver;  /// Solver execution time
 } XJPCG_Metric_t;
 
+/**
+ * @brief Define the XJPCG record of one solver iteration
+ */
+typedef struct {
+    double m_residual; /// Relative residual |r| / |b| after the iteration
+    double m_alpha;    /// Step length of the iteration
+    double m_beta;     /// Update factor of the search direction
+    double m_rz;       /// Product r' * z of the residual and the preconditioned residual
+    uint64_t m_cycles; /// Device clock cycles spent in the iteration, 0 for the "cpu" handle
+} XJPCG_Iteration_t;
+
 struct XJPCG_ObjectStruct; /// dummy struct for XJPCG object type safety
 
 /**
@@ -81,13 +92,27 @@ typedef enum XJPCG_Mode_t {
     XJPCG_MODE_KEEP_NZ_LAYOUT = 0x01, /// Update matrix values only
     XJPCG_MODE_KEEP_MATRIX = 0x02,    /// Reuse last matrix
     XJPCG_MODE_C_INDEX = 0x00,        /// Default C-Type index, starting from 0
-    XJPCG_MODE_FORTRAN_INDEX = 0x10   /// Fortran-Type index, starting from 1
+    XJPCG_MODE_FORTRAN_INDEX = 0x10,  /// Fortran-Type index, starting from 1
+    XJPCG_MODE_WARM_START = 0x20      /// Start from the values of p_x instead of 0
 } XJPCG_Mode_t;
 
+typedef enum XJPCG_Reorder_t {
+    XJPCG_REORDER_NONE = 0, /// Keep the row and col numbering of the matrix
+    XJPCG_REORDER_RCM = 1   /// Reverse Cuthill-McKee bandwidth reduction
+} XJPCG_Reorder_t;
+
+/**
+ * @brief List of stencils supported by xJPCG_stencilSolver
+ */
+typedef enum XJPCG_Stencil_t {
+    XJPCG_STENCIL_7PT = 7,  /// center and the -x, +x, -y, +y, -z, +z neighbours of a cell
+    XJPCG_STENCIL_27PT = 27 /// the 3x3x3 box around a cell, ordered by (dz, dy, dx), x fastest
+} XJPCG_Stencil_t;
+
 /**
  * @brief xJPCG_createHandle create a JPCG handle
  * @param handle a pointer to the JPCG handle variable that will receive the PCG handle
- * @param xclbinPath the path to xclbin file
+ * @param xclbinPath the path to xclbin file, or "cpu" to run the solver on the host without an Alveo card
  * @return API status
  * If the initialization fails, `*handle` may remain unchanged from its original value.
  */
@@ -123,8 +148,9 @@ XJPCG_Status_t xJPCG_destroyHandle(XJPCG_Handle_t* handle);
  * might get the solver to produce correct results.
  *
  * @param handle pointer to a JPCG handle
- * @param p_n dimension of given matrix and vectors
- * @param p_nnz number of none-zero entries in p_data of sparse matrix A
+ * @param p_n dimension of given matrix and vectors, at most 2^32 - 1
+ * @param p_nnz number of none-zero entries in p_data of sparse matrix A, the total number of none-zero entries of A
+ * may exceed 2^32
  *
  *     When using this API, only upper or lower triangular part and the main diagonal entries of the matrix A are
  * stored.
@@ -145,7 +171,7 @@ XJPCG_Status_t xJPCG_destroyHandle(XJPCG_Handle_t* handle);
  * @param p_data data entries of matrix A, half matrix for symmetry
  * @param p_diagA diagnal vector of matrix A
  * @param p_b right-hand side vector
- * @param p_x solution to the equation
+ * @param p_x solution to the equation, and the initial guess with `XJPCG_MODE_WARM_START`
  * @param p_maxIter maximum number of iteration that solver could run
  * @param p_tol the relative tolerence for solver to stop iteration
  * @param p_iter the real iterations that solver takes
@@ -157,6 +183,8 @@ XJPCG_Status_t xJPCG_destroyHandle(XJPCG_Handle_t* handle);
  *     For example, setting `mode` with `XJPCG_MODE_DEFAULT | XJPCG_MODE_FORTRAN_INDEX`
  *     means the matrix A will not be re-used to solve this system, and the matrix storage follows
  *     the convention in Fortran, namely indices start from 1.
+ *     Adding `XJPCG_MODE_WARM_START` takes the values of `p_x` as the initial guess x0, the solver then starts from
+ *     the residual b - A * x0, which is computed on the host. The relative residual stays relative to |b|.
  *
  * @return API status
  */
@@ -189,7 +217,7 @@ XJPCG_Status_t xJPCG_cscSymSolver(XJPCG_Handle_t* handle,
  * @param p_data data entries of matrix A, full matrix
  * @param p_diagA diagnal vector of matrix A
  * @param p_b right-hand side vector
- * @param p_x solution to the equation
+ * @param p_x solution to the equation, and the initial guess with `XJPCG_MODE_WARM_START`
  * @param p_maxIter maximum number of iteration that solve could run
  * @param p_tol the relative tolerence for solver to stop iteration
  * @param p_iter the real iterations that solver takes
@@ -214,6 +242,126 @@ XJPCG_Status_t xJPCG_cooSolver(XJPCG_Handle_t* handle,
                                double* p_res,
                                const XJPCG_Mode_t mode);
 
+/** @brief xJPCG_stencilSolver solves equation Ax = b where A is given by a stencil on a regular 3D grid
+ *
+ * Cell (x, y, z) of the `p_nx` x `p_ny` x `p_nz` grid is row x + p_nx * (y + p_ny * z) of A, neighbours outside the
+ * grid are dropped. The caller doesn't store the matrix, the diagonal of A is the center coefficient.
+ *
+ * @see xJPCG_cscSymSolver for the convergency issues and solutions to the mismatching results when using this API
+ *
+ * @param handle pointer to a JPCG handle
+ * @param p_stencil the stencil points, see XJPCG_Stencil_t for the order of the coefficients
+ * @param p_nx grid size along x
+ * @param p_ny grid size along y
+ * @param p_nz grid size along z
+ * @param p_coefs the stencil coefficients, `p_stencil` values shared by all cells, or `p_stencil` values for each
+ * cell when `p_perCell` is not 0. The stencil must be symmetric, the coefficient of a cell towards a neighbour equals
+ * the one of the neighbour back to the cell, and the center coefficients must be positive.
+ * @param p_perCell 0 for coefficients shared by all cells, 1 for coefficients of each cell
+ * @param p_b right-hand side vector
+ * @param p_x solution to the equation, and the initial guess with `XJPCG_MODE_WARM_START`
+ * @param p_maxIter maximum number of iteration that solve could run
+ * @param p_tol the relative tolerence for solver to stop iteration
+ * @param p_iter the real iterations that solver takes
+ * @param p_res the relative residual when solver exits
+ * @param mode solver modes for data reuse, `XJPCG_MODE_KEEP_NZ_LAYOUT` takes new coefficients for the grid and stencil
+ * of the last call
+ *
+ * @return API status
+ */
+XILINX_PCG_LINKAGE_DECL
+XJPCG_Status_t xJPCG_stencilSolver(XJPCG_Handle_t* handle,
+                                   const XJPCG_Stencil_t p_stencil,
+                                   const uint32_t p_nx,
+                                   const uint32_t p_ny,
+                                   const uint32_t p_nz,
+                                   const double* p_coefs,
+                                   const int p_perCell,
+                                   const double* p_b,
+                                   const double* p_x,
+                                   const uint32_t p_maxIter,
+                                   const double p_tol,
+                                   uint32_t* p_iter,
+                                   double* p_res,
+                                   const XJPCG_Mode_t mode);
+
+/** @brief xJPCG_cooSolverBatch solves `p_numSys` independent equations A_i x_i = b_i with sparse SPD matrices in
+ * COO format in one kernel launch
+ *
+ * The systems are packed into one block-diagonal system on the host. Each right-hand side is scaled to unit norm
+ * before packing and the packed system is solved to `p_tol` / sqrt(`p_numSys`), which bounds the relative residual of
+ * every system by `p_tol`. All systems run the same number of iterations, and a well-conditioned system keeps
+ * iterating until the whole batch has converged.
+ *
+ * @see xJPCG_cooSolver for the parameters of each system
+ *
+ * @param handle pointer to a JPCG handle
+ * @param p_numSys number of systems
+ * @param p_n `p_numSys` dimensions
+ * @param p_nnz `p_numSys` numbers of non-zero entries
+ * @param p_rowIdx `p_numSys` row index arrays
+ * @param p_colIdx `p_numSys` col index arrays
+ * @param p_data `p_numSys` data arrays, full matrices
+ * @param p_diagA `p_numSys` diagnal vectors
+ * @param p_b `p_numSys` right-hand side vectors, none of them may be zero
+ * @param p_x `p_numSys` solution vectors, and the initial guesses with `XJPCG_MODE_WARM_START`
+ * @param p_maxIter maximum number of iteration that solve could run
+ * @param p_tol the relative tolerence of each system
+ * @param p_iter `p_numSys` iterations that solver takes
+ * @param p_res `p_numSys` relative residuals when solver exits
+ * @param mode solver modes including date reuse and index type, `XJPCG_MODE_KEEP_NZ_LAYOUT` takes new values for the
+ * systems of the last call
+ *
+ * @return API status
+ */
+XILINX_PCG_LINKAGE_DECL
+XJPCG_Status_t xJPCG_cooSolverBatch(XJPCG_Handle_t* handle,
+                                    const uint32_t p_numSys,
+                                    const uint32_t* p_n,
+                                    const uint32_t* p_nnz,
+                                    const uint32_t* const* p_rowIdx,
+                                    const uint32_t* const* p_colIdx,
+                                    const double* const* p_data,
+                                    const double* const* p_diagA,
+                                    const double* const* p_b,
+                                    double* const* p_x,
+                                    const uint32_t p_maxIter,
+                                    const double p_tol,
+                                    uint32_t* p_iter,
+                                    double* p_res,
+                                    const XJPCG_Mode_t mode);
+
+/** @brief xJPCG_setSignatureCacheDir enables the on-disk matrix signature cache of a JPCG handle
+ *
+ * When the cache is enabled, solver calls with `XJPCG_MODE_DEFAULT` look up the partitioned matrix layout in
+ * `cacheDir` by a hash of the sparsity pattern. On a hit the matrix partitioning is skipped and only the matrix
+ * values are updated, on a miss the matrix is partitioned and its layout is stored in `cacheDir`, so that later
+ * processes solving matrices with the same sparsity pattern can reuse it. Damaged cache files are ignored, a cache
+ * file that is ignored or can't be written doesn't fail the solve and is reported by xJPCG_getLastMessage.
+ *
+ * @param handle JPCG handle
+ * @param cacheDir an existing directory for the cache files, nullptr or an empty string disables the cache
+ *
+ * @return API status
+ */
+XILINX_PCG_LINKAGE_DECL
+XJPCG_Status_t xJPCG_setSignatureCacheDir(XJPCG_Handle_t* handle, const char* cacheDir);
+
+/** @brief xJPCG_setReorder selects the symmetric reordering applied to the matrix before partitioning
+ *
+ * Solver calls with `XJPCG_MODE_DEFAULT` renumber the rows and cols of the matrix with the selected ordering,
+ * which reduces the number of column partitions per row block for matrices with a scrambled numbering.
+ * `p_b` and `p_diagA` are permuted in and `p_x` is permuted out by the solvers, so the reordering is
+ * transparent to the caller. The reordering is kept by calls with `XJPCG_MODE_KEEP_NZ_LAYOUT`.
+ *
+ * @param handle JPCG handle
+ * @param reorder the reordering, XJPCG_REORDER_NONE by default
+ *
+ * @return API status
+ */
+XILINX_PCG_LINKAGE_DECL
+XJPCG_Status_t xJPCG_setReorder(XJPCG_Handle_t* handle, const XJPCG_Reorder_t reorder);
+
 /** @brief xJPCG_peekAtLastStatus get the last status associated with handle
  *
  * @param handle JPCG handle
@@ -253,6 +401,27 @@ const char* xJPCG_getLastMessage(const XJPCG_Handle_t* handle);
 XILINX_PCG_LINKAGE_DECL
 XJPCG_Status_t xJPCG_getMetrics(const XJPCG_Handle_t* handle, XJPCG_Metric_t* metric);
 
+/** @brief xJPCG_getConvergenceHistory get the iterations of the last solver call associated with handle
+ *
+ * The records are written by the device during the solve, so the history costs no extra run. The cycles of the
+ * first iteration include the start of the kernels. For `xJPCG_cooSolverBatch` the residuals are those of the
+ * packed system, whose right-hand sides are scaled to unit norm. Calling the function with `maxEntries` 0 and a
+ * null `history` returns the number of entries only.
+ *
+ * @param handle JPCG handle
+ * @param history array of at least maxEntries records, receives the first maxEntries iterations
+ * @param maxEntries size of history
+ * @param numEntries receives the number of iterations of the last solver call
+ *
+ * @return API status
+ *
+ */
+XILINX_PCG_LINKAGE_DECL
+XJPCG_Status_t xJPCG_getConvergenceHistory(const XJPCG_Handle_t* handle,
+                                           XJPCG_Iteration_t* history,
+                                           const uint32_t maxEntries,
+                                           uint32_t* numEntries);
+
 #ifdef __cplusplus
 }
 #endif
@@ -440,6 +440,40 @@ bool xCgHost::sendVecDat(void* p_pk,
         return false;
     }
 }
+bool xCgHost::updateVecDat(void* p_pk,
+                           unsigned int p_pkSize,
+                           void* p_rk,
+                           unsigned int p_rkSize,
+                           void* p_xk,
+                           unsigned int p_xkSize,
+                           void* p_jacobi,
+                           unsigned int p_jacobiSize) {
+    // Apk and zk are written by the kernels before they are read, their buffers stay as they are
+    bool l_err = true;
+    bool l_each_err = true;
+    std::vector<cl::Memory> l_buffers;
+    l_buffers.push_back(m_card.createDeviceBuffer(CL_MEM_READ_WRITE, p_pk, p_pkSize, &l_each_err));
+    l_err = l_err && l_each_err;
+    l_buffers.push_back(m_card.createDeviceBuffer(CL_MEM_READ_WRITE, p_rk, p_rkSize, &l_each_err));
+    l_err = l_err && l_each_err;
+    l_buffers.push_back(m_card.createDeviceBuffer(CL_MEM_READ_WRITE, p_xk, p_xkSize, &l_each_err));
+    l_err = l_err && l_each_err;
+    if (p_jacobi != nullptr) {
+        l_buffers.push_back(m_card.createDeviceBuffer(CL_MEM_READ_ONLY, p_jacobi, p_jacobiSize, &l_each_err));
+        l_err = l_err && l_each_err;
+    }
+    if (l_err == false) {
+        return false;
+    }
+    // the queue is out of order and the kernels only wait for their own transfers, so the upload completes here
+    cl::Event l_event;
+    cl_int err = m_card.getCommandQueue().enqueueMigrateMemObjects(l_buffers, 0, nullptr, &l_event);
+    if (err != CL_SUCCESS) {
+        return false;
+    }
+    l_event.wait();
+    return true;
+}
 bool xCgHost::sendInstr(void* p_instr, unsigned int p_instrSize) {
     bool l_err = m_krnCtl.setMem(p_instr, p_instrSize);
     return l_err;
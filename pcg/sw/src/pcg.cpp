@@ -27,6 +27,15 @@ double getDuration(std::chrono::time_point<std::chrono::high_resolution_clock>&
     last = std::chrono::high_resolution_clock::now();
     return duration.count();
 }
+// a signature cache file that can't be used doesn't fail the solve, its warning goes to the last message of the call
+// that set the matrix
+std::string getSolvedMessage(const PcgImpl* pImpl, const XJPCG_Mode_t mode) {
+    std::string l_msg = "Solver returns successfully";
+    if (((mode & 0x0f) == XJPCG_MODE_DEFAULT) && !pImpl->getCacheWarning().empty()) {
+        l_msg += ", WARNING: " + pImpl->getCacheWarning();
+    }
+    return l_msg;
+}
 }
 
 extern "C" {
@@ -75,17 +84,24 @@ XJPCG_Status_t xJPCG_cscSymSolver(XJPCG_Handle_t* handle,
     if (handle == nullptr) return XJPCG_STATUS_NOT_INITIALIZED;
     auto pImpl = reinterpret_cast<PcgImpl*>(handle);
     try {
+        // the kernels use 32-bit row and col indices, the nnzs are only limited by the host memory
+        if (p_n <= 0 || p_n > UINT32_MAX) {
+            throw xilinx_apps::pcg::CgInvalidValue("Wrong dimension size.");
+        }
+        if (p_nnz < p_n) {
+            throw xilinx_apps::pcg::CgInvalidValue("Wrong non-zero element size.");
+        }
         auto last = std::chrono::high_resolution_clock::now();
         bool first = pImpl->isFirstCall();
         switch (mode & 0x0f) {
             case XJPCG_MODE_DEFAULT:
-                pImpl->setCscSymMat(p_n, p_nnz, p_rowIdx, p_colPtr, p_data, (mode & 0xf0) >> 4);
+                pImpl->setCscSymMat(p_n, p_nnz, p_rowIdx, p_colPtr, p_data, (mode & XJPCG_MODE_FORTRAN_INDEX) >> 4);
                 break;
             case XJPCG_MODE_KEEP_NZ_LAYOUT:
                 if (first)
                     throw xilinx_apps::pcg::CgInvalidValue(
                         "wrong solver mode for the first call, please use XJPCG_MODEL_DEFAULT.");
-                pImpl->updateCscSymMat(p_n, p_nnz, p_rowIdx, p_colPtr, p_data, (mode & 0xf0) >> 4);
+                pImpl->updateCscSymMat(p_n, p_nnz, p_rowIdx, p_colPtr, p_data, (mode & XJPCG_MODE_FORTRAN_INDEX) >> 4);
                 break;
             default:
                 if (first)
@@ -95,15 +111,15 @@ XJPCG_Status_t xJPCG_cscSymSolver(XJPCG_Handle_t* handle,
         }
 
         pImpl->getMetrics()->m_matProc = getDuration(last);
-        pImpl->setVec(p_n, p_b, p_diagA);
+        pImpl->setVec(p_n, p_b, p_diagA, (mode & XJPCG_MODE_WARM_START) ? p_x : nullptr);
         pImpl->getMetrics()->m_vecProc = getDuration(last);
 
         xilinx_apps::pcg::Results<double> l_res = pImpl->run(p_maxIter, p_tol);
-        *p_res = std::sqrt(l_res.m_residual / pImpl->getDot());
+        *p_res = pImpl->getRelRes(l_res);
         *p_iter = l_res.m_nIters;
-        memcpy((char*)p_x, (char*)l_res.m_x, sizeof(double) * p_n);
+        pImpl->copyX(p_n, l_res, (double*)p_x);
         pImpl->getMetrics()->m_solver = getDuration(last);
-        if (*p_res > p_tol) {
+        if (!(*p_res <= p_tol)) {
             throw xilinx_apps::pcg::CgExecutionFailed("exit with divergent solution after " + std::to_string(*p_iter) +
                                                       " iterations.");
         }
@@ -112,7 +128,7 @@ XJPCG_Status_t xJPCG_cscSymSolver(XJPCG_Handle_t* handle,
     } catch (const std::exception& err) {
         return pImpl->setStatusMessage(XJPCG_STATUS_INTERNAL_ERROR, err.what());
     }
-    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, "Solver returns successfully");
+    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, getSolvedMessage(pImpl, mode));
 }
 
 XJPCG_Status_t xJPCG_cooSolver(XJPCG_Handle_t* handle,
@@ -136,7 +152,7 @@ XJPCG_Status_t xJPCG_cooSolver(XJPCG_Handle_t* handle,
         bool first = pImpl->isFirstCall();
         switch (mode & 0x0f) {
             case XJPCG_MODE_DEFAULT:
-                pImpl->setCooMat(p_n, p_nnz, p_rowIdx, p_colIdx, p_data, (mode & 0xf0) >> 4);
+                pImpl->setCooMat(p_n, p_nnz, p_rowIdx, p_colIdx, p_data, (mode & XJPCG_MODE_FORTRAN_INDEX) >> 4);
                 break;
             case XJPCG_MODE_KEEP_NZ_LAYOUT:
                 if (first)
@@ -152,15 +168,81 @@ XJPCG_Status_t xJPCG_cooSolver(XJPCG_Handle_t* handle,
         }
 
         pImpl->getMetrics()->m_matProc = getDuration(last);
-        pImpl->setVec(p_n, b, matJ);
+        pImpl->setVec(p_n, b, matJ, (mode & XJPCG_MODE_WARM_START) ? x : nullptr);
+        pImpl->getMetrics()->m_vecProc = getDuration(last);
+
+        xilinx_apps::pcg::Results<double> l_res = pImpl->run(p_maxIter, p_tol);
+        *p_res = pImpl->getRelRes(l_res);
+        *p_iter = l_res.m_nIters;
+        pImpl->copyX(p_n, l_res, (double*)x);
+        pImpl->getMetrics()->m_solver = getDuration(last);
+        if (!(*p_res <= p_tol)) {
+            throw xilinx_apps::pcg::CgExecutionFailed("exit with divergent solution after " + std::to_string(*p_iter) +
+                                                      " iterations.");
+        }
+    } catch (const xilinx_apps::pcg::CgException& err) {
+        return pImpl->setStatusMessage(err.getStatus(), err.what());
+    } catch (const std::exception& err) {
+        return pImpl->setStatusMessage(XJPCG_STATUS_INTERNAL_ERROR, err.what());
+    }
+    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, getSolvedMessage(pImpl, mode));
+}
+
+XJPCG_Status_t xJPCG_stencilSolver(XJPCG_Handle_t* handle,
+                                   const XJPCG_Stencil_t p_stencil,
+                                   const uint32_t p_nx,
+                                   const uint32_t p_ny,
+                                   const uint32_t p_nz,
+                                   const double* p_coefs,
+                                   const int p_perCell,
+                                   const double* b,
+                                   const double* x,
+                                   const uint32_t p_maxIter,
+                                   const double p_tol,
+                                   uint32_t* p_iter,
+                                   double* p_res,
+                                   const XJPCG_Mode_t mode) {
+    if (handle == nullptr) return XJPCG_STATUS_NOT_INITIALIZED;
+    auto pImpl = reinterpret_cast<PcgImpl*>(handle);
+    try {
+        // the grid size is checked in 64 bits, as it's narrowed to the 32-bit dimension of the vectors
+        const uint64_t l_dim = (uint64_t)p_nx * p_ny * p_nz;
+        if (l_dim == 0 || l_dim > UINT32_MAX) {
+            throw xilinx_apps::pcg::CgInvalidValue("Wrong stencil grid size.");
+        }
+        const uint32_t l_n = l_dim;
+        auto last = std::chrono::high_resolution_clock::now();
+        bool first = pImpl->isFirstCall();
+        switch (mode & 0x0f) {
+            case XJPCG_MODE_DEFAULT:
+                pImpl->setStencilMat(
+                    xilinx_apps::pcg::StencilOp<double>(p_stencil, p_nx, p_ny, p_nz, p_coefs, p_perCell != 0));
+                break;
+            case XJPCG_MODE_KEEP_NZ_LAYOUT:
+                if (first)
+                    throw xilinx_apps::pcg::CgInvalidValue(
+                        "wrong solver mode for the first call, please use XJPCG_MODEL_DEFAULT.");
+                pImpl->updateStencilMat(
+                    xilinx_apps::pcg::StencilOp<double>(p_stencil, p_nx, p_ny, p_nz, p_coefs, p_perCell != 0));
+                break;
+            default:
+                if (first)
+                    throw xilinx_apps::pcg::CgInvalidValue(
+                        "wrong solver mode for the first call, please use XJPCG_MODEL_DEFAULT.");
+                pImpl->checkStencilShape({{p_nx, p_ny, p_nz, (uint32_t)p_stencil}});
+                break;
+        }
+
+        pImpl->getMetrics()->m_matProc = getDuration(last);
+        pImpl->setVec(l_n, b, pImpl->getStencilDiag(), (mode & XJPCG_MODE_WARM_START) ? x : nullptr);
         pImpl->getMetrics()->m_vecProc = getDuration(last);
 
         xilinx_apps::pcg::Results<double> l_res = pImpl->run(p_maxIter, p_tol);
-        *p_res = std::sqrt(l_res.m_residual / pImpl->getDot());
+        *p_res = pImpl->getRelRes(l_res);
         *p_iter = l_res.m_nIters;
-        memcpy((char*)x, (char*)l_res.m_x, sizeof(double) * p_n);
+        pImpl->copyX(l_n, l_res, (double*)x);
         pImpl->getMetrics()->m_solver = getDuration(last);
-        if (*p_res > p_tol) {
+        if (!(*p_res <= p_tol)) {
             throw xilinx_apps::pcg::CgExecutionFailed("exit with divergent solution after " + std::to_string(*p_iter) +
                                                       " iterations.");
         }
@@ -169,7 +251,110 @@ XJPCG_Status_t xJPCG_cooSolver(XJPCG_Handle_t* handle,
     } catch (const std::exception& err) {
         return pImpl->setStatusMessage(XJPCG_STATUS_INTERNAL_ERROR, err.what());
     }
-    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, "Solver returns successfully");
+    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, getSolvedMessage(pImpl, mode));
+}
+
+XJPCG_Status_t xJPCG_cooSolverBatch(XJPCG_Handle_t* handle,
+                                    const uint32_t p_numSys,
+                                    const uint32_t* p_n,
+                                    const uint32_t* p_nnz,
+                                    const uint32_t* const* p_rowIdx,
+                                    const uint32_t* const* p_colIdx,
+                                    const double* const* p_data,
+                                    const double* const* matJ,
+                                    const double* const* b,
+                                    double* const* x,
+                                    const uint32_t p_maxIter,
+                                    const double p_tol,
+                                    uint32_t* p_iter,
+                                    double* p_res,
+                                    const XJPCG_Mode_t mode) {
+    if (handle == nullptr) return XJPCG_STATUS_NOT_INITIALIZED;
+    auto pImpl = reinterpret_cast<PcgImpl*>(handle);
+    try {
+        if (p_iter == nullptr || p_res == nullptr) {
+            throw xilinx_apps::pcg::CgInvalidValue("Iterations or residuals are nullptr.");
+        }
+        xilinx_apps::pcg::CooBatch<double> l_batch(p_numSys, p_n, p_nnz, p_rowIdx, p_colIdx, p_data,
+                                                   (mode & XJPCG_MODE_FORTRAN_INDEX) >> 4);
+        auto last = std::chrono::high_resolution_clock::now();
+        bool first = pImpl->isFirstCall();
+        switch (mode & 0x0f) {
+            case XJPCG_MODE_DEFAULT:
+                pImpl->setBatchMat(l_batch);
+                break;
+            case XJPCG_MODE_KEEP_NZ_LAYOUT:
+                if (first)
+                    throw xilinx_apps::pcg::CgInvalidValue(
+                        "wrong solver mode for the first call, please use XJPCG_MODEL_DEFAULT.");
+                pImpl->updateBatchMat(l_batch);
+                break;
+            default:
+                if (first)
+                    throw xilinx_apps::pcg::CgInvalidValue(
+                        "wrong solver mode for the first call, please use XJPCG_MODEL_DEFAULT.");
+                break;
+        }
+
+        pImpl->getMetrics()->m_matProc = getDuration(last);
+        pImpl->setBatchVec(l_batch, b, matJ, (mode & XJPCG_MODE_WARM_START) ? x : nullptr);
+        pImpl->getMetrics()->m_vecProc = getDuration(last);
+
+        xilinx_apps::pcg::Results<double> l_res = pImpl->runBatch(l_batch, p_maxIter, p_tol, x, p_res);
+        uint32_t l_failed = 0;
+        for (uint32_t i = 0; i < p_numSys; ++i) {
+            p_iter[i] = l_res.m_nIters;
+            if (!(p_res[i] <= p_tol)) {
+                l_failed++;
+            }
+        }
+        pImpl->getMetrics()->m_solver = getDuration(last);
+        if (l_failed != 0) {
+            throw xilinx_apps::pcg::CgExecutionFailed(std::to_string(l_failed) + " of " + std::to_string(p_numSys) +
+                                                      " systems exit with divergent solutions after " +
+                                                      std::to_string(l_res.m_nIters) + " iterations.");
+        }
+    } catch (const xilinx_apps::pcg::CgException& err) {
+        return pImpl->setStatusMessage(err.getStatus(), err.what());
+    } catch (const std::exception& err) {
+        return pImpl->setStatusMessage(XJPCG_STATUS_INTERNAL_ERROR, err.what());
+    }
+    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, getSolvedMessage(pImpl, mode));
+}
+
+XJPCG_Status_t xJPCG_setSignatureCacheDir(XJPCG_Handle_t* handle, const char* cacheDir) {
+    if (handle == nullptr) return XJPCG_STATUS_NOT_INITIALIZED;
+    auto pImpl = reinterpret_cast<PcgImpl*>(handle);
+    try {
+        pImpl->setSigCacheDir(cacheDir == nullptr ? "" : cacheDir);
+    } catch (const xilinx_apps::pcg::CgException& err) {
+        return pImpl->setStatusMessage(err.getStatus(), err.what());
+    } catch (const std::exception& err) {
+        return pImpl->setStatusMessage(XJPCG_STATUS_INTERNAL_ERROR, err.what());
+    }
+    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, "Set signature cache directory successfully");
+}
+
+XJPCG_Status_t xJPCG_setReorder(XJPCG_Handle_t* handle, const XJPCG_Reorder_t reorder) {
+    if (handle == nullptr) return XJPCG_STATUS_NOT_INITIALIZED;
+    auto pImpl = reinterpret_cast<PcgImpl*>(handle);
+    try {
+        switch (reorder) {
+            case XJPCG_REORDER_NONE:
+                pImpl->setReorder(xf::sparse::REORDER_NONE);
+                break;
+            case XJPCG_REORDER_RCM:
+                pImpl->setReorder(xf::sparse::REORDER_RCM);
+                break;
+            default:
+                throw xilinx_apps::pcg::CgInvalidValue("unknown reordering " + std::to_string(reorder) + ".");
+        }
+    } catch (const xilinx_apps::pcg::CgException& err) {
+        return pImpl->setStatusMessage(err.getStatus(), err.what());
+    } catch (const std::exception& err) {
+        return pImpl->setStatusMessage(XJPCG_STATUS_INTERNAL_ERROR, err.what());
+    }
+    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, "Set reordering successfully");
 }
 
 XJPCG_Status_t xJPCG_getMetrics(const XJPCG_Handle_t* handle, XJPCG_Metric_t* metric) {
@@ -179,6 +364,21 @@ XJPCG_Status_t xJPCG_getMetrics(const XJPCG_Handle_t* handle, XJPCG_Metric_t* me
     return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, "Get metrics successfully");
 }
 
+XJPCG_Status_t xJPCG_getConvergenceHistory(const XJPCG_Handle_t* handle,
+                                           XJPCG_Iteration_t* history,
+                                           const uint32_t maxEntries,
+                                           uint32_t* numEntries) {
+    if (handle == nullptr) return XJPCG_STATUS_NOT_INITIALIZED;
+    auto pImpl = reinterpret_cast<const PcgImpl*>(handle);
+    if (numEntries == nullptr || (history == nullptr && maxEntries != 0)) {
+        return pImpl->setStatusMessage(XJPCG_STATUS_INVALID_VALUE, "History is nullptr.");
+    }
+    const auto& l_history = pImpl->getHistory();
+    *numEntries = l_history.size();
+    std::copy(l_history.begin(), l_history.begin() + std::min<size_t>(maxEntries, l_history.size()), history);
+    return pImpl->setStatusMessage(XJPCG_STATUS_SUCCESS, "Get convergence history successfully");
+}
+
 XJPCG_Status_t xJPCG_peekAtLastStatus(const XJPCG_Handle_t* handle) {
     // No assert here; we should handle status for a null handle because it may have come that way out
     // of createHandle
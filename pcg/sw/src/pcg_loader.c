@@ -117,6 +117,36 @@ XJPCG_Status_t xJPCG_getMetrics(const XJPCG_Handle_t* handle, XJPCG_Metric_t* me
     return XJPCG_STATUS_DYNAMIC_LOADING_ERROR;
 }
 
+XILINX_PCG_LINKAGE_DEF
+XJPCG_Status_t xJPCG_getConvergenceHistory(const XJPCG_Handle_t* handle,
+                                           XJPCG_Iteration_t* history,
+                                           const uint32_t maxEntries,
+                                           uint32_t* numEntries) {
+    typedef XJPCG_Status_t (*GetConvergenceHistory)(const XJPCG_Handle_t*, XJPCG_Iteration_t*, const uint32_t,
+                                                    uint32_t*);
+    GetConvergenceHistory pGetConvergenceHistory =
+        (GetConvergenceHistory)xilinx_apps_getCDynamicFunction("xJPCG_getConvergenceHistory");
+    if (pGetConvergenceHistory) return pGetConvergenceHistory(handle, history, maxEntries, numEntries);
+    return XJPCG_STATUS_DYNAMIC_LOADING_ERROR;
+}
+
+XILINX_PCG_LINKAGE_DEF
+XJPCG_Status_t xJPCG_setSignatureCacheDir(XJPCG_Handle_t* handle, const char* cacheDir) {
+    typedef XJPCG_Status_t (*SetSignatureCacheDir)(XJPCG_Handle_t*, const char*);
+    SetSignatureCacheDir pSetSignatureCacheDir =
+        (SetSignatureCacheDir)xilinx_apps_getCDynamicFunction("xJPCG_setSignatureCacheDir");
+    if (pSetSignatureCacheDir) return pSetSignatureCacheDir(handle, cacheDir);
+    return XJPCG_STATUS_DYNAMIC_LOADING_ERROR;
+}
+
+XILINX_PCG_LINKAGE_DEF
+XJPCG_Status_t xJPCG_setReorder(XJPCG_Handle_t* handle, const XJPCG_Reorder_t reorder) {
+    typedef XJPCG_Status_t (*SetReorder)(XJPCG_Handle_t*, const XJPCG_Reorder_t);
+    SetReorder pSetReorder = (SetReorder)xilinx_apps_getCDynamicFunction("xJPCG_setReorder");
+    if (pSetReorder) return pSetReorder(handle, reorder);
+    return XJPCG_STATUS_DYNAMIC_LOADING_ERROR;
+}
+
 XILINX_PCG_LINKAGE_DEF
 XJPCG_Status_t xJPCG_peekAtLastStatus(const XJPCG_Handle_t* handle) {
     typedef XJPCG_Status_t (*PeekAtLastStatus)(const XJPCG_Handle_t*);
@@ -209,6 +239,56 @@ XJPCG_Status_t xJPCG_cooSolver(XJPCG_Handle_t* handle,
     return pApiFunc(handle, p_n, p_nnz, p_rowIdx, p_colIdx, p_data, matJ, b, x, p_maxIter, p_tol, p_iter, p_res, mode);
 }
 
+XILINX_PCG_LINKAGE_DEF
+XJPCG_Status_t xJPCG_stencilSolver(XJPCG_Handle_t* handle,
+                                   const XJPCG_Stencil_t p_stencil,
+                                   const uint32_t p_nx,
+                                   const uint32_t p_ny,
+                                   const uint32_t p_nz,
+                                   const double* p_coefs,
+                                   const int p_perCell,
+                                   const double* b,
+                                   const double* x,
+                                   const uint32_t p_maxIter,
+                                   const double p_tol,
+                                   uint32_t* p_iter,
+                                   double* p_res,
+                                   const XJPCG_Mode_t mode) {
+    typedef XJPCG_Status_t (*ApiFunc)(XJPCG_Handle_t*, const XJPCG_Stencil_t, uint32_t, uint32_t, uint32_t,
+                                      const double*, const int, const double*, const double*, const uint32_t,
+                                      const double, uint32_t*, double*, const XJPCG_Mode_t);
+    ApiFunc pApiFunc = (ApiFunc)xilinx_apps_getCDynamicFunction("xJPCG_stencilSolver");
+    if (!pApiFunc) return XJPCG_STATUS_DYNAMIC_LOADING_ERROR;
+    return pApiFunc(handle, p_stencil, p_nx, p_ny, p_nz, p_coefs, p_perCell, b, x, p_maxIter, p_tol, p_iter, p_res,
+                    mode);
+}
+
+XILINX_PCG_LINKAGE_DEF
+XJPCG_Status_t xJPCG_cooSolverBatch(XJPCG_Handle_t* handle,
+                                    const uint32_t p_numSys,
+                                    const uint32_t* p_n,
+                                    const uint32_t* p_nnz,
+                                    const uint32_t* const* p_rowIdx,
+                                    const uint32_t* const* p_colIdx,
+                                    const double* const* p_data,
+                                    const double* const* matJ,
+                                    const double* const* b,
+                                    double* const* x,
+                                    const uint32_t p_maxIter,
+                                    const double p_tol,
+                                    uint32_t* p_iter,
+                                    double* p_res,
+                                    const XJPCG_Mode_t mode) {
+    typedef XJPCG_Status_t (*ApiFunc)(XJPCG_Handle_t*, const uint32_t, const uint32_t*, const uint32_t*,
+                                      const uint32_t* const*, const uint32_t* const*, const double* const*,
+                                      const double* const*, const double* const*, double* const*, const uint32_t,
+                                      const double, uint32_t*, double*, const XJPCG_Mode_t);
+    ApiFunc pApiFunc = (ApiFunc)xilinx_apps_getCDynamicFunction("xJPCG_cooSolverBatch");
+    if (!pApiFunc) return XJPCG_STATUS_DYNAMIC_LOADING_ERROR;
+    return pApiFunc(handle, p_numSys, p_n, p_nnz, p_rowIdx, p_colIdx, p_data, matJ, b, x, p_maxIter, p_tol, p_iter,
+                    p_res, mode);
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -22,21 +22,24 @@
 #include <unistd.h>
 #include <vector>
 #include <chrono>
+#include <cmath>
 #include <cassert>
 
 #include "pcg.h"
 #include "sw/utils.hpp"
 #include "sw/fp64/matrix_params.hpp"
 #include "sw/fp64/gen_signature.hpp"
+#include "impl/cgStencil.hpp"
 
 #ifndef CG_dataType
 using CG_dataType = double;
 #endif
 
 int main(int argc, char** argv) {
-    if (argc < 6 || argc > 8) {
-        std::cout << "Usage: " << argv[0] << " <XCLBIN File> <Max Iteration> <Tolerence> <data_path> "
-                                             "<mtx_name> <number_of_runs> [--debug] [device id]"
+    if (argc < 6 || argc > 14) {
+        std::cout << "Usage: " << argv[0] << " <XCLBIN File|cpu> <Max Iteration> <Tolerence> <data_path> "
+                                             "<mtx_name> <number_of_runs> [--debug] [--rcm] [--stencil] [--batch] "
+                                             "[--warm] [--vec] [device id]"
                   << std::endl;
         return EXIT_FAILURE;
     }
@@ -48,10 +51,25 @@ int main(int argc, char** argv) {
     std::string l_mtxName = argv[l_idx++];
     int l_numRuns = atoi(argv[l_idx++]);
     bool l_debug = false;
-    if (argc > l_idx) {
+    bool l_rcm = false;
+    bool l_stencil = false;
+    bool l_batch = false;
+    bool l_warm = false;
+    bool l_vec = false;
+    while (argc > l_idx) {
         std::string l_option = argv[l_idx++];
         if (l_option == "--debug")
             l_debug = true;
+        else if (l_option == "--rcm")
+            l_rcm = true;
+        else if (l_option == "--stencil")
+            l_stencil = true;
+        else if (l_option == "--batch")
+            l_batch = true;
+        else if (l_option == "--warm")
+            l_warm = true;
+        else if (l_option == "--vec")
+            l_vec = true;
     }
 
     std::string l_datFilePath = l_datPath + "/" + l_mtxName;
@@ -86,7 +104,7 @@ int main(int argc, char** argv) {
 
     l_stat = xJPCG_createHandle(&pHandle, binaryFile.c_str());
     assert(l_stat == XJPCG_STATUS_SUCCESS);
-    xJPCG_cooSolver(pHandle, 0, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(), l_data.data(),
+    l_stat = xJPCG_cooSolver(pHandle, 0, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(), l_data.data(),
         l_diagA.data(), l_b.data(), l_x.data(), l_maxIter, l_tolerance, &numIterations, &residual,  XJPCG_MODE_DEFAULT);
     assert(l_stat == XJPCG_STATUS_INVALID_VALUE);
 
@@ -101,6 +119,18 @@ int main(int argc, char** argv) {
     /******************/
     /* solver tests */
     /******************/
+    int err = 0;
+    // the return codes of the optional cases are counted as failures, so that release builds check them too
+    auto l_checkStat = [&](const std::string& p_case) {
+        if (l_stat != XJPCG_STATUS_SUCCESS) {
+            std::cout << "ERROR: " << p_case << " failed, " << xJPCG_getLastMessage(pHandle) << std::endl;
+            err++;
+        }
+    };
+    if (l_rcm) {
+        l_stat = xJPCG_setReorder(pHandle, XJPCG_REORDER_RCM);
+        l_checkStat("setReorder");
+    }
     l_stat = xJPCG_cooSolver(pHandle, l_matInfo.m_m, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(), l_data.data(),
         l_diagA.data(), l_b.data(), l_x.data(), l_maxIter, l_tolerance, &numIterations, &residual,  XJPCG_MODE_DEFAULT);
     assert(l_stat == XJPCG_STATUS_SUCCESS);
@@ -111,19 +141,254 @@ int main(int argc, char** argv) {
         assert(l_stat == XJPCG_STATUS_SUCCESS);
     }
 
-    int err = 0;
     readBin(l_datFilePath + "/x.mat", h_x.data(), l_matInfo.m_m * sizeof(CG_dataType));
     compare<CG_dataType>(l_matInfo.m_m, h_x.data(), l_x.data(), err, l_debug);
 
     XJPCG_Metric_t metric;
     xJPCG_getMetrics(pHandle, &metric);
+
+    // the last entry of the history is the residual returned by the solver
+    uint32_t l_numEntries = 0;
+    l_stat = xJPCG_getConvergenceHistory(pHandle, nullptr, 0, &l_numEntries);
+    l_checkStat("convergence history");
+    std::vector<XJPCG_Iteration_t> l_history(l_numEntries);
+    l_stat = xJPCG_getConvergenceHistory(pHandle, l_history.data(), l_numEntries, &l_numEntries);
+    l_checkStat("convergence history");
+    if (l_numEntries == 0 || l_history.back().m_residual != residual) {
+        std::cout << "ERROR: convergence history does not match the solver residual." << std::endl;
+        err++;
+    }
+    uint64_t l_cycles = 0;
+    for (const auto& l_entry : l_history) l_cycles += l_entry.m_cycles;
+    std::cout << "Convergence history: " << l_numEntries << " iterations, " << l_cycles << " cycles" << std::endl;
+
+    // the next time step of a slowly changing b, solved from the last solution and checked against 1.001 * x.mat
+    if (l_warm) {
+        std::vector<CG_dataType> l_wb(l_b), l_wx(l_x), l_wRef(h_x);
+        for (auto& l_val : l_wb) l_val *= 1.001;
+        for (auto& l_val : l_wRef) l_val *= 1.001;
+        uint32_t l_wIter = 0;
+        double l_wRes = 0;
+        l_stat = xJPCG_cooSolver(pHandle, l_matInfo.m_m, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(),
+                                 l_data.data(), l_diagA.data(), l_wb.data(), l_wx.data(), l_maxIter, l_tolerance,
+                                 &l_wIter, &l_wRes, (XJPCG_Mode_t)(XJPCG_MODE_KEEP_MATRIX | XJPCG_MODE_WARM_START));
+        l_checkStat("warm start");
+        std::cout << "Warm start: " << l_wIter << " iterations, " << numIterations << " without warm start"
+                  << std::endl;
+        compare<CG_dataType>(l_matInfo.m_m, l_wRef.data(), l_wx.data(), err, l_debug);
+
+        // the converged solution already meets tol, the solver returns it without iterating; the true residual
+        // of l_wx can be slightly above the recurrence one, hence the margin
+        std::vector<CG_dataType> l_cx(l_wx);
+        const double l_cTol = l_tolerance * 10;
+        l_stat = xJPCG_cooSolver(pHandle, l_matInfo.m_m, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(),
+                                 l_data.data(), l_diagA.data(), l_wb.data(), l_cx.data(), l_maxIter, l_cTol,
+                                 &l_wIter, &l_wRes, (XJPCG_Mode_t)(XJPCG_MODE_KEEP_MATRIX | XJPCG_MODE_WARM_START));
+        l_checkStat("warm start");
+        uint32_t l_cEntries = 1;
+        xJPCG_getConvergenceHistory(pHandle, nullptr, 0, &l_cEntries);
+        if (l_wIter != 0 || l_cEntries != 0 || !(l_wRes <= l_cTol) || l_cx != l_wx) {
+            std::cout << "ERROR: warm start from a converged solution ran " << l_wIter << " iterations, residual "
+                      << l_wRes << std::endl;
+            err++;
+        }
+
+        // b = 0 is solved exactly by x = 0, also from a non-zero initial guess
+        std::vector<CG_dataType> l_zb(l_matInfo.m_m, 0), l_zx(l_wx);
+        l_stat = xJPCG_cooSolver(pHandle, l_matInfo.m_m, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(),
+                                 l_data.data(), l_diagA.data(), l_zb.data(), l_zx.data(), l_maxIter, l_tolerance,
+                                 &l_wIter, &l_wRes, (XJPCG_Mode_t)(XJPCG_MODE_KEEP_MATRIX | XJPCG_MODE_WARM_START));
+        l_checkStat("zero right-hand side");
+        if (l_wIter != 0 || l_wRes != 0 || l_zx != l_zb) {
+            std::cout << "ERROR: zero right-hand side ran " << l_wIter << " iterations, residual " << l_wRes
+                      << std::endl;
+            err++;
+        }
+    }
+    // same-dim solves only upload the changed vectors, jacobi included when diag changes with the matrix kept
+    if (l_vec) {
+        XJPCG_Metric_t l_vMetric;
+        std::vector<CG_dataType> l_vb(l_b), l_vx(l_matInfo.m_m), l_vRef(h_x);
+        uint32_t l_vIter = 0;
+        double l_vRes = 0;
+        l_stat = xJPCG_cooSolver(pHandle, l_matInfo.m_m, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(),
+                                 l_data.data(), l_diagA.data(), l_vb.data(), l_vx.data(), l_maxIter, l_tolerance,
+                                 &l_vIter, &l_vRes, XJPCG_MODE_DEFAULT);
+        l_checkStat("vector update");
+        xJPCG_getMetrics(pHandle, &l_vMetric);
+        const double l_defaultVec = l_vMetric.m_vecProc;
+
+        for (auto& l_val : l_vb) l_val *= 1.001;
+        for (auto& l_val : l_vRef) l_val *= 1.001;
+        l_stat = xJPCG_cooSolver(pHandle, l_matInfo.m_m, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(),
+                                 l_data.data(), l_diagA.data(), l_vb.data(), l_vx.data(), l_maxIter, l_tolerance,
+                                 &l_vIter, &l_vRes, XJPCG_MODE_KEEP_MATRIX);
+        l_checkStat("vector update");
+        xJPCG_getMetrics(pHandle, &l_vMetric);
+        std::cout << "Vector processing: " << l_defaultVec << " s default, " << l_vMetric.m_vecProc
+                  << " s with the matrix kept" << std::endl;
+        compare<CG_dataType>(l_matInfo.m_m, l_vRef.data(), l_vx.data(), err, l_debug);
+
+        // the first alpha of a solve from x0 = 0 is b.z / z.Az with z = b / diag, so it shows which jacobi was used
+        auto l_alphaErr = [&](const std::vector<CG_dataType>& p_diag) {
+            std::vector<CG_dataType> l_z(l_matInfo.m_m), l_az(l_matInfo.m_m, 0);
+            double l_bz = 0, l_zaz = 0;
+            for (uint32_t i = 0; i < l_matInfo.m_m; ++i) {
+                l_z[i] = l_b[i] / p_diag[i];
+                l_bz += l_b[i] * l_z[i];
+            }
+            for (uint32_t k = 0; k < l_matInfo.m_nnz; ++k) l_az[l_rowIdx[k]] += l_data[k] * l_z[l_colIdx[k]];
+            for (uint32_t i = 0; i < l_matInfo.m_m; ++i) l_zaz += l_z[i] * l_az[i];
+            XJPCG_Iteration_t l_first;
+            uint32_t l_entries = 0;
+            xJPCG_getConvergenceHistory(pHandle, &l_first, 1, &l_entries);
+            return l_entries == 0 ? 1.0 : std::abs(l_first.m_alpha - l_bz / l_zaz) / std::abs(l_bz / l_zaz);
+        };
+        std::vector<CG_dataType> l_vDiag(l_diagA);
+        for (uint32_t i = 0; i < l_matInfo.m_m; i += 2) l_vDiag[i] *= 2;
+        uint32_t l_keepIter = 0;
+        l_stat = xJPCG_cooSolver(pHandle, l_matInfo.m_m, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(),
+                                 l_data.data(), l_vDiag.data(), l_b.data(), l_vx.data(), l_maxIter, l_tolerance,
+                                 &l_keepIter, &l_vRes, XJPCG_MODE_KEEP_MATRIX);
+        l_checkStat("vector update");
+        compare<CG_dataType>(l_matInfo.m_m, h_x.data(), l_vx.data(), err, l_debug);
+        const double l_newErr = l_alphaErr(l_vDiag);
+        // and going back to the original diag under the kept matrix repeats the first solve
+        l_stat = xJPCG_cooSolver(pHandle, l_matInfo.m_m, l_matInfo.m_nnz, l_rowIdx.data(), l_colIdx.data(),
+                                 l_data.data(), l_diagA.data(), l_b.data(), l_vx.data(), l_maxIter, l_tolerance,
+                                 &l_vIter, &l_vRes, XJPCG_MODE_KEEP_MATRIX);
+        l_checkStat("vector update");
+        const double l_oldErr = l_alphaErr(l_diagA);
+        std::cout << "Jacobi refresh: " << l_keepIter << " iterations on the new diag, " << l_vIter
+                  << " back on the original one" << std::endl;
+        if (l_newErr > 1e-8 || l_oldErr > 1e-8 || l_vIter != numIterations) {
+            std::cout << "ERROR: jacobi was not refreshed when diag changed, first alpha off by " << l_newErr
+                      << " and " << l_oldErr << std::endl;
+            err++;
+        }
+    }
+    // system i is (i + 1) * A x = b, its solution scaled by i + 1 is checked against x.mat
+    if (l_batch) {
+        const uint32_t l_numSys = 3;
+        std::vector<uint32_t> l_n(l_numSys, l_matInfo.m_m), l_nnz(l_numSys, l_matInfo.m_nnz), l_bIter(l_numSys);
+        std::vector<std::vector<CG_dataType> > l_bData(l_numSys), l_bDiag(l_numSys), l_bX(l_numSys);
+        std::vector<const uint32_t*> l_bRow(l_numSys, l_rowIdx.data()), l_bCol(l_numSys, l_colIdx.data());
+        std::vector<const double*> l_bDataPtr(l_numSys), l_bDiagPtr(l_numSys), l_bB(l_numSys, l_b.data());
+        std::vector<double*> l_bXPtr(l_numSys);
+        std::vector<double> l_bRes(l_numSys);
+        for (uint32_t i = 0; i < l_numSys; ++i) {
+            l_bData[i] = l_data;
+            l_bDiag[i] = l_diagA;
+            l_bX[i].resize(l_matInfo.m_m);
+            for (auto& l_val : l_bData[i]) l_val *= i + 1;
+            for (auto& l_val : l_bDiag[i]) l_val *= i + 1;
+            l_bDataPtr[i] = l_bData[i].data();
+            l_bDiagPtr[i] = l_bDiag[i].data();
+            l_bXPtr[i] = l_bX[i].data();
+        }
+        l_stat = xJPCG_cooSolverBatch(pHandle, l_numSys, l_n.data(), l_nnz.data(), l_bRow.data(), l_bCol.data(),
+                                      l_bDataPtr.data(), l_bDiagPtr.data(), l_bB.data(), l_bXPtr.data(), l_maxIter,
+                                      l_tolerance, l_bIter.data(), l_bRes.data(), XJPCG_MODE_DEFAULT);
+        l_checkStat("batch solver");
+        for (uint32_t i = 0; i < l_numSys; ++i) {
+            for (auto& l_val : l_bX[i]) l_val *= i + 1;
+            std::cout << "Batch system " << i << ": " << l_bIter[i] << " iterations, residual " << l_bRes[i]
+                      << std::endl;
+            compare<CG_dataType>(l_matInfo.m_m, h_x.data(), l_bX[i].data(), err, l_debug);
+        }
+    }
+    // the reordering is switched on the same handle, for the loaded matrix and for its leading half; each solve is
+    // checked by its true residual, so that the perms of an earlier partition can't leak into the next one
+    if (l_rcm) {
+        const uint32_t l_half = l_matInfo.m_m / 2;
+        std::vector<uint32_t> l_hRow, l_hCol;
+        std::vector<CG_dataType> l_hData;
+        for (uint32_t k = 0; k < l_matInfo.m_nnz; ++k) {
+            if (l_rowIdx[k] < l_half && l_colIdx[k] < l_half) {
+                l_hRow.push_back(l_rowIdx[k]);
+                l_hCol.push_back(l_colIdx[k]);
+                l_hData.push_back(l_data[k]);
+            }
+        }
+        const XJPCG_Reorder_t l_steps[] = {XJPCG_REORDER_RCM, XJPCG_REORDER_NONE, XJPCG_REORDER_RCM,
+                                           XJPCG_REORDER_NONE, XJPCG_REORDER_RCM, XJPCG_REORDER_NONE};
+        for (uint32_t s = 0; s < sizeof(l_steps) / sizeof(l_steps[0]); ++s) {
+            // the loaded matrix for the first three steps, then its leading half and back
+            const bool l_full = (s < 3) || (s == 5);
+            const uint32_t l_rN = l_full ? l_matInfo.m_m : l_half;
+            const std::vector<uint32_t>& l_rRow = l_full ? l_rowIdx : l_hRow;
+            const std::vector<uint32_t>& l_rCol = l_full ? l_colIdx : l_hCol;
+            const std::vector<CG_dataType>& l_rData = l_full ? l_data : l_hData;
+            std::vector<CG_dataType> l_rx(l_rN), l_ax(l_rN, 0);
+            uint32_t l_rIter = 0;
+            double l_rRes = 0;
+            l_stat = xJPCG_setReorder(pHandle, l_steps[s]);
+            if (l_stat == XJPCG_STATUS_SUCCESS) {
+                l_stat = xJPCG_cooSolver(pHandle, l_rN, l_rData.size(), l_rRow.data(), l_rCol.data(), l_rData.data(),
+                                         l_diagA.data(), l_b.data(), l_rx.data(), l_maxIter, l_tolerance, &l_rIter,
+                                         &l_rRes, XJPCG_MODE_DEFAULT);
+            }
+            for (uint32_t k = 0; k < l_rData.size(); ++k) l_ax[l_rRow[k]] += l_rData[k] * l_rx[l_rCol[k]];
+            double l_rr = 0, l_bb = 0;
+            for (uint32_t i = 0; i < l_rN; ++i) {
+                l_rr += (l_b[i] - l_ax[i]) * (l_b[i] - l_ax[i]);
+                l_bb += l_b[i] * l_b[i];
+            }
+            const double l_trueRes = std::sqrt(l_rr / l_bb);
+            std::cout << "Reorder " << (l_steps[s] == XJPCG_REORDER_RCM ? "rcm" : "none") << " dim " << l_rN << ": "
+                      << l_rIter << " iterations, true residual " << l_trueRes << std::endl;
+            if (l_stat != XJPCG_STATUS_SUCCESS || !(l_trueRes <= 10 * l_tolerance)) {
+                std::cout << "ERROR: reorder switch failed, " << xJPCG_getLastMessage(pHandle) << std::endl;
+                err++;
+            }
+        }
+    }
+    // 7-point Laplacian on a 32^3 grid, checked against the host reference solver and by the true residual of the
+    // reference operator; it replaces the loaded matrix, so it runs after the cases that keep it
+    if (l_stencil) {
+        const uint32_t l_n = 32, l_dim = l_n * l_n * l_n;
+        const double l_coefs[7] = {6, -1, -1, -1, -1, -1, -1};
+        xilinx_apps::pcg::StencilOp<double> l_op(XJPCG_STENCIL_7PT, l_n, l_n, l_n, l_coefs, false);
+        std::vector<double> l_sb(l_dim, 1), l_sx(l_dim), l_sDiag(l_dim), l_refX(l_dim), l_ax(l_dim);
+        l_op.getDiag(l_sDiag.data());
+        uint32_t l_sIter = 0;
+        double l_sRes = 0;
+        l_stat = xJPCG_stencilSolver(pHandle, XJPCG_STENCIL_7PT, l_n, l_n, l_n, l_coefs, 0, l_sb.data(), l_sx.data(),
+                                     l_maxIter, l_tolerance, &l_sIter, &l_sRes, XJPCG_MODE_DEFAULT);
+        l_checkStat("stencil solver");
+        double l_refRes = 0;
+        uint32_t l_refIter = xilinx_apps::pcg::refJPCG(l_op, l_dim, l_sDiag.data(), l_sb.data(), l_refX.data(),
+                                                       l_maxIter, l_tolerance, l_refRes);
+        compare<CG_dataType>(l_dim, l_refX.data(), l_sx.data(), err, l_debug);
+        l_op.apply(l_sx.data(), l_ax.data());
+        double l_rr = 0, l_bb = 0;
+        for (uint32_t i = 0; i < l_dim; ++i) {
+            l_rr += (l_sb[i] - l_ax[i]) * (l_sb[i] - l_ax[i]);
+            l_bb += l_sb[i] * l_sb[i];
+        }
+        double l_relRes = std::sqrt(l_rr / l_bb);
+        std::cout << "Stencil solver: " << l_sIter << " iterations, residual " << l_relRes << ", reference "
+                  << l_refIter << " iterations" << std::endl;
+        if (l_relRes > 2 * l_tolerance) {
+            err++;
+        }
+
+        // keeping the matrix for another grid is rejected before the vectors are read
+        std::vector<double> l_bigB(2 * l_dim, 1), l_bigX(2 * l_dim);
+        l_stat = xJPCG_stencilSolver(pHandle, XJPCG_STENCIL_7PT, 2 * l_n, l_n, l_n, l_coefs, 0, l_bigB.data(),
+                                     l_bigX.data(), l_maxIter, l_tolerance, &l_sIter, &l_sRes, XJPCG_MODE_KEEP_MATRIX);
+        if (l_stat != XJPCG_STATUS_INVALID_VALUE) {
+            std::cout << "ERROR: stencil solver kept the matrix for a different grid." << std::endl;
+            err++;
+        }
+    }
     xJPCG_destroyHandle(pHandle);
 
-    std::cout << "DATA_CSV:, matrix_name, dim, NNZs, num of iterations, JPCG residual, num_mismatches, solver time [s]" << std::endl;
+    std::cout << "DATA_CSV:, matrix_name, dim, NNZs, num of iterations, JPCG residual, num_mismatches, solver time [s], reordering" << std::endl;
     std::cout << "DATA_CSV:, " << l_matInfo.m_name << ", " << l_matInfo.m_m << ", ";
     std::cout << l_matInfo.m_nnz << ", " << numIterations << ", ";
     std::cout << residual  << ", " << err << ", ";
-    std::cout << metric.m_solver << std::endl;
+    std::cout << metric.m_solver << ", " << (l_rcm ? "rcm" : "none") << std::endl;
     
     
     if ((err == 0) || (numIterations == uint32_t(l_maxIter))){
@@ -27,41 +27,45 @@ function usage() {
     echo "  -o output-dir  : Directory to which to write test data.  Defaults to ./data"
     echo "  -r results-dir : Directory to which to write test results.  Defaults to ./results"
     echo "  -d device-id   : The device number of the Alveo card to use.  Defaults to 1"
+    echo "  -c             : Run on the host instead of the Alveo card, with and without the --rcm --stencil"
+    echo "                   --batch --warm --vec options of pcgtest"
     echo "  -h             : Print this help message"
 }
 
-# Set up XRT
-
-xrtPath=$XILINX_XRT
-if [ "$xrtPath" == "" ]; then
-    $xrtPath=/opt/xilinx/xrt
-fi
-if [ ! -d $xrtPath ]; then
-    echo "ERROR: XRT not found.  Please install XRT or set $$XILINX_XRT to the location of XRT."
-    exit 1
-fi
-
-. $xrtPath/setup.sh
-
 # Process command line options
 
 dataFile=./test.txt
 dataOutPath=./data
 resultsPath=./results
 deviceId=1
+useCpu=0
 
-while getopts ":f:o:r:d:h" opt
+while getopts ":f:o:r:d:ch" opt
 do
 case $opt in
     f) dataFile=$OPTARG;;
     o) dataOutPath=$OPTARG;;
     r) resultsPath=$OPTARG;;
     d) deviceId=$OPTARG;;
+    c) useCpu=1;;
     h) usage; exit 0;;
     ?) echo "ERROR: Unknown option: -$OPTARG"; usage; exit 1;;
 esac
 done
 
+# Set up XRT, the host runs only need it if the library was linked against it
+
+xrtPath=$XILINX_XRT
+if [ "$xrtPath" == "" ]; then
+    xrtPath=/opt/xilinx/xrt
+fi
+if [ -d $xrtPath ]; then
+    . $xrtPath/setup.sh
+elif [ $useCpu -eq 0 ]; then
+    echo "ERROR: XRT not found.  Please install XRT or set \$XILINX_XRT to the location of XRT."
+    exit 1
+fi
+
 # Download and prepare the data
 
 $SCRIPTPATH/../utils/genMat.sh -f $dataFile -o $dataOutPath
@@ -73,6 +77,17 @@ mkdir -p $resultsPath
 binPath=$SCRIPTPATH/../Release
 export LD_LIBRARY_PATH=$binPath:$LD_LIBRARY_PATH
 
+if [ $useCpu -eq 1 ]; then
+    xclbinFile=cpu
+    testOptions=("" "--rcm --stencil --batch --warm --vec")
+    csvName=perf_pcg_cpu.csv
+else
+    xclbinFile=$SCRIPTPATH/../staging/xclbin/pcg_xilinx_u280_xdma_201920_3.xclbin
+    testOptions=("")
+    csvName=perf_pcg_fpga.csv
+fi
+
+failed=""
 file="$dataFile"
 while read -r line; do
   if [ "$line" == "" ]; then
@@ -81,12 +96,20 @@ while read -r line; do
   name="$line"
   filename=$(basename -- $name)
   mtxname=${filename%%.*}
-  echo "=======Running $mtxname=========="
-  logname=$resultsPath/$mtxname.log
-  $binPath/pcgtest $SCRIPTPATH/../staging/xclbin/pcg_xilinx_u280_xdma_201920_3.xclbin \
-        5000 1e-12 $dataOutPath $mtxname 1 $deviceId |& tee $logname
+  for options in "${testOptions[@]}"; do
+    echo "=======Running $mtxname $options=========="
+    logname=$resultsPath/$mtxname$(echo $options | tr -d ' -' | sed 's/^./_&/').log
+    if ! (set -o pipefail; $binPath/pcgtest $xclbinFile 5000 1e-12 $dataOutPath $mtxname 1 $options $deviceId \
+          |& tee $logname); then
+        failed="$failed [$mtxname $options]"
+    fi
+  done
 done < "$file"
 
-egrep -h ^DATA_CSV $resultsPath/*.log | grep matrix_name | head -1 > $resultsPath/perf_pcg_fpga.csv
-egrep -h ^DATA_CSV $resultsPath/*.log | grep -v matrix_name >> $resultsPath/perf_pcg_fpga.csv
-echo "Results are in $resultsPath/perf_pcg_fpga.csv"
+egrep -h ^DATA_CSV $resultsPath/*.log | grep matrix_name | head -1 > $resultsPath/$csvName
+egrep -h ^DATA_CSV $resultsPath/*.log | grep -v matrix_name >> $resultsPath/$csvName
+echo "Results are in $resultsPath/$csvName"
+if [ "$failed" != "" ]; then
+    echo "ERROR: failed tests:$failed"
+    exit 1
+fi
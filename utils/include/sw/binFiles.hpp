@@ -36,6 +36,11 @@
 #include <vector>
 #include <fstream>
 #include <cassert>
+#include <cstdint>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 inline
 size_t getBinBytes(const std::string filename) {
@@ -159,4 +164,64 @@ void saveBin(std::string name, void* mat, unsigned int totalSize) {
     std::ofstream outFile(name, std::ios::binary);
     outFile.write((char*)mat, totalSize);
 }
+
+// private read/write mapping of a binary file. data() is page aligned (4K) and can be handed to
+// createBOfromHostPtr directly, pages are read from disk when they are first touched and writes never reach the
+// file. The mapping is released when the object is destroyed.
+class MappedBinFile {
+   public:
+    MappedBinFile() = default;
+    explicit MappedBinFile(const std::string filename) { open(filename); }
+    MappedBinFile(const MappedBinFile&) = delete;
+    MappedBinFile& operator=(const MappedBinFile&) = delete;
+    MappedBinFile(MappedBinFile&& p_file) : m_ptr(p_file.m_ptr), m_bytes(p_file.m_bytes) {
+        p_file.m_ptr = nullptr;
+        p_file.m_bytes = 0;
+    }
+    ~MappedBinFile() { close(); }
+
+    bool open(const std::string filename) {
+        close();
+        int l_fd = ::open(filename.c_str(), O_RDONLY);
+        if (l_fd < 0) {
+            std::cerr << "Could not find " << filename << std::endl;
+            return false;
+        }
+        struct stat l_stat;
+        if (fstat(l_fd, &l_stat) != 0) {
+            ::close(l_fd);
+            std::cerr << "Could not read size of " << filename << std::endl;
+            return false;
+        }
+        m_bytes = l_stat.st_size;
+        if (m_bytes > 0) {
+            m_ptr = mmap(nullptr, m_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, l_fd, 0);
+            if (m_ptr == MAP_FAILED) {
+                m_ptr = nullptr;
+                m_bytes = 0;
+                ::close(l_fd);
+                std::cerr << "Could not map " << filename << std::endl;
+                return false;
+            }
+            assert(reinterpret_cast<uintptr_t>(m_ptr) % 4096 == 0);
+        }
+        ::close(l_fd);
+        return true;
+    }
+
+    void close() {
+        if (m_ptr != nullptr) {
+            munmap(m_ptr, m_bytes);
+        }
+        m_ptr = nullptr;
+        m_bytes = 0;
+    }
+
+    void* data() { return m_ptr; }
+    size_t size() const { return m_bytes; }
+
+   private:
+    void* m_ptr = nullptr;
+    size_t m_bytes = 0;
+};
 #endif